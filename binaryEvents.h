@@ -0,0 +1,229 @@
+/**
+ * @file binaryEvents.h
+ * @brief Fixed-layout binary schema for normalized market and order events.
+ *
+ * This file defines the wire format shared by every consumer of decoded events (the
+ * shared-memory publisher, the local gateway's binary mode and external readers), so
+ * JSON is parsed once, at the edge. Events are plain structs written in host byte
+ * order, which must be little-endian; every layout is pinned by static_asserts.
+ * The header has no dependencies, so external readers can include it on its own.
+ */
+
+#ifndef BINARYEVENTS_H
+#define BINARYEVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "binary events are little-endian on the wire");
+static_assert(sizeof(double) == 8, "binary events need IEEE-754 doubles");
+
+namespace binaryEvents {
+
+    constexpr uint8_t kSchemaVersion = 1; ///< Version carried in every header; bump on any layout change.
+    constexpr size_t kMaxEventSize = 176; ///< Size of the largest event.
+    constexpr uint64_t kOutOfBand = UINT64_MAX; ///< Sequence of events outside the numbered stream (directory snapshots).
+
+    /**
+     * @brief Type of an event.
+     */
+    enum class eventType : uint8_t {
+        instrument = 1,   ///< Defines the name of an instrument ID; precedes its first use.
+        bookLevel = 2,    ///< One price level of an order book snapshot or change.
+        topOfBook = 3,    ///< Best bid and ask with amounts.
+        trade = 4,        ///< One public trade.
+        ticker = 5,       ///< Ticker summary.
+        orderUpdate = 6   ///< State change of one of our orders.
+    };
+
+    /**
+     * @brief Header common to all events.
+     */
+    struct eventHeader {
+        uint16_t size;                ///< Size of the whole event in bytes, header included.
+        uint8_t version;              ///< kSchemaVersion.
+        eventType type;               ///< Event type.
+        uint32_t instrumentId;        ///< Dense instrument ID, defined by an `instrument` event.
+        uint64_t sequence;            ///< Per-producer sequence number; gaps mean lost events.
+        int64_t exchangeTimestampNs;  ///< Exchange timestamp in nanoseconds since the epoch, 0 if unknown.
+        int64_t receiveTimestampNs;   ///< Local receive time in nanoseconds since the epoch.
+    };
+
+    /**
+     * @brief Defines the name of an instrument ID.
+     */
+    struct instrumentEvent {
+        eventHeader header;  ///< Header; type is `instrument`.
+        char name[64];       ///< NUL-terminated instrument name.
+    };
+
+    /**
+     * @brief Side of a book level or trade.
+     */
+    enum class side : uint8_t {
+        none = 0,  ///< Not applicable or unknown.
+        bid = 1,   ///< Bid side (for trades: buyer was the aggressor).
+        ask = 2    ///< Ask side (for trades: seller was the aggressor).
+    };
+
+    /**
+     * @brief What happened to a book level.
+     */
+    enum class levelAction : uint8_t {
+        added = 1,    ///< New price level.
+        changed = 2,  ///< Amount at an existing level changed.
+        deleted = 3   ///< Level removed; amount is 0.
+    };
+
+    constexpr uint8_t kBookSnapshot = 1; ///< bookLevelEvent flag: the level belongs to a full snapshot.
+    constexpr uint8_t kBookLast = 2;     ///< bookLevelEvent flag: last level of its book message.
+
+    /**
+     * @brief One price level of an order book snapshot or change.
+     */
+    struct bookLevelEvent {
+        eventHeader header;      ///< Header; type is `bookLevel`.
+        double price;            ///< Level price.
+        double amount;           ///< Amount at the level after the change.
+        int64_t changeId;        ///< Exchange change ID of the book message.
+        int64_t prevChangeId;    ///< Previous change ID, 0 for snapshots.
+        side levelSide;          ///< Bid or ask.
+        levelAction action;      ///< What happened to the level.
+        uint8_t flags;           ///< kBookSnapshot, kBookLast.
+        uint8_t reserved[5];     ///< Zero.
+    };
+
+    /**
+     * @brief Best bid and ask with amounts.
+     */
+    struct topOfBookEvent {
+        eventHeader header;  ///< Header; type is `topOfBook`.
+        double bidPrice;     ///< Best bid price, NaN if none.
+        double bidAmount;    ///< Best bid amount.
+        double askPrice;     ///< Best ask price, NaN if none.
+        double askAmount;    ///< Best ask amount.
+    };
+
+    /**
+     * @brief One public trade.
+     */
+    struct tradeEvent {
+        eventHeader header;  ///< Header; type is `trade`.
+        double price;        ///< Trade price.
+        double amount;       ///< Trade amount.
+        int64_t tradeSeq;    ///< Exchange trade sequence number per instrument.
+        side aggressor;      ///< Aggressor side.
+        uint8_t reserved[7]; ///< Zero.
+    };
+
+    /**
+     * @brief Ticker summary.
+     */
+    struct tickerEvent {
+        eventHeader header;     ///< Header; type is `ticker`.
+        double bidPrice;        ///< Best bid price.
+        double bidAmount;       ///< Best bid amount.
+        double askPrice;        ///< Best ask price.
+        double askAmount;       ///< Best ask amount.
+        double lastPrice;       ///< Last traded price.
+        double markPrice;       ///< Mark price.
+        double indexPrice;      ///< Index price.
+        double openInterest;    ///< Open interest.
+    };
+
+    /**
+     * @brief Exchange state of an order.
+     */
+    enum class orderStatus : uint8_t {
+        unknown = 0,      ///< Not recognized.
+        open = 1,         ///< Working.
+        filled = 2,       ///< Completely filled.
+        cancelled = 3,    ///< Cancelled.
+        rejected = 4,     ///< Rejected.
+        untriggered = 5   ///< Conditional order waiting for its trigger.
+    };
+
+    /**
+     * @brief State change of one of our orders.
+     */
+    struct orderUpdateEvent {
+        eventHeader header;    ///< Header; type is `orderUpdate`.
+        char orderId[32];      ///< NUL-terminated exchange order ID.
+        char label[64];        ///< NUL-terminated order label.
+        double price;          ///< Limit price, NaN for market orders.
+        double amount;         ///< Order amount.
+        double filledAmount;   ///< Filled amount.
+        double averagePrice;   ///< Average fill price, NaN if unfilled.
+        double reserved0;      ///< Zero.
+        orderStatus status;    ///< Exchange state.
+        side direction;        ///< Bid for buy, ask for sell.
+        uint8_t reserved[6];   ///< Zero.
+    };
+
+    // Layouts are part of the wire format: any change here needs a new kSchemaVersion
+    static_assert(sizeof(eventHeader) == 32, "eventHeader layout changed");
+    static_assert(offsetof(eventHeader, instrumentId) == 4, "eventHeader layout changed");
+    static_assert(offsetof(eventHeader, sequence) == 8, "eventHeader layout changed");
+    static_assert(offsetof(eventHeader, receiveTimestampNs) == 24, "eventHeader layout changed");
+    static_assert(sizeof(instrumentEvent) == 96, "instrumentEvent layout changed");
+    static_assert(sizeof(bookLevelEvent) == 72, "bookLevelEvent layout changed");
+    static_assert(offsetof(bookLevelEvent, levelSide) == 64, "bookLevelEvent layout changed");
+    static_assert(sizeof(topOfBookEvent) == 64, "topOfBookEvent layout changed");
+    static_assert(sizeof(tradeEvent) == 64, "tradeEvent layout changed");
+    static_assert(offsetof(tradeEvent, aggressor) == 56, "tradeEvent layout changed");
+    static_assert(sizeof(tickerEvent) == 96, "tickerEvent layout changed");
+    static_assert(sizeof(orderUpdateEvent) == kMaxEventSize, "orderUpdateEvent layout changed");
+    static_assert(offsetof(orderUpdateEvent, price) == 128, "orderUpdateEvent layout changed");
+    static_assert(offsetof(orderUpdateEvent, status) == 168, "orderUpdateEvent layout changed");
+    static_assert(std::is_trivially_copyable<orderUpdateEvent>::value && std::is_standard_layout<orderUpdateEvent>::value,
+                  "events must be plain data");
+    static_assert(std::is_trivially_copyable<bookLevelEvent>::value && std::is_standard_layout<bookLevelEvent>::value,
+                  "events must be plain data");
+    static_assert(std::is_trivially_copyable<tickerEvent>::value && std::is_standard_layout<tickerEvent>::value,
+                  "events must be plain data");
+
+    /**
+     * @brief Finds the next event in a buffer of concatenated events.
+     *
+     * @param cursor The read position; advanced past the event.
+     * @param end The end of the buffer.
+     * @param header Receives a copy of the event's header.
+     * @return const char* The start of the event, or nullptr at the end of the buffer or
+     *         on a malformed or unsupported event.
+     */
+    inline const char* nextEvent(const char*& cursor, const char* end, eventHeader& header) {
+        if (end - cursor < static_cast<ptrdiff_t>(sizeof(eventHeader))) {
+            return nullptr;
+        }
+        std::memcpy(&header, cursor, sizeof(eventHeader));
+        if (header.version != kSchemaVersion || header.size < sizeof(eventHeader) || header.size > end - cursor) {
+            return nullptr;
+        }
+        const char* event = cursor;
+        cursor += header.size;
+        return event;
+    }
+
+    /**
+     * @brief Copies an event out of a buffer into its struct.
+     *
+     * @param event The start of the event, as returned by nextEvent.
+     * @param type The type T represents.
+     * @param out Receives the event.
+     * @return True if the event's type and size match T.
+     */
+    template <typename T>
+    bool read(const char* event, eventType type, T& out) {
+        eventHeader header;
+        std::memcpy(&header, event, sizeof(eventHeader));
+        if (header.type != type || header.size != sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&out, event, sizeof(T));
+        return true;
+    }
+}
+
+#endif // BINARYEVENTS_H
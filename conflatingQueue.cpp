@@ -0,0 +1,97 @@
+/**
+ * @file conflatingQueue.cpp
+ * @brief Implementation of the bounded conflating event queue.
+ */
+
+#include "conflatingQueue.h"
+
+/**
+ * @brief Constructs a queue.
+ *
+ * @param sequenceCapacity The maximum number of unread events per sequence key.
+ */
+conflatingQueue::conflatingQueue(size_t sequenceCapacity)
+    : m_sequenceCapacity(sequenceCapacity > 0 ? sequenceCapacity : 1),
+      m_closed(false) {}
+
+/**
+ * @brief Offers an event to the consumer.
+ *
+ * @param kind How the key behaves when its consumer is behind.
+ * @param event The event; its channel is the key.
+ * @return True if the event was queued or overwrote an unread one, false if it was dropped.
+ */
+bool conflatingQueue::push(streamKind kind, channelEvent event) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.pushed;
+        slot& s = m_slots[event.channel];
+        s.kind = kind;
+        if (s.events.empty()) {
+            m_readyKeys.push_back(event.channel);
+            s.events.push_back(std::move(event));
+            ++m_stats.depth;
+            wake = true;
+        } else if (kind == streamKind::state) {
+            s.events.back() = std::move(event);
+            ++m_stats.conflated;
+        } else if (s.events.size() >= m_sequenceCapacity) {
+            ++m_stats.dropped;
+            return false;
+        } else {
+            s.events.push_back(std::move(event));
+            ++m_stats.depth;
+        }
+    }
+    if (wake) {
+        m_ready.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Takes the next event, waiting until one is available or the queue is closed.
+ *
+ * @param event Receives the event.
+ * @return True if an event was taken, false if the queue was closed and is empty.
+ */
+bool conflatingQueue::pop(channelEvent& event) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_ready.wait(lock, [this] { return m_closed || !m_readyKeys.empty(); });
+    if (m_readyKeys.empty()) {
+        return false;
+    }
+    std::string key = std::move(m_readyKeys.front());
+    m_readyKeys.pop_front();
+    slot& s = m_slots[key];
+    event = std::move(s.events.front());
+    s.events.pop_front();
+    if (!s.events.empty()) {
+        m_readyKeys.push_back(std::move(key)); // Back of the line, behind the other keys
+    }
+    --m_stats.depth;
+    ++m_stats.delivered;
+    return true;
+}
+
+/**
+ * @brief Wakes the consumer and makes `pop` return false once the queue is empty.
+ */
+void conflatingQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_ready.notify_all();
+}
+
+/**
+ * @brief Gets the queue counters.
+ *
+ * @return conflationStats The counters.
+ */
+conflationStats conflatingQueue::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file conflatingQueue.h
+ * @brief Header file for the bounded conflating event queue.
+ *
+ * This file defines the `conflatingQueue` class, which hands decoded channel events from
+ * the I/O thread to a consumer thread without blocking the socket reader and without
+ * unbounded memory growth.
+ */
+
+#ifndef CONFLATINGQUEUE_H
+#define CONFLATINGQUEUE_H
+
+#include <nlohmann/json.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief How a stream behaves when its consumer falls behind.
+ */
+enum class streamKind : uint8_t {
+    state,     ///< Each value supersedes the last (ticker, top of book); unread values are overwritten.
+    sequence   ///< Every value matters (trades, order updates); a full queue drops and counts.
+};
+
+/**
+ * @brief A decoded channel event.
+ */
+struct channelEvent {
+    std::string channel;  ///< Channel the event arrived on.
+    nlohmann::json data;  ///< Decoded payload.
+    int64_t receiveTimestampNs = 0;  ///< Local receive time in nanoseconds since the epoch, 0 if unknown.
+    std::string events;   ///< Binary events decoded from the payload (binaryEvents.h), if a consumer needs them.
+};
+
+/**
+ * @brief Counters of a conflating queue.
+ */
+struct conflationStats {
+    size_t depth = 0;        ///< Events waiting for the consumer.
+    uint64_t pushed = 0;     ///< Events offered by the producer.
+    uint64_t conflated = 0;  ///< State events overwritten before they were read.
+    uint64_t dropped = 0;    ///< Sequence events dropped because their queue was full.
+    uint64_t delivered = 0;  ///< Events handed to the consumer.
+};
+
+/**
+ * @class conflatingQueue
+ * @brief Bounded per-key queues between one producer and one consumer.
+ *
+ * Every key (a channel, hence an instrument and stream) has its own queue. A state key
+ * holds at most one unread event, which newer events overwrite in place; a sequence key
+ * holds up to `sequenceCapacity` events and rejects the rest. `push` never blocks, so a
+ * slow consumer costs stale or dropped display data rather than a stalled socket reader.
+ * Keys with pending events are served round-robin, so one busy stream cannot starve the
+ * others. All methods are thread-safe.
+ */
+class conflatingQueue {
+public:
+    /**
+     * @brief Constructs a queue.
+     *
+     * @param sequenceCapacity The maximum number of unread events per sequence key.
+     */
+    explicit conflatingQueue(size_t sequenceCapacity = 256);
+
+    /**
+     * @brief Offers an event to the consumer.
+     *
+     * @param kind How the key behaves when its consumer is behind.
+     * @param event The event; its channel is the key.
+     * @return True if the event was queued or overwrote an unread one, false if it was dropped.
+     */
+    bool push(streamKind kind, channelEvent event);
+
+    /**
+     * @brief Takes the next event, waiting until one is available or the queue is closed.
+     *
+     * @param event Receives the event.
+     * @return True if an event was taken, false if the queue was closed and is empty.
+     */
+    bool pop(channelEvent& event);
+
+    /**
+     * @brief Wakes the consumer and makes `pop` return false once the queue is empty.
+     */
+    void close();
+
+    /**
+     * @brief Gets the queue counters.
+     *
+     * @return conflationStats The counters.
+     */
+    conflationStats stats() const;
+
+private:
+    /**
+     * @brief Pending events of one key.
+     */
+    struct slot {
+        streamKind kind = streamKind::state;
+        std::deque<channelEvent> events;
+    };
+
+    const size_t m_sequenceCapacity; ///< Unread events per sequence key.
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    std::condition_variable m_ready; ///< Signalled when a key becomes ready or the queue closes.
+    std::unordered_map<std::string, slot> m_slots; ///< Pending events by key.
+    std::deque<std::string> m_readyKeys; ///< Keys with pending events, in service order.
+    conflationStats m_stats; ///< Counters.
+    bool m_closed; ///< Whether close was called.
+};
+
+#endif // CONFLATINGQUEUE_H
@@ -7,6 +7,7 @@
  */
 
 #include "deriapi.h"
+#include "hmacSigner.h"
 #include "utils.h"
 #include <string>
 #include <fmt/core.h> // Use fmt for formatted output
@@ -16,6 +17,35 @@ using json = nlohmann::json;
 
 namespace deriapi {
 
+    namespace {
+
+        /**
+         * @brief Builds a "client_signature" authorization request from a computed signature.
+         *
+         * @param clientId The client ID for authentication.
+         * @param timeStamp The timestamp the signature covers.
+         * @param nonce The nonce the signature covers.
+         * @param signature The client signature in hex.
+         * @return std::string The authorization request in JSON format.
+         */
+        std::string signatureAuthRequest(const std::string& clientId, const std::string& timeStamp, const std::string& nonce, const std::string& signature) {
+            json authRequest = {
+                {"jsonrpc", "2.0"},
+                {"id", 1},
+                {"method", "public/auth"},
+                {"params", {
+                    {"grant_type", "client_signature"},
+                    {"client_id", clientId},
+                    {"timestamp", timeStamp},
+                    {"signature", signature},
+                    {"nonce", nonce},
+                    {"scope", "block_rfq:read_write block_trade:read_write trade:read_write custody:read_write account:read_write wallet:read_write mainaccount"}
+                }}
+            };
+            return authRequest.dump();
+        }
+    }
+
     /**
      * @brief Authorizes the client using client ID and secret.
      *
@@ -31,22 +61,43 @@ namespace deriapi {
         std::string timeStamp = utils::getTimeStamp();
         std::string nonce = utils::getNonce();
         std::string clientSignature = utils::getClientSignature(clientSecret, timeStamp, nonce, "");
+        return signatureAuthRequest(clientId, timeStamp, nonce, clientSignature);
+    }
 
-        // Create authorization request JSON
-        json authRequest = {
+    /**
+     * @brief Creates a request that exchanges a refresh token for a new access token.
+     *
+     * This function generates a "public/auth" request with the "refresh_token" grant type.
+     *
+     * @param refreshToken The refresh token from the previous authentication.
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The token refresh request in JSON format.
+     */
+    std::string refreshToken(const std::string& refreshToken, int requestId) {
+        json refreshRequest = {
             {"jsonrpc", "2.0"},
-            {"id", 1},
+            {"id", requestId},
             {"method", "public/auth"},
             {"params", {
-                {"grant_type", "client_signature"},
-                {"client_id", clientId},
-                {"timestamp", timeStamp},
-                {"signature", clientSignature},
-                {"nonce", nonce},
-                {"scope", "block_rfq:read_write block_trade:read_write trade:read_write custody:read_write account:read_write wallet:read_write mainaccount"}
+                {"grant_type", "refresh_token"},
+                {"refresh_token", refreshToken}
             }}
         };
-        return authRequest.dump();
+        return refreshRequest.dump();
+    }
+
+    /**
+     * @brief Authorizes the client with a signer keyed once with the client secret.
+     *
+     * @param clientId The client ID for authentication.
+     * @param signer The signer keyed with the client secret.
+     * @return std::string The authorization request in JSON format.
+     */
+    std::string authorize(const std::string& clientId, const hmacSigner& signer) {
+        std::string timeStamp = utils::getTimeStamp();
+        std::string nonce = utils::getNonce();
+        std::string clientSignature = signer.clientSignature(timeStamp, nonce);
+        return signatureAuthRequest(clientId, timeStamp, nonce, clientSignature);
     }
 
     /**
@@ -82,14 +133,15 @@ namespace deriapi {
      * @param price The price for limit or stop-limit orders.
      * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
      * @param label A custom label for the order.
-     * @param accessToken The access token for authentication.
+     * @param accessToken The access token for authentication; omitted when empty (the WebSocket session is authenticated).
      * @param postOnly [optional] Whether the order should be post-only (default: false).
+     * @param requestId [optional] The JSON-RPC request ID (default: 3).
      * @return std::string The order request in JSON format.
      */
-    std::string createOrder(const std::string& method, const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label, const std::string& accessToken, bool postOnly = false) {
+    std::string createOrder(const std::string& method, const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label, const std::string& accessToken, bool postOnly = false, int requestId = 3) {
         json orderRequest = {
             {"jsonrpc", "2.0"},
-            {"id", 3},
+            {"id", requestId},
             {"method", method},
             {"params", {
                 {"instrument_name", instrument},
@@ -104,6 +156,9 @@ namespace deriapi {
         if (orderType == "limit" || orderType == "stop_limit") {
             orderRequest["params"]["price"] = price;
         }
+        if (accessToken.empty()) {
+            orderRequest["params"].erase("access_token");
+        }
         return orderRequest.dump();
     }
 
@@ -119,13 +174,32 @@ namespace deriapi {
      * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
      * @param label A custom label for the order.
      * @param accessToken The access token for authentication.
+     * @param requestId The JSON-RPC request ID.
      * @return std::string The buy order request in JSON format.
      */
-    std::string buyOrder(const std::string& instrument, int amount, const std::string& orderType, int price, const std::string& timeInForce, const std::string& label, const std::string& accessToken) {
-        return createOrder("private/buy", instrument, amount, orderType, price, timeInForce, label, accessToken);
+    std::string buyOrder(const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label, const std::string& accessToken, int requestId) {
+        return createOrder("private/buy", instrument, amount, orderType, price, timeInForce, label, accessToken, false, requestId);
+    }
+
+    /**
+     * @brief Creates a sell order request.
+     *
+     * This function generates a JSON request for placing a sell order using the `createOrder` function.
+     *
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param amount The amount of the instrument to sell.
+     * @param orderType The type of order (e.g., "limit", "market", "stop_limit").
+     * @param price The price for limit or stop-limit orders.
+     * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
+     * @param label A custom label for the order.
+     * @param accessToken The access token for authentication.
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The sell order request in JSON format.
+     */
+    std::string sellOrder(const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label, const std::string& accessToken, int requestId) {
+        return createOrder("private/sell", instrument, amount, orderType, price, timeInForce, label, accessToken, false, requestId);
     }
 
- 
 
     /**
      * @brief Creates a cancel order request.
@@ -133,12 +207,13 @@ namespace deriapi {
      * This function generates a JSON request for canceling an order using the specified order ID.
      *
      * @param orderId The ID of the order to cancel.
+     * @param requestId The JSON-RPC request ID.
      * @return std::string The cancel order request in JSON format.
      */
-    std::string cancelOrder(const std::string& orderId) {
+    std::string cancelOrder(const std::string& orderId, int requestId) {
         json cancelOrder = {
             {"jsonrpc", "2.0"},
-            {"id", 4},
+            {"id", requestId},
             {"method", "private/cancel"},
             {"params", {
                 {"order_id", orderId}
@@ -147,6 +222,128 @@ namespace deriapi {
         return cancelOrder.dump();
     }
 
+    /**
+     * @brief Creates a request to cancel all orders of the account.
+     *
+     * This function generates a JSON request for "private/cancel_all". The request carries no
+     * access token, so it can be serialized once and sent on an authenticated connection later.
+     *
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The cancel-all request in JSON format.
+     */
+    std::string cancelAll(int requestId) {
+        json cancelAllRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "private/cancel_all"},
+            {"params", json::object()}
+        };
+        return cancelAllRequest.dump();
+    }
+
+    /**
+     * @brief Creates a request to cancel all orders on one instrument.
+     *
+     * This function generates a JSON request for "private/cancel_all_by_instrument".
+     *
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The cancel-all-by-instrument request in JSON format.
+     */
+    std::string cancelAllByInstrument(const std::string& instrument, int requestId) {
+        json cancelAllRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "private/cancel_all_by_instrument"},
+            {"params", {
+                {"instrument_name", instrument}
+            }}
+        };
+        return cancelAllRequest.dump();
+    }
+
+    /**
+     * @brief Creates a request to enable cancel-on-disconnect.
+     *
+     * With cancel-on-disconnect enabled, Deribit cancels all orders of the scope when the
+     * connection drops.
+     *
+     * @param scope "connection" for this connection only, or "account" for the whole account.
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The enable-cancel-on-disconnect request in JSON format.
+     */
+    std::string enableCancelOnDisconnect(const std::string& scope, int requestId) {
+        json codRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "private/enable_cancel_on_disconnect"},
+            {"params", {
+                {"scope", scope}
+            }}
+        };
+        return codRequest.dump();
+    }
+
+    /**
+     * @brief Creates a request to look up orders by label.
+     *
+     * This function generates a JSON request for "private/get_order_state_by_label".
+     *
+     * @param currency The currency of the order's instrument (e.g., "BTC").
+     * @param label The order label.
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The order-state-by-label request in JSON format.
+     */
+    std::string getOrderStateByLabel(const std::string& currency, const std::string& label, int requestId) {
+        json labelRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "private/get_order_state_by_label"},
+            {"params", {
+                {"currency", currency},
+                {"label", label}
+            }}
+        };
+        return labelRequest.dump();
+    }
+
+    /**
+     * @brief Creates a request to enable server heartbeats.
+     *
+     * This function generates a JSON request for "public/set_heartbeat".
+     *
+     * @param intervalSeconds The heartbeat interval in seconds (at least 10).
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The set-heartbeat request in JSON format.
+     */
+    std::string setHeartbeat(int intervalSeconds, int requestId) {
+        json heartbeatRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "public/set_heartbeat"},
+            {"params", {
+                {"interval", intervalSeconds}
+            }}
+        };
+        return heartbeatRequest.dump();
+    }
+
+    /**
+     * @brief Creates a "public/test" request, used to answer heartbeat test requests.
+     *
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The test request in JSON format.
+     */
+    std::string test(int requestId) {
+        json testRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "public/test"},
+            {"params", json::object()}
+        };
+        return testRequest.dump();
+    }
+
     /**
      * @brief Creates a request to retrieve the order book for a specific instrument.
      *
@@ -180,12 +377,13 @@ namespace deriapi {
      * @param timeInForce The new time-in-force for the order.
      * @param postOnly Whether the order should be post-only.
      * @param reduceOnly Whether the order should be reduce-only.
+     * @param requestId The JSON-RPC request ID.
      * @return std::string The modify order request in JSON format.
      */
-    std::string modifyOrder(const std::string& orderId, int amount, double price, const std::string& timeInForce, bool postOnly, bool reduceOnly) {
+    std::string modifyOrder(const std::string& orderId, int amount, double price, const std::string& timeInForce, bool postOnly, bool reduceOnly, int requestId) {
         json modifyRequest = {
             {"jsonrpc", "2.0"},
-            {"id", 6},
+            {"id", requestId},
             {"method", "private/edit"},
             {"params", {
                 {"order_id", orderId},
@@ -205,35 +403,65 @@ namespace deriapi {
      * This function generates a JSON request to get positions for the specified currency and kind.
      *
      * @param currency The currency for which to retrieve positions (e.g., "BTC").
-     * @param kind The kind of positions to retrieve (e.g., "future", "option").
+     * @param kind The kind of positions to retrieve (e.g., "future", "option"); empty for all kinds.
+     * @param requestId The JSON-RPC request ID.
      * @return std::string The positions request in JSON format.
      */
-    std::string getPositions(const std::string& currency, const std::string& kind) {
+    std::string getPositions(const std::string& currency, const std::string& kind, int requestId) {
         json positionsRequest = {
             {"jsonrpc", "2.0"},
-            {"id", 7},
+            {"id", requestId},
             {"method", "private/get_positions"},
             {"params", {
-                {"currency", currency},
-                {"kind", kind}
+                {"currency", currency}
             }}
         };
+        if (!kind.empty()) {
+            positionsRequest["params"]["kind"] = kind;
+        }
         return positionsRequest.dump();
     }
 
+    /**
+     * @brief Creates a request for the book summaries of every instrument of a currency.
+     *
+     * This function generates a JSON request for public/get_book_summary_by_currency.
+     *
+     * @param currency The currency (e.g., "BTC").
+     * @param kind The instrument kind (e.g., "future", "option", "spot"); empty for all kinds.
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The book summary request in JSON format.
+     */
+    std::string getBookSummaryByCurrency(const std::string& currency, const std::string& kind, int requestId) {
+        json summaryRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", "public/get_book_summary_by_currency"},
+            {"params", {
+                {"currency", currency}
+            }}
+        };
+        if (!kind.empty()) {
+            summaryRequest["params"]["kind"] = kind;
+        }
+        return summaryRequest.dump();
+    }
+
     /**
      * @brief Creates a request to subscribe to a WebSocket channel.
      *
      * This function generates a JSON request to subscribe to the specified WebSocket channel.
+     * Private channels (`user.*`) are subscribed through "private/subscribe".
      *
      * @param channel The channel to subscribe to (e.g., "ticker.BTC-PERPETUAL.100ms").
      * @return std::string The subscription request in JSON format.
      */
     std::string subscribeToChannel(const std::string& channel) {
+        bool isPrivate = channel.rfind("user.", 0) == 0;
         json subscribeRequest = {
             {"jsonrpc", "2.0"},
             {"id", 8},
-            {"method", "public/subscribe"},
+            {"method", isPrivate ? "private/subscribe" : "public/subscribe"},
             {"params", {
                 {"channels", {channel}}
             }}
@@ -245,19 +473,65 @@ namespace deriapi {
      * @brief Creates a request to unsubscribe from a WebSocket channel.
      *
      * This function generates a JSON request to unsubscribe from the specified WebSocket channel.
+     * Private channels (`user.*`) are unsubscribed through "private/unsubscribe".
      *
      * @param channel The channel to unsubscribe from (e.g., "ticker.BTC-PERPETUAL.100ms").
      * @return std::string The unsubscription request in JSON format.
      */
     std::string unsubscribeFromChannel(const std::string& channel) {
+        bool isPrivate = channel.rfind("user.", 0) == 0;
         json unsubscribeRequest = {
             {"jsonrpc", "2.0"},
             {"id", 9},
-            {"method", "public/unsubscribe"},
+            {"method", isPrivate ? "private/unsubscribe" : "public/unsubscribe"},
             {"params", {
                 {"channels", {channel}}
             }}
         };
         return unsubscribeRequest.dump();
     }
+
+    /**
+     * @brief Creates a request to subscribe to several WebSocket channels at once.
+     *
+     * All channels must be of the same kind: public, or private (`user.*`).
+     *
+     * @param channels The channels to subscribe to.
+     * @param isPrivate Whether to use "private/subscribe".
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The subscription request in JSON format.
+     */
+    std::string subscribeToChannels(const std::vector<std::string>& channels, bool isPrivate, int requestId) {
+        json subscribeRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", isPrivate ? "private/subscribe" : "public/subscribe"},
+            {"params", {
+                {"channels", channels}
+            }}
+        };
+        return subscribeRequest.dump();
+    }
+
+    /**
+     * @brief Creates a request to unsubscribe from several WebSocket channels at once.
+     *
+     * All channels must be of the same kind: public, or private (`user.*`).
+     *
+     * @param channels The channels to unsubscribe from.
+     * @param isPrivate Whether to use "private/unsubscribe".
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The unsubscription request in JSON format.
+     */
+    std::string unsubscribeFromChannels(const std::vector<std::string>& channels, bool isPrivate, int requestId) {
+        json unsubscribeRequest = {
+            {"jsonrpc", "2.0"},
+            {"id", requestId},
+            {"method", isPrivate ? "private/unsubscribe" : "public/unsubscribe"},
+            {"params", {
+                {"channels", channels}
+            }}
+        };
+        return unsubscribeRequest.dump();
+    }
 }
\ No newline at end of file
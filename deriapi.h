@@ -10,10 +10,13 @@
 #define DERIAPI_H
 
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+class hmacSigner;
+
 namespace deriapi {
 
     /**
@@ -29,6 +32,30 @@ namespace deriapi {
      */
     std::string authorize(const std::string& clientId, const std::string& clientSecret);
 
+    /**
+     * @brief Authorizes the client with a signer keyed once with the client secret.
+     *
+     * Same request as the secret-based overload, but the HMAC key schedule is reused, so
+     * repeated authorizations (and several accounts) do not rehash the secret.
+     *
+     * @param clientId The client ID for authentication.
+     * @param signer The signer keyed with the client secret.
+     * @return std::string The authorization request in JSON format.
+     */
+    std::string authorize(const std::string& clientId, const hmacSigner& signer);
+
+    /**
+     * @brief Creates a request that exchanges a refresh token for a new access token.
+     *
+     * This function generates a "public/auth" request with the "refresh_token" grant type,
+     * so the session stays authorized without signing again or reconnecting.
+     *
+     * @param refreshToken The refresh token from the previous authentication.
+     * @param requestId [optional] The JSON-RPC request ID (default: 16).
+     * @return std::string The token refresh request in JSON format.
+     */
+    std::string refreshToken(const std::string& refreshToken, int requestId = 16);
+
     /**
      * @brief Retrieves the account summary for a specific currency.
      *
@@ -51,9 +78,27 @@ namespace deriapi {
      * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
      * @param label A custom label for the order.
      * @param accessToken The access token for authentication.
+     * @param requestId [optional] The JSON-RPC request ID (default: 3).
      * @return std::string The buy order request in JSON format.
      */
-    std::string buyOrder(const std::string& instrument, int amount, const std::string& orderType, int price, const std::string& timeInForce, const std::string& label, const std::string& accessToken);
+    std::string buyOrder(const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label, const std::string& accessToken, int requestId = 3);
+
+    /**
+     * @brief Creates a sell order request.
+     *
+     * This function generates a JSON request for placing a sell order with the specified parameters.
+     *
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param amount The amount of the instrument to sell.
+     * @param orderType The type of order (e.g., "limit", "market", "stop_limit").
+     * @param price The price for limit or stop-limit orders.
+     * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
+     * @param label A custom label for the order.
+     * @param accessToken The access token for authentication.
+     * @param requestId [optional] The JSON-RPC request ID (default: 3).
+     * @return std::string The sell order request in JSON format.
+     */
+    std::string sellOrder(const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label, const std::string& accessToken, int requestId = 3);
 
     /**
      * @brief Creates a cancel order request.
@@ -61,9 +106,77 @@ namespace deriapi {
      * This function generates a JSON request for canceling an order using the specified order ID.
      *
      * @param orderId The ID of the order to cancel.
+     * @param requestId [optional] The JSON-RPC request ID (default: 4).
      * @return std::string The cancel order request in JSON format.
      */
-    std::string cancelOrder(const std::string& orderId);
+    std::string cancelOrder(const std::string& orderId, int requestId = 4);
+
+    /**
+     * @brief Creates a request to cancel all orders of the account.
+     *
+     * This function generates a JSON request for "private/cancel_all". The request carries no
+     * access token, so it can be serialized once and sent on an authenticated connection later.
+     *
+     * @param requestId [optional] The JSON-RPC request ID (default: 12).
+     * @return std::string The cancel-all request in JSON format.
+     */
+    std::string cancelAll(int requestId = 12);
+
+    /**
+     * @brief Creates a request to cancel all orders on one instrument.
+     *
+     * This function generates a JSON request for "private/cancel_all_by_instrument".
+     *
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param requestId [optional] The JSON-RPC request ID (default: 12).
+     * @return std::string The cancel-all-by-instrument request in JSON format.
+     */
+    std::string cancelAllByInstrument(const std::string& instrument, int requestId = 12);
+
+    /**
+     * @brief Creates a request to enable cancel-on-disconnect.
+     *
+     * With cancel-on-disconnect enabled, Deribit cancels all orders of the scope when the
+     * connection drops.
+     *
+     * @param scope [optional] "connection" for this connection only, or "account" (default: "connection").
+     * @param requestId [optional] The JSON-RPC request ID (default: 11).
+     * @return std::string The enable-cancel-on-disconnect request in JSON format.
+     */
+    std::string enableCancelOnDisconnect(const std::string& scope = "connection", int requestId = 11);
+
+    /**
+     * @brief Creates a request to look up orders by label.
+     *
+     * This function generates a JSON request for "private/get_order_state_by_label", used to
+     * find out whether an unacknowledged order reached the exchange before resubmitting it.
+     *
+     * @param currency The currency of the order's instrument (e.g., "BTC").
+     * @param label The order label.
+     * @param requestId [optional] The JSON-RPC request ID (default: 13).
+     * @return std::string The order-state-by-label request in JSON format.
+     */
+    std::string getOrderStateByLabel(const std::string& currency, const std::string& label, int requestId = 13);
+
+    /**
+     * @brief Creates a request to enable server heartbeats.
+     *
+     * This function generates a JSON request for "public/set_heartbeat". The server then sends
+     * a heartbeat every interval and asks for a "public/test" reply when the connection is idle.
+     *
+     * @param intervalSeconds The heartbeat interval in seconds (at least 10).
+     * @param requestId [optional] The JSON-RPC request ID (default: 14).
+     * @return std::string The set-heartbeat request in JSON format.
+     */
+    std::string setHeartbeat(int intervalSeconds, int requestId = 14);
+
+    /**
+     * @brief Creates a "public/test" request, used to answer heartbeat test requests.
+     *
+     * @param requestId [optional] The JSON-RPC request ID (default: 15).
+     * @return std::string The test request in JSON format.
+     */
+    std::string test(int requestId = 15);
 
     /**
      * @brief Creates a request to retrieve the order book for a specific instrument.
@@ -87,9 +200,10 @@ namespace deriapi {
      * @param timeInForce The new time-in-force for the order.
      * @param postOnly [optional] Whether the order should be post-only (default: false).
      * @param reduceOnly [optional] Whether the order should be reduce-only (default: false).
+     * @param requestId [optional] The JSON-RPC request ID (default: 6).
      * @return std::string The modify order request in JSON format.
      */
-    std::string modifyOrder(const std::string& orderId, int amount, double price, const std::string& timeInForce, bool postOnly = false, bool reduceOnly = false);
+    std::string modifyOrder(const std::string& orderId, int amount, double price, const std::string& timeInForce, bool postOnly = false, bool reduceOnly = false, int requestId = 6);
 
     /**
      * @brief Creates a request to retrieve positions for a specific currency and kind.
@@ -97,10 +211,23 @@ namespace deriapi {
      * This function generates a JSON request to get positions for the specified currency and kind.
      *
      * @param currency The currency for which to retrieve positions (e.g., "BTC").
-     * @param kind [optional] The kind of positions to retrieve (e.g., "future", "option"). Default: "future".
+     * @param kind [optional] The kind of positions to retrieve (e.g., "future", "option"); empty for all kinds. Default: "future".
+     * @param requestId [optional] The JSON-RPC request ID (default: 7).
      * @return std::string The positions request in JSON format.
      */
-    std::string getPositions(const std::string& currency, const std::string& kind = "future");
+    std::string getPositions(const std::string& currency, const std::string& kind = "future", int requestId = 7);
+
+    /**
+     * @brief Creates a request for the book summaries of every instrument of a currency.
+     *
+     * This function generates a JSON request for public/get_book_summary_by_currency.
+     *
+     * @param currency The currency (e.g., "BTC").
+     * @param kind [optional] The instrument kind (e.g., "future", "option", "spot"); empty for all kinds.
+     * @param requestId [optional] The JSON-RPC request ID (default: 17).
+     * @return std::string The book summary request in JSON format.
+     */
+    std::string getBookSummaryByCurrency(const std::string& currency, const std::string& kind = "", int requestId = 17);
 
   
 
@@ -108,6 +235,7 @@ namespace deriapi {
      * @brief Creates a request to subscribe to a WebSocket channel.
      *
      * This function generates a JSON request to subscribe to the specified WebSocket channel.
+     * Private channels (`user.*`) are subscribed through "private/subscribe".
      *
      * @param channel The channel to subscribe to (e.g., "ticker.BTC-PERPETUAL.100ms").
      * @return std::string The subscription request in JSON format.
@@ -118,11 +246,36 @@ namespace deriapi {
      * @brief Creates a request to unsubscribe from a WebSocket channel.
      *
      * This function generates a JSON request to unsubscribe from the specified WebSocket channel.
+     * Private channels (`user.*`) are unsubscribed through "private/unsubscribe".
      *
      * @param channel The channel to unsubscribe from (e.g., "ticker.BTC-PERPETUAL.100ms").
      * @return std::string The unsubscription request in JSON format.
      */
     std::string unsubscribeFromChannel(const std::string& channel);
+
+    /**
+     * @brief Creates a request to subscribe to several WebSocket channels at once.
+     *
+     * All channels must be of the same kind: public, or private (`user.*`).
+     *
+     * @param channels The channels to subscribe to.
+     * @param isPrivate Whether to use "private/subscribe".
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The subscription request in JSON format.
+     */
+    std::string subscribeToChannels(const std::vector<std::string>& channels, bool isPrivate, int requestId);
+
+    /**
+     * @brief Creates a request to unsubscribe from several WebSocket channels at once.
+     *
+     * All channels must be of the same kind: public, or private (`user.*`).
+     *
+     * @param channels The channels to unsubscribe from.
+     * @param isPrivate Whether to use "private/unsubscribe".
+     * @param requestId The JSON-RPC request ID.
+     * @return std::string The unsubscription request in JSON format.
+     */
+    std::string unsubscribeFromChannels(const std::vector<std::string>& channels, bool isPrivate, int requestId);
 }
 
 #endif // DERIAPI_H
\ No newline at end of file
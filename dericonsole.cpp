@@ -10,11 +10,19 @@
 
 #include "webSocketClient.h"
 #include "deriapi.h"
+#include "hmacSigner.h"
 #include <fmt/core.h> 
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <thread>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include <unistd.h>
 
 /**
  * @brief Displays the main menu options.
@@ -30,18 +38,137 @@ void showMenu() {
     fmt::print("7. View Current Positions\n");
     fmt::print("8. Subscribe to Channel\n");
     fmt::print("9. Unsubscribe from Channel\n");
-    fmt::print("10. Exit\n");
+    fmt::print("10. View Open Orders\n");
+    fmt::print("11. Cancel All Orders on Instrument\n");
+    fmt::print("12. Set Risk Limits\n");
+    fmt::print("13. Show Rate Limiter Stats\n");
+    fmt::print("14. Kill Switch (Cancel All Orders)\n");
+    fmt::print("15. Re-arm Trading After Kill\n");
+    fmt::print("16. Add Conditional Order (stop, take_profit, oco)\n");
+    fmt::print("17. List Conditional Orders\n");
+    fmt::print("18. Remove Conditional Order\n");
+    fmt::print("19. Start Quoting\n");
+    fmt::print("20. Stop Quoting\n");
+    fmt::print("21. List Subscriptions\n");
+    fmt::print("22. Pin/Unpin Instrument to Raw Feeds\n");
+    fmt::print("23. Show Output Queue Stats\n");
+    fmt::print("24. Start Shared-Memory Publisher\n");
+    fmt::print("25. Start Local Gateway / Show Gateway Stats\n");
+    fmt::print("26. Scan Currency (Book Summaries)\n");
+    fmt::print("27. Show Startup Timeline\n");
+    fmt::print("0. Exit\n");
     fmt::print("Enter your choice: ");
 }
 
+/**
+ * @brief Splits a comma-separated list of channels.
+ *
+ * @param list The list as typed (e.g., "ticker.BTC-PERPETUAL.100ms,book.ETH-PERPETUAL.100ms").
+ * @return std::vector<std::string> The non-empty channel names.
+ */
+std::vector<std::string> splitChannels(const std::string& list) {
+    std::vector<std::string> channels;
+    std::istringstream stream(list);
+    std::string channel;
+    while (std::getline(stream, channel, ',')) {
+        if (!channel.empty()) {
+            channels.push_back(channel);
+        }
+    }
+    return channels;
+}
+
+/**
+ * @brief Installs the credentials the client authorizes with on every (re)connect.
+ *
+ * @param client The client.
+ * @param clientId The API client ID.
+ * @param clientSecret The API client secret.
+ */
+void setCredentials(webSocketClient& client, const std::string& clientId, const std::string& clientSecret) {
+    // Key the signer once; every (re-)authorization reuses its HMAC state
+    std::shared_ptr<hmacSigner> signer = std::make_shared<hmacSigner>(clientSecret);
+    client.setAuthRequestCallback([&client, clientId, signer]() {
+        std::string authRequest = deriapi::authorize(clientId, *signer);
+        client.send(authRequest);
+    });
+}
+
 /**
  * @brief Main function for the WebSocket client application.
  *
+ * `--ndjson` writes channel events to stdout as NDJSON and moves the menu and all other
+ * console output to stderr, so stdout can be piped into other tools. `--fields=a,b,...`
+ * limits the NDJSON keys.
+ *
+ * `--connect` starts connecting before the menu comes up, authorizing with
+ * DERIBIT_CLIENT_ID and DERIBIT_CLIENT_SECRET if they are set. `--subscribe=a,b,...` and
+ * `--scan=BTC,ETH,...` add channels and book summary scans to the startup pipeline (and
+ * imply `--connect`); everything is sent as soon as the connection opens.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
  * @return int Returns 0 on successful execution.
  */
-int main() {
+int main(int argc, char* argv[]) {
     webSocketClient client;
 
+    const std::string uri = "wss://test.deribit.com/ws/api/v2";
+    bool ndjson = false;
+    bool preconnect = false;
+    std::string fields;
+    std::vector<std::string> startupChannels;
+    std::vector<std::string> startupCurrencies;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--ndjson") {
+            ndjson = true;
+        } else if (arg.rfind("--fields=", 0) == 0) {
+            fields = arg.substr(9);
+        } else if (arg == "--connect") {
+            preconnect = true;
+        } else if (arg.rfind("--subscribe=", 0) == 0) {
+            startupChannels = splitChannels(arg.substr(12));
+            preconnect = true;
+        } else if (arg.rfind("--scan=", 0) == 0) {
+            startupCurrencies = splitChannels(arg.substr(7));
+            preconnect = true;
+        } else {
+            fmt::print(stderr, "Unknown argument: {}\nUsage: {} [--ndjson [--fields=type,instrument,...]] "
+                       "[--connect] [--subscribe=channel,...] [--scan=BTC,...]\n", arg, argv[0]);
+            return 1;
+        }
+    }
+    if (ndjson) {
+        // Keep the real stdout for data and send everything else to stderr
+        int dataFd = dup(STDOUT_FILENO);
+        if (dataFd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            fmt::print(stderr, "Failed to redirect console output: {}\n", std::strerror(errno));
+            return 1;
+        }
+        std::signal(SIGPIPE, SIG_IGN); // A closed pipe becomes a write error, not a kill
+        try {
+            client.enableNdjson(dataFd, fields);
+        } catch (const std::runtime_error& e) {
+            fmt::print(stderr, "{}\n", e.what());
+            return 1;
+        }
+    }
+
+    if (preconnect) {
+        // Connect, authorize, subscribe and scan while the menu comes up
+        const char* clientId = std::getenv("DERIBIT_CLIENT_ID");
+        const char* clientSecret = std::getenv("DERIBIT_CLIENT_SECRET");
+        if (clientId != nullptr && clientSecret != nullptr) {
+            setCredentials(client, clientId, clientSecret);
+        } else {
+            fmt::print("DERIBIT_CLIENT_ID/DERIBIT_CLIENT_SECRET not set; connecting without authorization.\n");
+        }
+        client.subscribe(startupChannels);
+        client.setWarmupCurrencies(startupCurrencies);
+        client.connect(uri);
+    }
+
     int choice;
     do {
         showMenu();
@@ -49,21 +176,33 @@ int main() {
 
         switch (choice) {
             case 1: {
+                if (client.isAuthenticated()) {
+                    fmt::print("Already authenticated.\n");
+                    break;
+                }
                 std::string clientId;
                 std::string clientSecret;
                 fmt::print("Enter Client Id: ");
                 std::cin>>clientId;
                 fmt::print("Enter a Client Secret: ");
                 std::cin>>clientSecret;
-                client.setAuthRequestCallback([&client, clientId, clientSecret]() {
-                    std::string authRequest = deriapi::authorize(clientId, clientSecret);
-                    client.send(authRequest);
-                });
-                 std::string uri = "wss://test.deribit.com/ws/api/v2";
-                client.connect(uri);
-
-                // Wait for authentication to complete
-                while (!client.isAuthenticated()) {
+                // A pre-connect still in flight must open (or fail) before its callback is replaced
+                while (client.isConnecting()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                if (client.isAuthenticated()) {
+                    fmt::print("Already authenticated.\n");
+                    break;
+                }
+                setCredentials(client, clientId, clientSecret);
+                if (client.isConnected()) {
+                    client.authenticate();
+                } else {
+                    client.connect(uri);
+                }
+
+                // Wait for authentication to complete; a failure or timeout ends the wait
+                while (!client.isAuthenticated() && !client.hasAuthFailed()) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
                 break;
@@ -99,15 +238,28 @@ int main() {
                 }
 
                 std::string timeInForce;
-                fmt::print("Enter time-in-force (good_til_cancelled, fill_or_kill, etc.): ");
+                fmt::print("Enter time-in-force (good_til_cancelled, fill_or_kill, good_til_date, etc.): ");
                 std::cin >> timeInForce;
 
+                // good_til_date is emulated client-side: the order is cancelled once its lifetime ends
+                long lifetimeSeconds = 0;
+                if (timeInForce == "good_til_date") {
+                    fmt::print("Enter lifetime in seconds: ");
+                    std::cin >> lifetimeSeconds;
+                    timeInForce = "good_til_cancelled";
+                }
+
                 std::string label;
-                fmt::print("Enter label: ");
+                fmt::print("Enter label ('-' to generate one): ");
                 std::cin >> label;
+                if (label == "-") {
+                    label.clear();
+                }
 
-                std::string buyRequest = deriapi::buyOrder(instrument, amount, orderType, price, timeInForce, label, client.getAccessToken());
-                client.send(buyRequest);
+                uint32_t clientId = client.placeOrder("buy", instrument, amount, orderType, price, timeInForce, label);
+                if (clientId != orderManager::kInvalidId && lifetimeSeconds > 0) {
+                    client.setOrderExpiry(clientId, lifetimeSeconds * 1000);
+                }
                 while (client.isWaitingForResponse()) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
@@ -118,8 +270,7 @@ int main() {
                 std::string orderId;
                 fmt::print("Enter order id: ");
                 std::cin >> orderId;
-                std::string cancelRequest = deriapi::cancelOrder(orderId);
-                client.send(cancelRequest);
+                client.cancelOrder(orderId);
                 while (client.isWaitingForResponse()) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
@@ -157,51 +308,317 @@ int main() {
                 fmt::print("Enter Time-in-Force (e.g., good_til_cancelled): ");
                 std::cin >> timeInForce;
 
-                std::string modifyRequest = deriapi::modifyOrder(orderId, amount, price, timeInForce);
-                client.send(modifyRequest);
+                client.modifyOrder(orderId, amount, price, timeInForce);
                 while (client.isWaitingForResponse()) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
                 break;
             }
             case 7: {
-                std::string currency;
-                fmt::print("Enter Currency (e.g., BTC): ");
-                std::cin >> currency;
-
+                // Answered from fills applied locally; reconciled with the exchange every 30s
+                std::vector<position> positions = client.getPositionTracker().all();
+                if (positions.empty()) {
+                    fmt::print("No positions found.\n");
+                    break;
+                }
+                fmt::print("\nCurrent Positions:\n");
+                for (const position& p : positions) {
+                    fmt::print("Instrument: {}\n", p.instrument);
+                    fmt::print("Size: {}\n", p.size);
+                    fmt::print("Average Price: {}\n", p.averagePrice);
+                    fmt::print("Realized Profit/Loss: {} ({})\n", p.realizedPnl, p.inverse ? "base coin" : "quote currency");
+                    fmt::print("Fills: {}\n", p.fills);
+                    fmt::print("----------------------------\n");
+                }
+                fmt::print("Reconciliation drifts detected: {}\n", client.getPositionTracker().driftCount());
+                break;
+            }
+            case 8: {
+                std::string channels;
+                fmt::print("Enter channels, comma-separated (e.g., ticker.BTC-PERPETUAL.100ms): ");
+                std::cin >> channels;
+                client.subscribe(splitChannels(channels));
+                break;
+            }
+            case 9: {
+                std::string channels;
+                fmt::print("Enter channels to unsubscribe, comma-separated: ");
+                std::cin >> channels;
+                client.unsubscribe(splitChannels(channels));
+                break;
+            }
+            case 10: {
+                std::vector<order> openOrders = client.getOrderManager().openOrders();
+                if (openOrders.empty()) {
+                    fmt::print("No open orders.\n");
+                    break;
+                }
+                fmt::print("\nOpen Orders:\n");
+                for (const order& o : openOrders) {
+                    fmt::print("[{}] {} {} {} {} @ {} (filled {}) state={} id={} label={}\n",
+                               o.clientId, o.instrument, o.direction, o.orderType, o.amount, o.price,
+                               o.filledAmount, toString(o.state), o.orderId.empty() ? "-" : o.orderId, o.label);
+                }
+                break;
+            }
+            case 11: {
+                std::string instrument;
+                fmt::print("Enter instrument name: ");
+                std::cin >> instrument;
+                size_t sent = client.cancelAll(instrument);
+                fmt::print("Sent {} cancel request(s) for {}.\n", sent, instrument);
+                break;
+            }
+            case 12: {
+                std::string instrument;
+                fmt::print("Enter instrument name (or 'default', 'account'): ");
+                std::cin >> instrument;
+                if (instrument == "account") {
+                    int maxOpenOrders;
+                    double maxGrossPosition;
+                    fmt::print("Enter max open orders (0 = unlimited): ");
+                    std::cin >> maxOpenOrders;
+                    fmt::print("Enter max gross position (0 = unlimited): ");
+                    std::cin >> maxGrossPosition;
+                    client.getRiskManager().setAccountLimits(maxOpenOrders, maxGrossPosition);
+                    break;
+                }
+                riskLimits limits;
+                fmt::print("Enter max order amount (0 = unlimited): ");
+                std::cin >> limits.maxOrderAmount;
+                fmt::print("Enter max order notional (0 = unlimited): ");
+                std::cin >> limits.maxOrderNotional;
+                fmt::print("Enter price collar around mark in percent (0 = unlimited): ");
+                std::cin >> limits.priceCollar;
+                limits.priceCollar /= 100.0;
+                fmt::print("Enter max open orders (0 = unlimited): ");
+                std::cin >> limits.maxOpenOrders;
+                fmt::print("Enter max position (0 = unlimited): ");
+                std::cin >> limits.maxPosition;
+                if (instrument == "default") {
+                    client.getRiskManager().setDefaultLimits(limits);
+                } else {
+                    client.getRiskManager().setLimits(instrument, limits);
+                }
+                break;
+            }
+            case 13: {
+                const std::pair<const char*, creditPool> pools[] = {
+                    {"Matching", creditPool::matching},
+                    {"Non-matching", creditPool::nonMatching}
+                };
+                fmt::print("\nRate Limiter:\n");
+                for (const auto& pool : pools) {
+                    creditPoolStats stats = client.getRateLimiter().stats(pool.second);
+                    fmt::print("{}: credits {:.0f}/{:.0f}, queued now {}, sent {}, queued {}, rejected {}\n",
+                               pool.first, stats.credits, stats.capacity, stats.queueDepth,
+                               stats.sent, stats.queued, stats.rejected);
+                }
+                fmt::print("Exchange rate-limit errors (10028): {}\n", client.getRateLimiter().exchangeRejects());
+                fmt::print("Edits coalesced: {}\n", client.getOrderManager().editsCoalesced());
+                break;
+            }
+            case 14: {
+                std::string instrument;
+                fmt::print("Enter instrument name (or 'all'): ");
+                std::cin >> instrument;
+                client.killSwitch(instrument == "all" ? "" : instrument);
+                break;
+            }
+            case 15:
+                client.rearm();
+                fmt::print("Trading re-armed.\n");
+                break;
+            case 16: {
                 std::string kind;
-                fmt::print("Enter Instrument Type (e.g., future, option, spot): ");
+                fmt::print("Enter type (stop, take_profit, oco): ");
                 std::cin >> kind;
 
-                std::string positionsRequest = deriapi::getPositions(currency, kind);
-                client.send(positionsRequest);
-                while (client.isWaitingForResponse()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                std::string instrument;
+                fmt::print("Enter instrument name: ");
+                std::cin >> instrument;
+
+                std::string direction;
+                fmt::print("Enter direction (buy, sell): ");
+                std::cin >> direction;
+
+                int amount;
+                fmt::print("Enter amount: ");
+                std::cin >> amount;
+
+                std::string orderType;
+                fmt::print("Enter order type (market, limit): ");
+                std::cin >> orderType;
+
+                double stopLevel = 0.0;
+                double takeProfitLevel = 0.0;
+                if (kind == "stop" || kind == "oco") {
+                    fmt::print("Enter stop trigger price: ");
+                    std::cin >> stopLevel;
+                }
+                if (kind == "take_profit" || kind == "oco") {
+                    fmt::print("Enter take-profit trigger price: ");
+                    std::cin >> takeProfitLevel;
+                }
+
+                double price = 0.0;
+                if (orderType == "limit") {
+                    fmt::print("Enter limit price: ");
+                    std::cin >> price;
+                }
+
+                if (kind == "stop") {
+                    fmt::print("Armed trigger {}.\n", client.addTrigger(true, instrument, direction, amount, stopLevel, orderType, price));
+                } else if (kind == "take_profit") {
+                    fmt::print("Armed trigger {}.\n", client.addTrigger(false, instrument, direction, amount, takeProfitLevel, orderType, price));
+                } else if (kind == "oco") {
+                    uint32_t stopId = 0;
+                    uint32_t takeProfitId = 0;
+                    client.addOcoTriggers(instrument, direction, amount, stopLevel, takeProfitLevel, orderType, price, stopId, takeProfitId);
+                    fmt::print("Armed OCO triggers {} and {}.\n", stopId, takeProfitId);
+                } else {
+                    fmt::print("Unknown conditional order type.\n");
                 }
                 break;
             }
-            case 8: {
-                std::string channel;
-                fmt::print("Enter channel (e.g., ticker.BTC-PERPETUAL.100ms): ");
-                std::cin >> channel;
-                client.subscribe(channel);
+            case 17: {
+                std::vector<trigger> triggers = client.getTriggerEngine().list();
+                if (triggers.empty()) {
+                    fmt::print("No conditional orders armed.\n");
+                    break;
+                }
+                fmt::print("\nConditional Orders:\n");
+                for (const trigger& t : triggers) {
+                    fmt::print("[{}] {} {} {} when price {} {}{}\n", t.id, t.direction, t.amount, t.instrument,
+                               t.side == triggerSide::above ? ">=" : "<=", t.level,
+                               t.ocoPeer == triggerEngine::kNone ? "" : fmt::format(" (oco with {})", t.ocoPeer));
+                }
                 break;
             }
-            case 9: {
-                std::string channel;
-                fmt::print("Enter channel to unsubscribe: ");
-                std::cin >> channel;
-                client.unsubscribe(channel);
+            case 18: {
+                uint32_t id;
+                fmt::print("Enter trigger id: ");
+                std::cin >> id;
+                fmt::print("{}\n", client.getTriggerEngine().remove(id) ? "Trigger removed." : "Unknown trigger.");
+                break;
+            }
+            case 19: {
+                std::string instrument;
+                fmt::print("Enter instrument name: ");
+                std::cin >> instrument;
+
+                quoteConfig config;
+                fmt::print("Enter quote size: ");
+                std::cin >> config.size;
+                fmt::print("Enter half spread: ");
+                std::cin >> config.halfSpread;
+                fmt::print("Enter levels per side: ");
+                std::cin >> config.levels;
+                if (config.levels > 1) {
+                    fmt::print("Enter level step: ");
+                    std::cin >> config.levelStep;
+                }
+                fmt::print("Enter tick size: ");
+                std::cin >> config.tickSize;
+                fmt::print("Enter hysteresis (minimum price move before editing): ");
+                std::cin >> config.hysteresis;
+                fmt::print("Enter minimum milliseconds between edits (e.g., 100): ");
+                std::cin >> config.minRequoteMs;
+
+                client.startQuoting(instrument, config);
+                break;
+            }
+            case 20: {
+                std::string instrument;
+                fmt::print("Enter instrument name: ");
+                std::cin >> instrument;
+                client.stopQuoting(instrument);
+                quoteStats stats = client.getQuoteEngine().stats();
+                fmt::print("Quotes: {} placed, {} edits, {} cancels, {} re-quotes suppressed, {} rejected.\n",
+                           stats.places, stats.edits, stats.cancels, stats.suppressed, stats.rejected);
                 break;
             }
-            case 10:
+            case 21: {
+                std::vector<channelStatus> channels = client.getSubscriptions().list();
+                if (channels.empty()) {
+                    fmt::print("No subscriptions.\n");
+                    break;
+                }
+                for (const channelStatus& c : channels) {
+                    fmt::print("{} [{}{}]\n", c.channel, toString(c.state), c.desired ? "" : ", removing");
+                }
+                for (const intervalChange& d : client.getSubscriptions().downgrades()) {
+                    fmt::print("Downgraded under load: {} -> {}\n", d.from, d.to);
+                }
+                break;
+            }
+            case 22: {
+                std::string instrument;
+                char pin;
+                fmt::print("Enter instrument name: ");
+                std::cin >> instrument;
+                fmt::print("Pin to raw? (y/n): ");
+                std::cin >> pin;
+                client.pinInstrument(instrument, pin == 'y' || pin == 'Y');
+                fmt::print("{} {}.\n", instrument, client.getSubscriptions().isPinned(instrument) ? "pinned to raw" : "unpinned");
+                break;
+            }
+            case 23: {
+                conflationStats stats = client.getOutputStats();
+                fmt::print("Output queue: {} waiting, {} offered, {} delivered, {} conflated, {} dropped.\n",
+                           stats.depth, stats.pushed, stats.delivered, stats.conflated, stats.dropped);
+                break;
+            }
+            case 24: {
+                if (client.startPublisher()) {
+                    fmt::print("Publishing normalized market data events to shared memory {}.\n", shmPublisher::kDefaultName);
+                }
+                break;
+            }
+            case 25: {
+                if (client.isGatewayRunning()) {
+                    gatewayStats stats = client.getGatewayStats();
+                    fmt::print("Gateway: {} connection(s), {} channel(s), {} frames in, {} frames out.\n",
+                               stats.connections, stats.channels, stats.framesIn, stats.framesOut);
+                    break;
+                }
+                int port;
+                fmt::print("Enter port to listen on (127.0.0.1): ");
+                std::cin >> port;
+                if (port > 0 && port < 65536 && client.startGateway(static_cast<uint16_t>(port))) {
+                    fmt::print("Gateway listening on ws://127.0.0.1:{}\n", port);
+                }
+                break;
+            }
+            case 26: {
+                std::string currency;
+                std::string kind;
+                fmt::print("Enter Currency (e.g., BTC): ");
+                std::cin >> currency;
+                fmt::print("Enter kind (future, option, spot, future_combo, option_combo, or any): ");
+                std::cin >> kind;
+                client.requestBookSummary(currency, kind == "any" ? std::string() : kind);
+                for (int waited = 0; client.isBookSummaryPending() && waited < 100; ++waited) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+                fmt::print("Top instruments by volume ({} in store):\n", client.getTickers().size());
+                for (const tickerRow& row : client.getTickers().topByVolume(10, currency)) {
+                    fmt::print("  {:<28} bid {:>10} ask {:>10} mark {:>10} vol {:>12} OI {:>12}\n", row.instrument,
+                               row.bidPrice, row.askPrice, row.markPrice, row.volume, row.openInterest);
+                }
+                break;
+            }
+            case 27:
+                fmt::print("Startup timeline (since client creation):\n{}", client.getStartupTimeline().report());
+                break;
+            case 0:
                 fmt::print("Exiting...\n");
                 break;
             default:
                 fmt::print("Invalid choice. Please try again.\n");
                 break;
         }
-    } while (choice > 0 && choice < 10);
+    } while (choice != 0);
 
     // Close the WebSocket connection
     client.close();
@@ -0,0 +1,347 @@
+/**
+ * @file eventNormalizer.cpp
+ * @brief Implementation of the event normalizer.
+ */
+
+#include "eventNormalizer.h"
+#include <limits>
+
+using namespace binaryEvents;
+
+namespace {
+
+    const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+    /**
+     * @brief Reads a numeric field, or NaN if it is missing or not a number.
+     *
+     * @param object The JSON object.
+     * @param key The field name.
+     * @return double The value.
+     */
+    double number(const nlohmann::json& object, const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_number() ? it->get<double>() : kNaN;
+    }
+
+    /**
+     * @brief Reads an integer field, or 0 if it is missing or not an integer.
+     *
+     * @param object The JSON object.
+     * @param key The field name.
+     * @return int64_t The value.
+     */
+    int64_t integer(const nlohmann::json& object, const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_number_integer() ? it->get<int64_t>() : 0;
+    }
+
+    /**
+     * @brief Copies a string field into a fixed, NUL-terminated buffer, truncating it.
+     *
+     * @param object The JSON object.
+     * @param key The field name.
+     * @param out The buffer.
+     */
+    template <size_t N>
+    void copyString(const nlohmann::json& object, const char* key, char (&out)[N]) {
+        auto it = object.find(key);
+        if (it == object.end() || !it->is_string()) {
+            return;
+        }
+        const std::string& value = it->get_ref<const std::string&>();
+        size_t length = value.size() < N - 1 ? value.size() : N - 1;
+        std::memcpy(out, value.data(), length);
+        out[length] = '\0';
+    }
+
+    /**
+     * @brief Maps Deribit's order_state to the binary order status.
+     *
+     * @param state The order state string.
+     * @return orderStatus The status.
+     */
+    orderStatus toOrderStatus(const std::string& state) {
+        if (state == "open") return orderStatus::open;
+        if (state == "filled") return orderStatus::filled;
+        if (state == "cancelled") return orderStatus::cancelled;
+        if (state == "rejected") return orderStatus::rejected;
+        if (state == "untriggered") return orderStatus::untriggered;
+        return orderStatus::unknown;
+    }
+}
+
+/**
+ * @brief Constructs a normalizer with an empty instrument directory.
+ */
+eventNormalizer::eventNormalizer() : m_sequence(0) {}
+
+/**
+ * @brief Starts an event of type T at the end of the buffer.
+ *
+ * @param type The event type.
+ * @param instrumentId The instrument ID.
+ * @param exchangeTimestampMs The exchange timestamp in milliseconds.
+ * @param receiveTimestampNs Local receive time in nanoseconds.
+ * @return T The zeroed event with its header filled in.
+ */
+template <typename T>
+T eventNormalizer::begin(eventType type, uint32_t instrumentId, int64_t exchangeTimestampMs, int64_t receiveTimestampNs) {
+    T event;
+    std::memset(&event, 0, sizeof(T));
+    event.header.size = static_cast<uint16_t>(sizeof(T));
+    event.header.version = kSchemaVersion;
+    event.header.type = type;
+    event.header.instrumentId = instrumentId;
+    event.header.sequence = m_sequence++;
+    event.header.exchangeTimestampNs = exchangeTimestampMs * 1000000;
+    event.header.receiveTimestampNs = receiveTimestampNs;
+    return event;
+}
+
+/**
+ * @brief Appends a finished event to the buffer.
+ *
+ * @param event The event.
+ * @param out The buffer.
+ */
+template <typename T>
+void eventNormalizer::append(const T& event, std::string& out) {
+    out.append(reinterpret_cast<const char*>(&event), sizeof(T));
+}
+
+/**
+ * @brief Gets the ID of an instrument, emitting its definition on first use.
+ *
+ * @param name The instrument name.
+ * @param receiveTimestampNs Local receive time for the definition event.
+ * @param out Receives the definition event, if the instrument is new.
+ * @return uint32_t The instrument ID.
+ */
+uint32_t eventNormalizer::instrumentId(const std::string& name, int64_t receiveTimestampNs, std::string& out) {
+    auto it = m_ids.find(name);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(m_names.size());
+    m_ids.emplace(name, id);
+    m_names.push_back(name);
+    instrumentEvent event = begin<instrumentEvent>(eventType::instrument, id, 0, receiveTimestampNs);
+    std::memcpy(event.name, name.data(), name.size() < sizeof(event.name) - 1 ? name.size() : sizeof(event.name) - 1);
+    append(event, out);
+    return id;
+}
+
+/**
+ * @brief Normalizes one channel notification.
+ *
+ * @param channel The channel name.
+ * @param data The notification's "data" field.
+ * @param receiveTimestampNs Local receive time in nanoseconds since the epoch.
+ * @param out Receives the events, appended back to back.
+ * @return size_t The number of events appended, not counting instrument definitions.
+ */
+size_t eventNormalizer::normalize(const std::string& channel, const nlohmann::json& data, int64_t receiveTimestampNs, std::string& out) {
+    if (channel.rfind("book.", 0) == 0 && data.is_object()) {
+        return normalizeBook(data, receiveTimestampNs, out);
+    }
+    if (channel.rfind("user.orders", 0) == 0) {
+        size_t count = 0;
+        if (data.is_array()) {
+            for (const auto& order : data) {
+                count += normalizeOrder(order, receiveTimestampNs, out);
+            }
+        } else {
+            count = normalizeOrder(data, receiveTimestampNs, out);
+        }
+        return count;
+    }
+    if (channel.rfind("trades.", 0) == 0 && data.is_array()) {
+        size_t count = 0;
+        for (const auto& trade : data) {
+            auto name = trade.find("instrument_name");
+            if (name == trade.end() || !name->is_string()) {
+                continue;
+            }
+            uint32_t id = instrumentId(name->get<std::string>(), receiveTimestampNs, out);
+            tradeEvent event = begin<tradeEvent>(eventType::trade, id, integer(trade, "timestamp"), receiveTimestampNs);
+            event.price = number(trade, "price");
+            event.amount = number(trade, "amount");
+            event.tradeSeq = integer(trade, "trade_seq");
+            std::string direction = trade.value("direction", "");
+            event.aggressor = direction == "buy" ? side::bid : direction == "sell" ? side::ask : side::none;
+            append(event, out);
+            ++count;
+        }
+        return count;
+    }
+    if (!data.is_object() || !data.contains("instrument_name") || !data["instrument_name"].is_string()) {
+        return 0;
+    }
+    if (channel.rfind("ticker.", 0) == 0) {
+        uint32_t id = instrumentId(data["instrument_name"].get<std::string>(), receiveTimestampNs, out);
+        tickerEvent event = begin<tickerEvent>(eventType::ticker, id, integer(data, "timestamp"), receiveTimestampNs);
+        event.bidPrice = number(data, "best_bid_price");
+        event.bidAmount = number(data, "best_bid_amount");
+        event.askPrice = number(data, "best_ask_price");
+        event.askAmount = number(data, "best_ask_amount");
+        event.lastPrice = number(data, "last_price");
+        event.markPrice = number(data, "mark_price");
+        event.indexPrice = number(data, "index_price");
+        event.openInterest = number(data, "open_interest");
+        append(event, out);
+        return 1;
+    }
+    if (channel.rfind("quote.", 0) == 0) {
+        uint32_t id = instrumentId(data["instrument_name"].get<std::string>(), receiveTimestampNs, out);
+        topOfBookEvent event = begin<topOfBookEvent>(eventType::topOfBook, id, integer(data, "timestamp"), receiveTimestampNs);
+        event.bidPrice = number(data, "best_bid_price");
+        event.bidAmount = number(data, "best_bid_amount");
+        event.askPrice = number(data, "best_ask_price");
+        event.askAmount = number(data, "best_ask_amount");
+        append(event, out);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Normalizes a book notification into one event per level.
+ *
+ * Raw and interval books send ["new"|"change"|"delete", price, amount] levels with
+ * a snapshot/change type; grouped books send full [price, amount] snapshots.
+ *
+ * @param data The notification's "data" field.
+ * @param receiveTimestampNs Local receive time in nanoseconds.
+ * @param out Receives the events.
+ * @return size_t The number of events appended.
+ */
+size_t eventNormalizer::normalizeBook(const nlohmann::json& data, int64_t receiveTimestampNs, std::string& out) {
+    if (!data.contains("instrument_name") || !data["instrument_name"].is_string()) {
+        return 0;
+    }
+    uint32_t id = instrumentId(data["instrument_name"].get<std::string>(), receiveTimestampNs, out);
+    int64_t timestamp = integer(data, "timestamp");
+    int64_t changeId = integer(data, "change_id");
+    int64_t prevChangeId = integer(data, "prev_change_id");
+    bool snapshot = data.value("type", "snapshot") == "snapshot";
+    size_t count = 0;
+    for (const auto& book : {std::make_pair("bids", side::bid), std::make_pair("asks", side::ask)}) {
+        auto levels = data.find(book.first);
+        if (levels == data.end() || !levels->is_array()) {
+            continue;
+        }
+        for (const auto& level : *levels) {
+            size_t offset = level.is_array() && !level.empty() && level[0].is_string() ? 1 : 0;
+            if (!level.is_array() || level.size() < offset + 2) {
+                continue;
+            }
+            bookLevelEvent event = begin<bookLevelEvent>(eventType::bookLevel, id, timestamp, receiveTimestampNs);
+            event.changeId = changeId;
+            event.prevChangeId = snapshot ? 0 : prevChangeId;
+            event.levelSide = book.second;
+            event.flags = snapshot ? kBookSnapshot : 0;
+            std::string action = offset ? level[0].get<std::string>() : "new";
+            event.action = action == "delete" ? levelAction::deleted : action == "change" ? levelAction::changed : levelAction::added;
+            event.price = level[offset].is_number() ? level[offset].get<double>() : kNaN;
+            event.amount = level[offset + 1].is_number() ? level[offset + 1].get<double>() : kNaN;
+            append(event, out);
+            ++count;
+        }
+    }
+    if (count > 0) {
+        // Mark the last level so consumers know when the book is consistent again
+        out[out.size() - sizeof(bookLevelEvent) + offsetof(bookLevelEvent, flags)] |= static_cast<char>(kBookLast);
+    }
+    return count;
+}
+
+/**
+ * @brief Normalizes one order of a user.orders notification.
+ *
+ * @param order The order object.
+ * @param receiveTimestampNs Local receive time in nanoseconds.
+ * @param out Receives the events.
+ * @return size_t The number of events appended.
+ */
+size_t eventNormalizer::normalizeOrder(const nlohmann::json& order, int64_t receiveTimestampNs, std::string& out) {
+    if (!order.is_object() || !order.contains("instrument_name") || !order["instrument_name"].is_string()) {
+        return 0;
+    }
+    uint32_t id = instrumentId(order["instrument_name"].get<std::string>(), receiveTimestampNs, out);
+    orderUpdateEvent event = begin<orderUpdateEvent>(eventType::orderUpdate, id, integer(order, "last_update_timestamp"), receiveTimestampNs);
+    copyString(order, "order_id", event.orderId);
+    copyString(order, "label", event.label);
+    event.price = number(order, "price"); // "market_price" for market orders -> NaN
+    event.amount = number(order, "amount");
+    event.filledAmount = number(order, "filled_amount");
+    event.averagePrice = number(order, "average_price");
+    event.status = toOrderStatus(order.value("order_state", ""));
+    std::string direction = order.value("direction", "");
+    event.direction = direction == "buy" ? side::bid : direction == "sell" ? side::ask : side::none;
+    append(event, out);
+    return 1;
+}
+
+/**
+ * @brief Appends an `instrument` event for every known instrument.
+ *
+ * The events carry kOutOfBand as sequence, so they do not disturb gap detection.
+ *
+ * @param out Receives the events.
+ */
+void eventNormalizer::definitions(std::string& out) const {
+    for (uint32_t id = 0; id < m_names.size(); ++id) {
+        appendDefinition(id, out);
+    }
+}
+
+/**
+ * @brief Appends an `instrument` event for every instrument a buffer of events uses.
+ *
+ * @param events The events, as produced by normalize.
+ * @param out Receives the definitions.
+ */
+void eventNormalizer::definitionsFor(const std::string& events, std::string& out) const {
+    uint32_t previous = UINT32_MAX;
+    const char* cursor = events.data();
+    const char* end = cursor + events.size();
+    eventHeader header;
+    while (nextEvent(cursor, end, header)) {
+        // Events of one notification almost always share their instrument
+        if (header.type != eventType::instrument && header.instrumentId != previous && header.instrumentId < m_names.size()) {
+            appendDefinition(header.instrumentId, out);
+            previous = header.instrumentId;
+        }
+    }
+}
+
+/**
+ * @brief Appends an out-of-band `instrument` event for one known instrument.
+ *
+ * @param id The instrument ID.
+ * @param out Receives the event.
+ */
+void eventNormalizer::appendDefinition(uint32_t id, std::string& out) const {
+    instrumentEvent event;
+    std::memset(&event, 0, sizeof(event));
+    event.header.size = sizeof(instrumentEvent);
+    event.header.version = kSchemaVersion;
+    event.header.type = eventType::instrument;
+    event.header.instrumentId = id;
+    event.header.sequence = kOutOfBand;
+    const std::string& name = m_names[id];
+    std::memcpy(event.name, name.data(), name.size() < sizeof(event.name) - 1 ? name.size() : sizeof(event.name) - 1);
+    append(event, out);
+}
+
+/**
+ * @brief Gets the name of an instrument ID.
+ *
+ * @param id The instrument ID.
+ * @return const std::string& The name, or an empty string for an unknown ID.
+ */
+const std::string& eventNormalizer::instrumentName(uint32_t id) const {
+    static const std::string unknown;
+    return id < m_names.size() ? m_names[id] : unknown;
+}
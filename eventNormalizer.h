@@ -0,0 +1,123 @@
+/**
+ * @file eventNormalizer.h
+ * @brief Header file for the event normalizer.
+ *
+ * This file defines the `eventNormalizer` class, which turns decoded Deribit channel
+ * notifications into the binary events of binaryEvents.h.
+ */
+
+#ifndef EVENTNORMALIZER_H
+#define EVENTNORMALIZER_H
+
+#include "binaryEvents.h"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class eventNormalizer
+ * @brief Converts channel notifications into concatenated binary events.
+ *
+ * Supported channels are `book.*`, `quote.*`, `trades.*`, `ticker.*` and `user.orders.*`;
+ * others produce nothing. Instrument names are mapped to dense IDs in order of first
+ * appearance, and an `instrument` event is emitted before the first event that uses a
+ * new ID. Events carry one sequence number per normalizer. Not thread-safe; the client
+ * uses it from its event loop only.
+ */
+class eventNormalizer {
+public:
+    /**
+     * @brief Constructs a normalizer with an empty instrument directory.
+     */
+    eventNormalizer();
+
+    /**
+     * @brief Normalizes one channel notification.
+     *
+     * @param channel The channel name.
+     * @param data The notification's "data" field.
+     * @param receiveTimestampNs Local receive time in nanoseconds since the epoch.
+     * @param out Receives the events, appended back to back.
+     * @return size_t The number of events appended, not counting instrument definitions.
+     */
+    size_t normalize(const std::string& channel, const nlohmann::json& data, int64_t receiveTimestampNs, std::string& out);
+
+    /**
+     * @brief Appends an `instrument` event for every known instrument.
+     *
+     * Lets a consumer that attaches late learn the directory. The events carry
+     * binaryEvents::kOutOfBand as sequence.
+     *
+     * @param out Receives the events.
+     */
+    void definitions(std::string& out) const;
+
+    /**
+     * @brief Appends an `instrument` event for every instrument a buffer of events uses.
+     *
+     * Makes a buffer self-describing for a consumer that may never see the event that
+     * first defined an ID. The events carry binaryEvents::kOutOfBand as sequence.
+     *
+     * @param events The events, as produced by normalize.
+     * @param out Receives the definitions.
+     */
+    void definitionsFor(const std::string& events, std::string& out) const;
+
+    /**
+     * @brief Gets the name of an instrument ID.
+     *
+     * @param id The instrument ID.
+     * @return const std::string& The name, or an empty string for an unknown ID.
+     */
+    const std::string& instrumentName(uint32_t id) const;
+
+private:
+    /**
+     * @brief Gets the ID of an instrument, emitting its definition on first use.
+     *
+     * @param name The instrument name.
+     * @param receiveTimestampNs Local receive time for the definition event.
+     * @param out Receives the definition event, if the instrument is new.
+     * @return uint32_t The instrument ID.
+     */
+    uint32_t instrumentId(const std::string& name, int64_t receiveTimestampNs, std::string& out);
+
+    /**
+     * @brief Starts an event of type T at the end of the buffer.
+     *
+     * @param type The event type.
+     * @param instrumentId The instrument ID.
+     * @param exchangeTimestampMs The exchange timestamp in milliseconds.
+     * @param receiveTimestampNs Local receive time in nanoseconds.
+     * @return T The zeroed event with its header filled in.
+     */
+    template <typename T>
+    T begin(binaryEvents::eventType type, uint32_t instrumentId, int64_t exchangeTimestampMs, int64_t receiveTimestampNs);
+
+    /**
+     * @brief Appends a finished event to the buffer.
+     *
+     * @param event The event.
+     * @param out The buffer.
+     */
+    template <typename T>
+    static void append(const T& event, std::string& out);
+
+    /**
+     * @brief Appends an out-of-band `instrument` event for one known instrument.
+     *
+     * @param id The instrument ID.
+     * @param out Receives the event.
+     */
+    void appendDefinition(uint32_t id, std::string& out) const;
+
+    size_t normalizeBook(const nlohmann::json& data, int64_t receiveTimestampNs, std::string& out);
+    size_t normalizeOrder(const nlohmann::json& order, int64_t receiveTimestampNs, std::string& out);
+
+    uint64_t m_sequence; ///< Sequence number of the next event.
+    std::unordered_map<std::string, uint32_t> m_ids; ///< Instrument IDs by name.
+    std::vector<std::string> m_names; ///< Instrument names by ID.
+};
+
+#endif // EVENTNORMALIZER_H
@@ -0,0 +1,112 @@
+/**
+ * @file hmacSigner.cpp
+ * @brief Implementation of the reusable HMAC-SHA256 signer.
+ */
+
+#include "hmacSigner.h"
+#include "utils.h"
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <stdexcept>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+/**
+ * @brief Keys a signer with a secret.
+ *
+ * @param secret The HMAC key (e.g., the API client secret).
+ * @throws std::runtime_error If OpenSSL cannot set up the HMAC context.
+ */
+hmacSigner::hmacSigner(const std::string& secret) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    m_mac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+    m_template = m_mac ? EVP_MAC_CTX_new(m_mac) : nullptr;
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+    if (!m_template || EVP_MAC_init(m_template, reinterpret_cast<const unsigned char*>(secret.data()), secret.size(), params) != 1) {
+        EVP_MAC_CTX_free(m_template);
+        EVP_MAC_free(m_mac);
+        throw std::runtime_error("Failed to initialize HMAC-SHA256 context");
+    }
+#else
+    m_template = HMAC_CTX_new();
+    if (!m_template || HMAC_Init_ex(m_template, secret.data(), static_cast<int>(secret.size()), EVP_sha256(), nullptr) != 1) {
+        HMAC_CTX_free(m_template);
+        throw std::runtime_error("Failed to initialize HMAC-SHA256 context");
+    }
+#endif
+}
+
+/**
+ * @brief Releases the OpenSSL contexts.
+ */
+hmacSigner::~hmacSigner() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    EVP_MAC_CTX_free(m_template);
+    EVP_MAC_free(m_mac);
+#else
+    HMAC_CTX_free(m_template);
+#endif
+}
+
+/**
+ * @brief Computes the HMAC-SHA256 of a message.
+ *
+ * @param data The message.
+ * @param length The length of the message.
+ * @param digest Receives the digest.
+ * @return True on success.
+ */
+bool hmacSigner::sign(const char* data, size_t length, unsigned char (&digest)[kDigestLength]) const {
+    const unsigned char* message = reinterpret_cast<const unsigned char*>(data);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    EVP_MAC_CTX* ctx = EVP_MAC_CTX_dup(m_template);
+    size_t digestLength = 0;
+    bool ok = ctx && EVP_MAC_update(ctx, message, length) == 1 &&
+              EVP_MAC_final(ctx, digest, &digestLength, kDigestLength) == 1;
+    EVP_MAC_CTX_free(ctx);
+    return ok && digestLength == kDigestLength;
+#else
+    HMAC_CTX* ctx = HMAC_CTX_new();
+    unsigned int digestLength = 0;
+    bool ok = ctx && HMAC_CTX_copy(ctx, m_template) == 1 && HMAC_Update(ctx, message, length) == 1 &&
+              HMAC_Final(ctx, digest, &digestLength) == 1;
+    HMAC_CTX_free(ctx);
+    return ok && digestLength == kDigestLength;
+#endif
+}
+
+/**
+ * @brief Computes the HMAC-SHA256 of a message as lowercase hex.
+ *
+ * @param data The message.
+ * @return std::string The digest in hex, or an empty string on failure.
+ */
+std::string hmacSigner::signHex(const std::string& data) const {
+    unsigned char digest[kDigestLength];
+    if (!sign(data.data(), data.size(), digest)) {
+        return std::string();
+    }
+    char hex[2 * kDigestLength];
+    utils::toHex(digest, kDigestLength, hex);
+    return std::string(hex, sizeof(hex));
+}
+
+/**
+ * @brief Computes a Deribit client signature ("timestamp\nnonce\ndata").
+ *
+ * The string to sign is built in a per-thread scratch buffer.
+ *
+ * @param timeStamp The timestamp to include in the signature.
+ * @param nonce The nonce to include in the signature.
+ * @param data Additional data to include in the signature (optional).
+ * @return std::string The client signature as a hexadecimal string.
+ */
+std::string hmacSigner::clientSignature(const std::string& timeStamp, const std::string& nonce, const std::string& data) const {
+    return signHex(utils::stringToSign(timeStamp, nonce, data));
+}
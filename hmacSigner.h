@@ -0,0 +1,89 @@
+/**
+ * @file hmacSigner.h
+ * @brief Header file for the reusable HMAC-SHA256 signer.
+ *
+ * This file defines the `hmacSigner` class, which keys HMAC-SHA256 once per secret and
+ * signs any number of messages without rehashing the key pads.
+ */
+
+#ifndef HMACSIGNER_H
+#define HMACSIGNER_H
+
+#include <openssl/opensslv.h>
+#include <cstddef>
+#include <string>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+typedef struct evp_mac_st EVP_MAC;
+typedef struct evp_mac_ctx_st EVP_MAC_CTX;
+#else
+typedef struct hmac_ctx_st HMAC_CTX;
+#endif
+
+/**
+ * @class hmacSigner
+ * @brief HMAC-SHA256 with the key schedule computed once.
+ *
+ * The constructor absorbs the secret into a template context (the inner and outer
+ * padded key blocks). Every signature clones that context and hashes only the message,
+ * using EVP_MAC on OpenSSL 3 and HMAC_CTX_copy on older versions. Signing methods are
+ * const and safe to call from several threads at once.
+ */
+class hmacSigner {
+public:
+    static constexpr size_t kDigestLength = 32; ///< Size of an HMAC-SHA256 digest.
+
+    /**
+     * @brief Keys a signer with a secret.
+     *
+     * @param secret The HMAC key (e.g., the API client secret).
+     * @throws std::runtime_error If OpenSSL cannot set up the HMAC context.
+     */
+    explicit hmacSigner(const std::string& secret);
+
+    /**
+     * @brief Releases the OpenSSL contexts.
+     */
+    ~hmacSigner();
+
+    hmacSigner(const hmacSigner&) = delete;
+    hmacSigner& operator=(const hmacSigner&) = delete;
+
+    /**
+     * @brief Computes the HMAC-SHA256 of a message.
+     *
+     * @param data The message.
+     * @param length The length of the message.
+     * @param digest Receives the digest.
+     * @return True on success.
+     */
+    bool sign(const char* data, size_t length, unsigned char (&digest)[kDigestLength]) const;
+
+    /**
+     * @brief Computes the HMAC-SHA256 of a message as lowercase hex.
+     *
+     * @param data The message.
+     * @return std::string The digest in hex, or an empty string on failure.
+     */
+    std::string signHex(const std::string& data) const;
+
+    /**
+     * @brief Computes a Deribit client signature ("timestamp\nnonce\ndata").
+     *
+     * @param timeStamp The timestamp to include in the signature.
+     * @param nonce The nonce to include in the signature.
+     * @param data [optional] Additional data to include in the signature.
+     * @return std::string The client signature as a hexadecimal string.
+     */
+    std::string clientSignature(const std::string& timeStamp, const std::string& nonce, const std::string& data = "") const;
+
+private:
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    EVP_MAC* m_mac; ///< The fetched HMAC implementation.
+    EVP_MAC_CTX* m_template; ///< Context keyed with the secret, cloned per signature.
+#else
+    HMAC_CTX* m_template; ///< Context keyed with the secret, copied per signature.
+#endif
+};
+
+#endif // HMACSIGNER_H
@@ -0,0 +1,458 @@
+/**
+ * @file instrumentKey.cpp
+ * @brief Implementation of packed instrument keys and the perfect-hash instrument index.
+ */
+
+#include "instrumentKey.h"
+#include <algorithm>
+#include <fmt/core.h> // Use fmt for formatted output
+
+namespace {
+
+    /**
+     * @brief Currency codes; the index (from 1) is the code stored in keys.
+     *
+     * Append only: codes are part of every key built so far.
+     */
+    const char* const kCurrencies[] = {
+        "BTC", "ETH", "SOL", "XRP", "MATIC", "USDC", "USDT", "EURR", "USD", "ADA",
+        "AVAX", "BNB", "DOGE", "DOT", "LINK", "LTC", "NEAR", "TRX", "UNI", "BCH",
+        "ALGO", "PAXG", "STETH", "ETHW", "USYC", "BUIDL", "TON", "SHIB", "PEPE", "WIF",
+        "TRUMP", "EUR"
+    };
+    constexpr size_t kCurrencyCount = sizeof(kCurrencies) / sizeof(kCurrencies[0]);
+    static_assert(kCurrencyCount < 64, "currency codes must fit in 6 bits");
+
+    const char* const kMonths[] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+
+    constexpr int kKindShift = 0;
+    constexpr int kBaseShift = 3;
+    constexpr int kQuoteShift = 9;
+    constexpr int kExpiryShift = 15;
+    constexpr int kDecimalsShift = 31;
+    constexpr int kStrikeShift = 33;
+    constexpr uint64_t kMaxStrikeTicks = (uint64_t(1) << 31) - 1;
+    constexpr uint32_t kPowersOfTen[] = {1, 10, 100, 1000};
+
+    /**
+     * @brief Packs up to eight characters into an integer, for single-compare matching.
+     *
+     * @param text The characters.
+     * @param length The number of characters; at most 8.
+     * @return uint64_t The packed characters.
+     */
+    constexpr uint64_t packChars(const char* text, size_t length) {
+        uint64_t packed = 0;
+        for (size_t i = 0; i < length; ++i) {
+            packed |= static_cast<uint64_t>(static_cast<unsigned char>(text[i])) << (8 * i);
+        }
+        return packed;
+    }
+
+    /**
+     * @brief Looks up a currency code.
+     *
+     * @param text The start of the code.
+     * @param length The length of the code.
+     * @return uint64_t The code (from 1), or 0 if unknown.
+     */
+    uint64_t currencyCode(const char* text, size_t length) {
+        struct packedTable {
+            uint64_t codes[kCurrencyCount];
+            packedTable() {
+                for (size_t i = 0; i < kCurrencyCount; ++i) {
+                    codes[i] = packChars(kCurrencies[i], std::char_traits<char>::length(kCurrencies[i]));
+                }
+            }
+        };
+        static const packedTable table;
+        if (length == 0 || length > 8) {
+            return 0;
+        }
+        uint64_t packed = packChars(text, length);
+        for (size_t i = 0; i < kCurrencyCount; ++i) {
+            if (table.codes[i] == packed) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Converts a civil date to days since 1970-01-01 (proleptic Gregorian).
+     *
+     * @param year The year.
+     * @param month The month, 1-12.
+     * @param day The day of the month.
+     * @return int64_t The day number.
+     */
+    int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        int64_t era = (year >= 0 ? year : year - 399) / 400;
+        unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+        unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+    }
+
+    /**
+     * @brief Converts days since 1970-01-01 to a civil date.
+     *
+     * @param days The day number.
+     * @param year Receives the year.
+     * @param month Receives the month, 1-12.
+     * @param day Receives the day of the month.
+     */
+    void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+        days += 719468;
+        int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+        unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+        day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+    }
+
+    /**
+     * @brief Parses an expiry such as "27DEC24" or "3JAN25".
+     *
+     * The day has no leading zero, as in Deribit names, so every accepted expiry formats
+     * back to the same text.
+     *
+     * @param text The start of the expiry.
+     * @param length The length of the expiry.
+     * @param days Receives the expiry in days since 1970-01-01.
+     * @return True if the expiry is valid.
+     */
+    bool parseExpiry(const char* text, size_t length, uint32_t& days) {
+        size_t dayDigits = length == 6 ? 1 : length == 7 ? 2 : 0;
+        if (dayDigits == 0 || text[0] < '1' || text[0] > '9') {
+            return false;
+        }
+        unsigned day = static_cast<unsigned>(text[0] - '0');
+        if (dayDigits == 2) {
+            if (text[1] < '0' || text[1] > '9') {
+                return false;
+            }
+            day = day * 10 + static_cast<unsigned>(text[1] - '0');
+        }
+        const char* month = text + dayDigits;
+        uint64_t packedMonth = packChars(month, 3);
+        unsigned monthNumber = 0;
+        for (unsigned i = 0; i < 12; ++i) {
+            if (packChars(kMonths[i], 3) == packedMonth) {
+                monthNumber = i + 1;
+                break;
+            }
+        }
+        const char* year = month + 3;
+        if (monthNumber == 0 || year[0] < '0' || year[0] > '9' || year[1] < '0' || year[1] > '9') {
+            return false;
+        }
+        int64_t fullYear = 2000 + (year[0] - '0') * 10 + (year[1] - '0');
+
+        // Reject days past the end of the month (e.g. 31FEB25); 2000-2099 leap years are every 4th
+        static const unsigned kMonthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        unsigned monthDays = kMonthDays[monthNumber - 1] + (monthNumber == 2 && fullYear % 4 == 0 ? 1 : 0);
+        if (day > monthDays) {
+            return false;
+        }
+        days = static_cast<uint32_t>(daysFromCivil(fullYear, monthNumber, day));
+        return true;
+    }
+
+    /**
+     * @brief Parses a strike such as "50000" or "0d625" ('d' is Deribit's decimal point).
+     *
+     * @param text The start of the strike.
+     * @param length The length of the strike.
+     * @param ticks Receives the strike in ticks of 10^-decimals.
+     * @param decimals Receives the number of digits after 'd' (0-3).
+     * @return True if the strike is valid and formats back to the same text.
+     */
+    bool parseStrike(const char* text, size_t length, uint64_t& ticks, uint64_t& decimals) {
+        ticks = 0;
+        decimals = 0;
+        size_t integerDigits = 0;
+        bool fraction = false;
+        for (size_t i = 0; i < length; ++i) {
+            char c = text[i];
+            if (c == 'd' && !fraction && integerDigits > 0) {
+                fraction = true;
+                continue;
+            }
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            if (fraction) {
+                ++decimals;
+            } else {
+                if (integerDigits == 1 && text[0] == '0') {
+                    return false; // Leading zero
+                }
+                ++integerDigits;
+            }
+            ticks = ticks * 10 + static_cast<uint64_t>(c - '0');
+            if (ticks > kMaxStrikeTicks) {
+                return false;
+            }
+        }
+        return integerDigits > 0 && decimals <= 3 && (!fraction || decimals > 0);
+    }
+}
+
+namespace instrumentKey {
+
+    /**
+     * @brief Parses an instrument name.
+     *
+     * Accepts `BASE[_QUOTE]` spot pairs and `BASE[_QUOTE]-PERPETUAL`, `-EXPIRY` and
+     * `-EXPIRY-STRIKE-C|P` derivatives; combos and unknown currencies are rejected.
+     *
+     * @param name The start of the name; need not be NUL-terminated.
+     * @param length The length of the name.
+     * @param key Receives the key.
+     * @return True if the name was recognized.
+     */
+    bool parse(const char* name, size_t length, uint64_t& key) {
+        const char* end = name + length;
+        const char* dash = std::find(name, end, '-');
+        const char* underscore = std::find(name, dash, '_');
+
+        uint64_t base = currencyCode(name, static_cast<size_t>(underscore - name));
+        uint64_t quote = 0;
+        if (underscore != dash) {
+            quote = currencyCode(underscore + 1, static_cast<size_t>(dash - underscore - 1));
+            if (quote == 0) {
+                return false;
+            }
+        }
+        if (base == 0) {
+            return false;
+        }
+        uint64_t packed = (base << kBaseShift) | (quote << kQuoteShift);
+
+        if (dash == end) {
+            if (quote == 0) {
+                return false; // Spot names always have a quote currency
+            }
+            key = packed | (static_cast<uint64_t>(kind::spot) << kKindShift);
+            return true;
+        }
+
+        const char* rest = dash + 1;
+        size_t restLength = static_cast<size_t>(end - rest);
+        if (restLength == 9 && std::char_traits<char>::compare(rest, "PERPETUAL", 9) == 0) {
+            key = packed | (static_cast<uint64_t>(kind::perpetual) << kKindShift);
+            return true;
+        }
+
+        const char* expiryEnd = std::find(rest, end, '-');
+        uint32_t days = 0;
+        if (!parseExpiry(rest, static_cast<size_t>(expiryEnd - rest), days)) {
+            return false;
+        }
+        packed |= static_cast<uint64_t>(days) << kExpiryShift;
+        if (expiryEnd == end) {
+            key = packed | (static_cast<uint64_t>(kind::future) << kKindShift);
+            return true;
+        }
+
+        // Option: the name ends in -STRIKE-C or -STRIKE-P
+        if (end - expiryEnd < 4 || end[-2] != '-' || (end[-1] != 'C' && end[-1] != 'P')) {
+            return false;
+        }
+        uint64_t ticks = 0;
+        uint64_t decimals = 0;
+        if (!parseStrike(expiryEnd + 1, static_cast<size_t>(end - 2 - expiryEnd - 1), ticks, decimals)) {
+            return false;
+        }
+        kind optionKind = end[-1] == 'C' ? kind::call : kind::put;
+        key = packed | (decimals << kDecimalsShift) | (ticks << kStrikeShift) |
+              (static_cast<uint64_t>(optionKind) << kKindShift);
+        return true;
+    }
+
+    /**
+     * @brief Parses an instrument name.
+     *
+     * @param name The name.
+     * @param key Receives the key.
+     * @return True if the name was recognized.
+     */
+    bool parse(const std::string& name, uint64_t& key) {
+        return parse(name.data(), name.size(), key);
+    }
+
+    /**
+     * @brief Formats a key back into its instrument name.
+     *
+     * @param key The key.
+     * @return std::string The name, or an empty string for an invalid key.
+     */
+    std::string format(uint64_t key) {
+        uint64_t kindValue = (key >> kKindShift) & 0x7;
+        uint64_t base = (key >> kBaseShift) & 0x3f;
+        uint64_t quote = (key >> kQuoteShift) & 0x3f;
+        if (kindValue < static_cast<uint64_t>(kind::spot) || kindValue > static_cast<uint64_t>(kind::put) ||
+            base == 0 || base > kCurrencyCount || quote > kCurrencyCount) {
+            return std::string();
+        }
+        std::string name = kCurrencies[base - 1];
+        if (quote != 0) {
+            name += '_';
+            name += kCurrencies[quote - 1];
+        }
+        kind instrumentKind = static_cast<kind>(kindValue);
+        if (instrumentKind == kind::spot) {
+            return name;
+        }
+        if (instrumentKind == kind::perpetual) {
+            return name + "-PERPETUAL";
+        }
+
+        int64_t year;
+        unsigned month;
+        unsigned day;
+        civilFromDays(expiryDays(key), year, month, day);
+        name += fmt::format("-{}{}{:02}", day, kMonths[month - 1], year % 100);
+        if (instrumentKind == kind::future) {
+            return name;
+        }
+
+        uint64_t decimals = (key >> kDecimalsShift) & 0x3;
+        uint64_t ticks = key >> kStrikeShift;
+        uint64_t scale = kPowersOfTen[decimals];
+        if (decimals == 0) {
+            name += fmt::format("-{}", ticks);
+        } else {
+            name += fmt::format("-{}d{:0{}}", ticks / scale, ticks % scale, static_cast<int>(decimals));
+        }
+        name += instrumentKind == kind::call ? "-C" : "-P";
+        return name;
+    }
+
+    /**
+     * @brief Gets the strike of an option key.
+     *
+     * @param key The key.
+     * @return double The strike, or 0 for other kinds.
+     */
+    double strike(uint64_t key) {
+        kind instrumentKind = kindOf(key);
+        if (instrumentKind != kind::call && instrumentKind != kind::put) {
+            return 0.0;
+        }
+        return static_cast<double>(key >> kStrikeShift) / kPowersOfTen[(key >> kDecimalsShift) & 0x3];
+    }
+}
+
+/**
+ * @brief Constructs an empty index.
+ */
+instrumentIndex::instrumentIndex() : m_bucketShift(63), m_slotMask(0), m_size(0) {}
+
+/**
+ * @brief Builds the index.
+ *
+ * Buckets average four keys and the table is at most 80% full. Buckets are placed
+ * largest first; each tries seeds until all its keys land in free, distinct slots.
+ *
+ * @param keys The keys; key i gets ID i.
+ * @return False if a key is 0 or appears twice; the index is then empty.
+ */
+bool instrumentIndex::build(const std::vector<uint64_t>& keys) {
+    m_seeds.clear();
+    m_keys.clear();
+    m_ids.clear();
+    m_size = 0;
+    if (keys.empty()) {
+        return true;
+    }
+    std::vector<uint64_t> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.front() == 0 || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        return false;
+    }
+
+    unsigned bucketBits = 1;
+    while ((size_t(1) << bucketBits) * 4 < keys.size()) {
+        ++bucketBits;
+    }
+    size_t slotCount = 1;
+    while (slotCount * 4 < keys.size() * 5) {
+        slotCount <<= 1;
+    }
+    unsigned shift = 64 - bucketBits;
+
+    std::vector<std::vector<uint32_t>> buckets(size_t(1) << bucketBits);
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        buckets[instrumentKey::hash(keys[i]) >> shift].push_back(i);
+    }
+    std::vector<uint32_t> order(buckets.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    for (;;) {
+        std::vector<uint64_t> seeds(buckets.size(), 0);
+        std::vector<uint64_t> slots(slotCount, 0);
+        std::vector<uint32_t> ids(slotCount, 0);
+        uint64_t mask = slotCount - 1;
+        bool placed = true;
+        std::vector<size_t> chosen;
+        for (uint32_t bucket : order) {
+            const std::vector<uint32_t>& members = buckets[bucket];
+            if (members.empty()) {
+                break; // Sorted by size: the rest are empty too
+            }
+            bool found = false;
+            for (uint64_t attempt = 0; attempt < (uint64_t(1) << 16) && !found; ++attempt) {
+                uint64_t seed = attempt * 0x9e3779b97f4a7c15ULL;
+                chosen.clear();
+                found = true;
+                for (uint32_t member : members) {
+                    size_t slot = static_cast<size_t>(instrumentKey::hash(keys[member] ^ seed) & mask);
+                    if (slots[slot] != 0 || std::find(chosen.begin(), chosen.end(), slot) != chosen.end()) {
+                        found = false;
+                        break;
+                    }
+                    chosen.push_back(slot);
+                }
+                if (found) {
+                    seeds[bucket] = seed;
+                    for (size_t i = 0; i < members.size(); ++i) {
+                        slots[chosen[i]] = keys[members[i]];
+                        ids[chosen[i]] = members[i];
+                    }
+                }
+            }
+            if (!found) {
+                placed = false;
+                break;
+            }
+        }
+        if (placed) {
+            m_seeds = std::move(seeds);
+            m_keys = std::move(slots);
+            m_ids = std::move(ids);
+            m_bucketShift = shift;
+            m_slotMask = mask;
+            m_size = keys.size();
+            return true;
+        }
+        slotCount <<= 1; // Give up on this load factor and retry with more room
+    }
+}
+
+/**
+ * @brief Gets the number of keys in the index.
+ *
+ * @return size_t The count.
+ */
+size_t instrumentIndex::size() const {
+    return m_size;
+}
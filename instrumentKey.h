@@ -0,0 +1,194 @@
+/**
+ * @file instrumentKey.h
+ * @brief Header file for packed instrument keys.
+ *
+ * This file declares the functions that parse Deribit instrument names (e.g.,
+ * "BTC-PERPETUAL", "BTC-27DEC24", "BTC-27DEC24-50000-C", "XRP_USDC-30AUG24-0d625-P",
+ * "BTC_USDC") into 64-bit keys and format keys back into names, and the `instrumentIndex`
+ * class, a perfect-hash map from keys to dense IDs.
+ */
+
+#ifndef INSTRUMENTKEY_H
+#define INSTRUMENTKEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Packed instrument keys.
+ *
+ * Layout, from the least significant bit:
+ *   - bits 0-2: kind (spot, perpetual, future, call, put); never 0, so 0 is not a key
+ *   - bits 3-8: base currency
+ *   - bits 9-14: quote currency of linear instruments, 0 for inverse ones
+ *   - bits 15-30: expiry in days since 1970-01-01, 0 if none
+ *   - bits 31-32: number of strike decimals (the digits after 'd')
+ *   - bits 33-63: strike in ticks of 10^-decimals
+ *
+ * A key identifies an instrument exactly: two names have the same key only if they are the
+ * same name, so keys can be hashed and compared instead of strings. Names the parser does
+ * not know (combos, unknown currencies) are rejected, and callers keep the string.
+ */
+namespace instrumentKey {
+
+    /**
+     * @brief Instrument kind stored in the key.
+     */
+    enum class kind : uint8_t {
+        spot = 1,       ///< Spot pair, e.g. "BTC_USDC".
+        perpetual = 2,  ///< Perpetual future, e.g. "BTC-PERPETUAL".
+        future = 3,     ///< Dated future, e.g. "BTC-27DEC24".
+        call = 4,       ///< Call option, e.g. "BTC-27DEC24-50000-C".
+        put = 5         ///< Put option, e.g. "BTC-27DEC24-50000-P".
+    };
+
+    /**
+     * @brief Parses an instrument name.
+     *
+     * @param name The start of the name; need not be NUL-terminated.
+     * @param length The length of the name.
+     * @param key Receives the key.
+     * @return True if the name was recognized.
+     */
+    bool parse(const char* name, size_t length, uint64_t& key);
+
+    /**
+     * @brief Parses an instrument name.
+     *
+     * @param name The name.
+     * @param key Receives the key.
+     * @return True if the name was recognized.
+     */
+    bool parse(const std::string& name, uint64_t& key);
+
+    /**
+     * @brief Formats a key back into its instrument name.
+     *
+     * @param key The key.
+     * @return std::string The name, or an empty string for an invalid key.
+     */
+    std::string format(uint64_t key);
+
+    /**
+     * @brief Gets the kind of a key.
+     *
+     * @param key The key.
+     * @return kind The kind.
+     */
+    inline kind kindOf(uint64_t key) {
+        return static_cast<kind>(key & 0x7);
+    }
+
+    /**
+     * @brief Gets the expiry of a key.
+     *
+     * @param key The key.
+     * @return uint32_t Days since 1970-01-01, or 0 for spot and perpetuals.
+     */
+    inline uint32_t expiryDays(uint64_t key) {
+        return static_cast<uint32_t>((key >> 15) & 0xffff);
+    }
+
+    /**
+     * @brief Checks whether a key is an inverse future or perpetual.
+     *
+     * Inverse contracts (e.g., "BTC-PERPETUAL") have amounts in USD and settle in the base
+     * coin; linear ones (e.g., "BTC_USDC-PERPETUAL") carry a quote currency.
+     *
+     * @param key The key.
+     * @return True for inverse futures and perpetuals.
+     */
+    inline bool isInverse(uint64_t key) {
+        kind k = kindOf(key);
+        return (k == kind::perpetual || k == kind::future) && ((key >> 9) & 0x3f) == 0;
+    }
+
+    /**
+     * @brief Gets the strike of an option key.
+     *
+     * @param key The key.
+     * @return double The strike, or 0 for other kinds.
+     */
+    double strike(uint64_t key);
+
+    /**
+     * @brief Mixes a key into a well-distributed hash.
+     *
+     * The low bits of a key are the kind and currency, which make poor table indexes.
+     *
+     * @param key The key.
+     * @return uint64_t The hash.
+     */
+    inline uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+}
+
+/**
+ * @class instrumentIndex
+ * @brief Perfect-hash map from instrument keys to dense IDs for a fixed set of instruments.
+ *
+ * Built once with hash-and-displace: keys are grouped into buckets, and each bucket gets a
+ * seed under which all its keys land in free slots. A lookup is two hashes, two loads and
+ * one compare, with no probing. IDs are the positions of the keys in the build list.
+ * Lookups are read-only and may run on any thread once `build` has returned.
+ */
+class instrumentIndex {
+public:
+    /**
+     * @brief Constructs an empty index.
+     */
+    instrumentIndex();
+
+    /**
+     * @brief Builds the index.
+     *
+     * @param keys The keys; key i gets ID i.
+     * @return False if a key is 0 or appears twice; the index is then empty.
+     */
+    bool build(const std::vector<uint64_t>& keys);
+
+    /**
+     * @brief Looks up a key.
+     *
+     * @param key The key.
+     * @param id Receives the dense ID.
+     * @return True if the key is in the index.
+     */
+    bool find(uint64_t key, uint32_t& id) const {
+        if (m_keys.empty()) {
+            return false;
+        }
+        uint64_t seed = m_seeds[instrumentKey::hash(key) >> m_bucketShift];
+        size_t slot = static_cast<size_t>(instrumentKey::hash(key ^ seed) & m_slotMask);
+        if (m_keys[slot] != key) {
+            return false;
+        }
+        id = m_ids[slot];
+        return true;
+    }
+
+    /**
+     * @brief Gets the number of keys in the index.
+     *
+     * @return size_t The count.
+     */
+    size_t size() const;
+
+private:
+    std::vector<uint64_t> m_seeds; ///< Displacement seed per bucket.
+    std::vector<uint64_t> m_keys; ///< Key per slot, 0 for a free slot.
+    std::vector<uint32_t> m_ids; ///< Dense ID per slot.
+    unsigned m_bucketShift; ///< 64 - log2(bucket count); buckets use the high hash bits.
+    uint64_t m_slotMask; ///< Slot count - 1.
+    size_t m_size; ///< Number of keys.
+};
+
+#endif // INSTRUMENTKEY_H
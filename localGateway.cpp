@@ -0,0 +1,376 @@
+/**
+ * @file localGateway.cpp
+ * @brief Implementation of the local WebSocket fan-out gateway.
+ */
+
+#include "localGateway.h"
+#include <fmt/core.h> // Use fmt for formatted output
+
+namespace {
+
+    /**
+     * @brief Builds a prepared, unmasked, final frame.
+     *
+     * Server-to-client frames carry no mask, so the same bytes are valid on every
+     * connection and websocketpp sends prepared messages as they are.
+     *
+     * @param opcode The frame opcode (text or binary).
+     * @param payload The payload.
+     * @return localGateway::server::message_ptr The frame.
+     */
+    localGateway::server::message_ptr preparedFrame(websocketpp::frame::opcode::value opcode, const std::string& payload) {
+        size_t length = payload.size();
+        std::string header(1, static_cast<char>(0x80 | opcode)); // FIN + opcode
+        if (length < 126) {
+            header.push_back(static_cast<char>(length));
+        } else if (length <= 0xffff) {
+            header.push_back(static_cast<char>(126));
+            header.push_back(static_cast<char>((length >> 8) & 0xff));
+            header.push_back(static_cast<char>(length & 0xff));
+        } else {
+            header.push_back(static_cast<char>(127));
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                header.push_back(static_cast<char>((static_cast<uint64_t>(length) >> shift) & 0xff));
+            }
+        }
+        auto frame = websocketpp::lib::make_shared<localGateway::server::message_type>(nullptr, opcode, length);
+        frame->set_header(header);
+        frame->get_raw_payload().assign(payload);
+        frame->set_prepared(true);
+        return frame;
+    }
+}
+
+/**
+ * @brief Constructs a gateway on an io_service.
+ *
+ * @param ioService The io_service that runs the client's event loop.
+ * @param acquire Called with channels that got their first downstream subscriber.
+ * @param release Called with channels that lost their last downstream subscriber.
+ */
+localGateway::localGateway(boost::asio::io_service& ioService, channelsHandler acquire, channelsHandler release)
+    : m_acquire(std::move(acquire)),
+      m_release(std::move(release)),
+      m_listening(false),
+      m_connectionCount(0),
+      m_channelCount(0),
+      m_framesIn(0),
+      m_framesOut(0) {
+    m_server.clear_access_channels(websocketpp::log::alevel::all);
+    m_server.clear_error_channels(websocketpp::log::elevel::all);
+    m_server.init_asio(&ioService);
+    m_server.set_reuse_addr(true);
+    m_server.set_open_handler([this](websocketpp::connection_hdl hdl) { on_open(hdl); });
+    m_server.set_close_handler([this](websocketpp::connection_hdl hdl) { on_close(hdl); });
+    m_server.set_message_handler([this](websocketpp::connection_hdl hdl, server::message_ptr msg) { on_message(hdl, msg); });
+}
+
+/**
+ * @brief Stops listening and closes all downstream connections.
+ */
+localGateway::~localGateway() {
+    stop();
+}
+
+/**
+ * @brief Starts accepting connections on 127.0.0.1.
+ *
+ * @param port The TCP port.
+ * @return True if the gateway is listening.
+ */
+bool localGateway::start(uint16_t port) {
+    websocketpp::lib::error_code ec;
+    m_server.listen("127.0.0.1", std::to_string(port), ec);
+    if (ec) {
+        fmt::print(stderr, "Gateway listen error: {}\n", ec.message());
+        return false;
+    }
+    m_server.start_accept(ec);
+    if (ec) {
+        fmt::print(stderr, "Gateway accept error: {}\n", ec.message());
+        return false;
+    }
+    m_listening = true;
+    return true;
+}
+
+/**
+ * @brief Stops listening and closes all downstream connections.
+ */
+void localGateway::stop() {
+    websocketpp::lib::error_code ec;
+    if (m_listening) {
+        m_server.stop_listening(ec);
+        m_listening = false;
+    }
+    for (const auto& connection : m_connections) {
+        m_server.close(connection.first, websocketpp::close::status::going_away, "Gateway stopping", ec);
+    }
+}
+
+/**
+ * @brief Sends an upstream frame to every downstream subscriber of its channel.
+ *
+ * Each form of the frame (JSON, binary) is built once into a prepared message that all
+ * connections wanting that form send from the same buffer.
+ *
+ * @param channel The channel the frame arrived on.
+ * @param payload The frame exactly as received from upstream.
+ * @param events The frame's normalized binary events, for binary-mode connections.
+ * @param length The length of `events` in bytes; 0 if the channel has no binary form.
+ */
+void localGateway::publish(const std::string& channel, const std::string& payload, const char* events, size_t length) {
+    std::string data;
+    splitDefinitions(events, length, data);
+    auto it = m_subscribers.find(channel);
+    if (it == m_subscribers.end() || it->second.empty()) {
+        return;
+    }
+    ++m_framesIn;
+    server::message_ptr text;
+    server::message_ptr binary;
+    for (const websocketpp::connection_hdl& hdl : it->second) {
+        auto connection = m_connections.find(hdl);
+        server::message_ptr frame;
+        if (connection != m_connections.end() && connection->second.binary && !data.empty()) {
+            if (!binary) {
+                binary = preparedFrame(websocketpp::frame::opcode::binary, data);
+            }
+            frame = binary;
+        } else {
+            if (!text) {
+                text = preparedFrame(websocketpp::frame::opcode::text, payload);
+            }
+            frame = text;
+        }
+        websocketpp::lib::error_code ec;
+        m_server.send(hdl, frame, ec);
+        if (!ec) {
+            ++m_framesOut;
+        }
+    }
+}
+
+/**
+ * @brief Records instrument definitions that binary-mode connections must know.
+ *
+ * @param events Concatenated binary events; only `instrument` events are kept.
+ * @param length The length of `events` in bytes.
+ */
+void localGateway::addDefinitions(const char* events, size_t length) {
+    std::string data;
+    splitDefinitions(events, length, data);
+}
+
+/**
+ * @brief Gets the gateway counters.
+ *
+ * @return gatewayStats The counters.
+ */
+gatewayStats localGateway::stats() const {
+    gatewayStats stats;
+    stats.connections = m_connectionCount;
+    stats.channels = m_channelCount;
+    stats.framesIn = m_framesIn;
+    stats.framesOut = m_framesOut;
+    return stats;
+}
+
+/**
+ * @brief Registers a new downstream connection.
+ *
+ * @param hdl The connection handle.
+ */
+void localGateway::on_open(websocketpp::connection_hdl hdl) {
+    m_connections[hdl];
+    m_connectionCount = m_connections.size();
+}
+
+/**
+ * @brief Drops a downstream connection and releases its channels.
+ *
+ * @param hdl The connection handle.
+ */
+void localGateway::on_close(websocketpp::connection_hdl hdl) {
+    auto it = m_connections.find(hdl);
+    if (it == m_connections.end()) {
+        return;
+    }
+    std::vector<std::string> released;
+    for (const std::string& channel : it->second.channels) {
+        auto subscribers = m_subscribers.find(channel);
+        if (subscribers == m_subscribers.end()) {
+            continue;
+        }
+        subscribers->second.erase(hdl);
+        if (subscribers->second.empty()) {
+            m_subscribers.erase(subscribers);
+            released.push_back(channel);
+        }
+    }
+    m_connections.erase(it);
+    m_connectionCount = m_connections.size();
+    m_channelCount = m_subscribers.size();
+    if (!released.empty()) {
+        m_release(released);
+    }
+}
+
+/**
+ * @brief Handles a JSON-RPC request from a downstream connection.
+ *
+ * @param hdl The connection handle.
+ * @param msg The received message.
+ */
+void localGateway::on_message(websocketpp::connection_hdl hdl, server::message_ptr msg) {
+    nlohmann::json request = nlohmann::json::parse(msg->get_payload(), nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        reply(hdl, {{"jsonrpc", "2.0"}, {"id", nullptr}, {"error", {{"code", -32700}, {"message", "Parse error"}}}});
+        return;
+    }
+    std::string method = request.value("method", "");
+    if (method == "public/subscribe") {
+        updateSubscriptions(hdl, request, true);
+    } else if (method == "public/unsubscribe") {
+        updateSubscriptions(hdl, request, false);
+    } else if (method == "gateway/set_format") {
+        setFormat(hdl, request);
+    } else {
+        reply(hdl, {{"jsonrpc", "2.0"}, {"id", request.value("id", nlohmann::json())},
+                    {"error", {{"code", -32601}, {"message", "Method not supported by the gateway: " + method}}}});
+    }
+}
+
+/**
+ * @brief Adds or removes a connection's subscriptions and replies to the request.
+ *
+ * The reply lists the channels the connection is now (un)subscribed from, as Deribit
+ * does. Upstream acknowledgement is not awaited; data flows once it arrives.
+ *
+ * @param hdl The downstream connection.
+ * @param request The JSON-RPC request.
+ * @param subscribe True for subscribe, false for unsubscribe.
+ */
+void localGateway::updateSubscriptions(websocketpp::connection_hdl hdl, const nlohmann::json& request, bool subscribe) {
+    auto connection = m_connections.find(hdl);
+    if (connection == m_connections.end()) {
+        return;
+    }
+    nlohmann::json result = nlohmann::json::array();
+    std::vector<std::string> changed;
+    if (request.contains("params") && request["params"].contains("channels") && request["params"]["channels"].is_array()) {
+        for (const auto& item : request["params"]["channels"]) {
+            if (!item.is_string()) {
+                continue;
+            }
+            std::string channel = item.get<std::string>();
+            if (channel.rfind("user.", 0) == 0) {
+                continue; // Account data stays with this process
+            }
+            if (subscribe) {
+                connectionSet& subscribers = m_subscribers[channel];
+                if (subscribers.empty()) {
+                    changed.push_back(channel);
+                }
+                subscribers.insert(hdl);
+                connection->second.channels.insert(channel);
+            } else if (connection->second.channels.erase(channel) != 0) {
+                auto subscribers = m_subscribers.find(channel);
+                subscribers->second.erase(hdl);
+                if (subscribers->second.empty()) {
+                    m_subscribers.erase(subscribers);
+                    changed.push_back(channel);
+                }
+            }
+            result.push_back(channel);
+        }
+    }
+    m_channelCount = m_subscribers.size();
+    reply(hdl, {{"jsonrpc", "2.0"}, {"id", request.value("id", nlohmann::json())}, {"result", result}});
+    if (!changed.empty()) {
+        (subscribe ? m_acquire : m_release)(changed);
+    }
+}
+
+/**
+ * @brief Switches a connection between JSON and binary frames and replies.
+ *
+ * Expects `{"format": "binary"}` or `{"format": "json"}` as params. A connection that
+ * switches to binary first receives every instrument definition known so far.
+ *
+ * @param hdl The downstream connection.
+ * @param request The JSON-RPC request.
+ */
+void localGateway::setFormat(websocketpp::connection_hdl hdl, const nlohmann::json& request) {
+    auto connection = m_connections.find(hdl);
+    if (connection == m_connections.end()) {
+        return;
+    }
+    std::string format;
+    if (request.contains("params") && request["params"].is_object()) {
+        format = request["params"].value("format", "");
+    }
+    if (format != "binary" && format != "json") {
+        reply(hdl, {{"jsonrpc", "2.0"}, {"id", request.value("id", nlohmann::json())},
+                    {"error", {{"code", -32602}, {"message", "format must be \"binary\" or \"json\""}}}});
+        return;
+    }
+    bool binary = format == "binary";
+    reply(hdl, {{"jsonrpc", "2.0"}, {"id", request.value("id", nlohmann::json())},
+                {"result", {{"format", format}, {"schema_version", binaryEvents::kSchemaVersion}}}});
+    if (binary && !connection->second.binary && !m_definitions.empty()) {
+        websocketpp::lib::error_code ec;
+        m_server.send(hdl, preparedFrame(websocketpp::frame::opcode::binary, m_definitions), ec);
+    }
+    connection->second.binary = binary;
+}
+
+/**
+ * @brief Splits instrument definitions off a buffer of binary events.
+ *
+ * New definitions are cached and sent to every binary-mode connection, whether or not it
+ * subscribed to the channel, so IDs are always defined before a connection sees them.
+ *
+ * @param events Concatenated binary events.
+ * @param length The length of `events` in bytes.
+ * @param data Receives the remaining (non-definition) events.
+ */
+void localGateway::splitDefinitions(const char* events, size_t length, std::string& data) {
+    std::string added;
+    const char* cursor = events;
+    const char* end = events + length;
+    binaryEvents::eventHeader header;
+    while (const char* event = binaryEvents::nextEvent(cursor, end, header)) {
+        if (header.type != binaryEvents::eventType::instrument) {
+            data.append(event, header.size);
+        } else if (m_definedIds.insert(header.instrumentId).second) {
+            added.append(event, header.size);
+        }
+    }
+    if (added.empty()) {
+        return;
+    }
+    m_definitions += added;
+    server::message_ptr frame;
+    for (const auto& connection : m_connections) {
+        if (!connection.second.binary) {
+            continue;
+        }
+        if (!frame) {
+            frame = preparedFrame(websocketpp::frame::opcode::binary, added);
+        }
+        websocketpp::lib::error_code ec;
+        m_server.send(connection.first, frame, ec);
+    }
+}
+
+/**
+ * @brief Sends a JSON-RPC reply to one connection.
+ *
+ * @param hdl The downstream connection.
+ * @param reply The reply.
+ */
+void localGateway::reply(websocketpp::connection_hdl hdl, const nlohmann::json& reply) {
+    websocketpp::lib::error_code ec;
+    m_server.send(hdl, reply.dump(), websocketpp::frame::opcode::text, ec);
+}
@@ -0,0 +1,204 @@
+/**
+ * @file localGateway.h
+ * @brief Header file for the local WebSocket fan-out gateway.
+ *
+ * This file defines the `localGateway` class, a WebSocket server for processes on the
+ * same host. They subscribe to Deribit channels through it, and the gateway shares the
+ * client's single upstream connection between them.
+ */
+
+#ifndef LOCALGATEWAY_H
+#define LOCALGATEWAY_H
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+#include "binaryEvents.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Counters of the local gateway.
+ */
+struct gatewayStats {
+    size_t connections = 0;     ///< Downstream connections open.
+    size_t channels = 0;        ///< Channels with at least one downstream subscriber.
+    uint64_t framesIn = 0;      ///< Upstream frames offered for fan-out.
+    uint64_t framesOut = 0;     ///< Frames sent to downstream connections.
+};
+
+/**
+ * @class localGateway
+ * @brief Fans upstream channel frames out to local WebSocket clients.
+ *
+ * Downstream clients speak the subset of Deribit's JSON-RPC they need for market data:
+ * `public/subscribe` and `public/unsubscribe`. Subscriptions are reference-counted per
+ * channel; only the first subscriber of a channel triggers an upstream subscribe and only
+ * the last one leaving triggers an upstream unsubscribe. Each upstream frame is framed
+ * once into a prepared message that every subscribed connection sends from the same
+ * buffer. Private (`user.*`) channels are not forwarded.
+ *
+ * A connection can switch to binary mode with `gateway/set_format`; it then receives the
+ * normalized events of binaryEvents.h as binary frames instead of the JSON notifications,
+ * plus every `instrument` definition as it appears (and the known ones on switching).
+ * Channels without a binary form are still sent as JSON.
+ *
+ * The gateway runs on the io_service it is given (the client's event loop), so handlers
+ * and `publish` run on one thread and need no locking; only `stats` may be called from
+ * other threads. It listens on the loopback interface only.
+ */
+class localGateway {
+public:
+    using server = websocketpp::server<websocketpp::config::asio>; ///< Plain WebSocket server endpoint.
+    using channelsHandler = std::function<void(const std::vector<std::string>&)>; ///< Upstream (un)subscribe hook.
+
+    /**
+     * @brief Constructs a gateway on an io_service.
+     *
+     * @param ioService The io_service that runs the client's event loop.
+     * @param acquire Called with channels that got their first downstream subscriber.
+     * @param release Called with channels that lost their last downstream subscriber.
+     */
+    localGateway(boost::asio::io_service& ioService, channelsHandler acquire, channelsHandler release);
+
+    /**
+     * @brief Stops listening and closes all downstream connections.
+     */
+    ~localGateway();
+
+    localGateway(const localGateway&) = delete;
+    localGateway& operator=(const localGateway&) = delete;
+
+    /**
+     * @brief Starts accepting connections on 127.0.0.1.
+     *
+     * @param port The TCP port.
+     * @return True if the gateway is listening.
+     */
+    bool start(uint16_t port);
+
+    /**
+     * @brief Stops listening and closes all downstream connections.
+     */
+    void stop();
+
+    /**
+     * @brief Sends an upstream frame to every downstream subscriber of its channel.
+     *
+     * Must be called on the event loop.
+     *
+     * @param channel The channel the frame arrived on.
+     * @param payload The frame exactly as received from upstream.
+     * @param events The frame's normalized binary events, for binary-mode connections.
+     * @param length The length of `events` in bytes; 0 if the channel has no binary form.
+     */
+    void publish(const std::string& channel, const std::string& payload, const char* events, size_t length);
+
+    /**
+     * @brief Records instrument definitions that binary-mode connections must know.
+     *
+     * Used to seed a gateway started after the normalizer already assigned IDs. Must be
+     * called on the event loop.
+     *
+     * @param events Concatenated binary events; only `instrument` events are kept.
+     * @param length The length of `events` in bytes.
+     */
+    void addDefinitions(const char* events, size_t length);
+
+    /**
+     * @brief Gets the gateway counters.
+     *
+     * @return gatewayStats The counters.
+     */
+    gatewayStats stats() const;
+
+private:
+    /**
+     * @brief Registers a new downstream connection.
+     *
+     * @param hdl The connection handle.
+     */
+    void on_open(websocketpp::connection_hdl hdl);
+
+    /**
+     * @brief Drops a downstream connection and releases its channels.
+     *
+     * @param hdl The connection handle.
+     */
+    void on_close(websocketpp::connection_hdl hdl);
+
+    /**
+     * @brief Handles a JSON-RPC request from a downstream connection.
+     *
+     * @param hdl The connection handle.
+     * @param msg The received message.
+     */
+    void on_message(websocketpp::connection_hdl hdl, server::message_ptr msg);
+
+    /**
+     * @brief Adds or removes a connection's subscriptions and replies to the request.
+     *
+     * @param hdl The downstream connection.
+     * @param request The JSON-RPC request.
+     * @param subscribe True for subscribe, false for unsubscribe.
+     */
+    void updateSubscriptions(websocketpp::connection_hdl hdl, const nlohmann::json& request, bool subscribe);
+
+    /**
+     * @brief Switches a connection between JSON and binary frames and replies.
+     *
+     * @param hdl The downstream connection.
+     * @param request The JSON-RPC request.
+     */
+    void setFormat(websocketpp::connection_hdl hdl, const nlohmann::json& request);
+
+    /**
+     * @brief Splits instrument definitions off a buffer of binary events.
+     *
+     * New definitions are cached and sent to every binary-mode connection.
+     *
+     * @param events Concatenated binary events.
+     * @param length The length of `events` in bytes.
+     * @param data Receives the remaining (non-definition) events.
+     */
+    void splitDefinitions(const char* events, size_t length, std::string& data);
+
+    /**
+     * @brief Sends a JSON-RPC reply to one connection.
+     *
+     * @param hdl The downstream connection.
+     * @param reply The reply.
+     */
+    void reply(websocketpp::connection_hdl hdl, const nlohmann::json& reply);
+
+    using connectionSet = std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>>;
+
+    /**
+     * @brief State of one downstream connection.
+     */
+    struct connectionState {
+        std::set<std::string> channels; ///< Channels the connection subscribed to.
+        bool binary = false; ///< Whether the connection wants binary events.
+    };
+
+    server m_server; ///< The WebSocket server endpoint.
+    channelsHandler m_acquire; ///< Upstream subscribe hook.
+    channelsHandler m_release; ///< Upstream unsubscribe hook.
+    bool m_listening; ///< Whether the acceptor is open.
+    std::map<websocketpp::connection_hdl, connectionState, std::owner_less<websocketpp::connection_hdl>> m_connections; ///< State per connection.
+    std::unordered_map<std::string, connectionSet> m_subscribers; ///< Connections per channel.
+    std::string m_definitions; ///< Every instrument definition seen, as binary events.
+    std::set<uint32_t> m_definedIds; ///< Instrument IDs in m_definitions.
+    std::atomic<size_t> m_connectionCount; ///< Size of m_connections, for stats.
+    std::atomic<size_t> m_channelCount; ///< Size of m_subscribers, for stats.
+    std::atomic<uint64_t> m_framesIn; ///< Upstream frames offered for fan-out.
+    std::atomic<uint64_t> m_framesOut; ///< Frames sent downstream.
+};
+
+#endif // LOCALGATEWAY_H
@@ -0,0 +1,509 @@
+/**
+ * @file ndjsonWriter.cpp
+ * @brief Implementation of the NDJSON event writer.
+ */
+
+#include "ndjsonWriter.h"
+#include "tscClock.h"
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace binaryEvents;
+
+namespace {
+
+    /**
+     * @brief Key names, indexed by ndjsonWriter::field.
+     */
+    const char* const kKeys[] = {
+        "type", "channel", "instrument", "seq", "exchange_ts", "receive_ts", "side", "action", "price", "amount",
+        "change_id", "prev_change_id", "snapshot", "last", "bid_price", "bid_amount", "ask_price", "ask_amount",
+        "last_price", "mark_price", "index_price", "open_interest", "trade_seq", "order_id", "label", "status",
+        "filled_amount", "average_price", "direction", "data"
+    };
+
+    /**
+     * @brief Names an event type.
+     *
+     * @param type The event type.
+     * @return const char* The name used as "type".
+     */
+    const char* typeName(eventType type) {
+        switch (type) {
+            case eventType::instrument: return "instrument";
+            case eventType::bookLevel: return "book";
+            case eventType::topOfBook: return "quote";
+            case eventType::trade: return "trade";
+            case eventType::ticker: return "ticker";
+            case eventType::orderUpdate: return "order";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief Names a side.
+     *
+     * @param value The side.
+     * @return const char* "bid", "ask" or "none".
+     */
+    const char* sideName(side value) {
+        return value == side::bid ? "bid" : value == side::ask ? "ask" : "none";
+    }
+
+    /**
+     * @brief Names an order status as Deribit does.
+     *
+     * @param status The status.
+     * @return const char* The order_state name.
+     */
+    const char* statusName(orderStatus status) {
+        switch (status) {
+            case orderStatus::open: return "open";
+            case orderStatus::filled: return "filled";
+            case orderStatus::cancelled: return "cancelled";
+            case orderStatus::rejected: return "rejected";
+            case orderStatus::untriggered: return "untriggered";
+            case orderStatus::unknown: break;
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief Reads a numeric field, or NaN if it is missing or not a number.
+     *
+     * @param object The JSON object.
+     * @param key The field name.
+     * @return double The value.
+     */
+    double number(const nlohmann::json& object, const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_number() ? it->get<double>() : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /**
+     * @brief Reads a string field, or an empty string if it is missing or not a string.
+     *
+     * @param object The JSON object.
+     * @param key The field name.
+     * @return std::string The value.
+     */
+    std::string text(const nlohmann::json& object, const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    /**
+     * @brief Names a book level action.
+     *
+     * @param action The action.
+     * @return const char* "new", "change" or "delete", as in Deribit book deltas.
+     */
+    const char* actionName(levelAction action) {
+        return action == levelAction::added ? "new" : action == levelAction::deleted ? "delete" : "change";
+    }
+}
+
+/**
+ * @brief Constructs a writer.
+ *
+ * @param fd The file descriptor to write to; not closed by the writer.
+ * @param fields Comma-separated keys to write, or empty for all keys.
+ * @param bufferSize Bytes buffered before a write.
+ * @throws std::runtime_error If a field name is unknown.
+ */
+ndjsonWriter::ndjsonWriter(int fd, const std::string& fields, size_t bufferSize)
+    : m_fd(fd), m_mask(0), m_bufferSize(bufferSize), m_firstKey(true), m_failed(false), m_lines(0) {
+    static_assert(sizeof(kKeys) / sizeof(kKeys[0]) == fieldCount, "every field needs a key name");
+    if (fields.empty()) {
+        m_mask = (uint64_t(1) << fieldCount) - 1;
+    }
+    std::istringstream stream(fields);
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        if (name.empty()) {
+            continue;
+        }
+        size_t index = 0;
+        while (index < fieldCount && name != kKeys[index]) {
+            ++index;
+        }
+        if (index == fieldCount) {
+            throw std::runtime_error("Unknown NDJSON field: " + name);
+        }
+        m_mask |= uint64_t(1) << index;
+    }
+    m_buffer.reserve(bufferSize + 4096);
+}
+
+/**
+ * @brief Flushes buffered lines.
+ */
+ndjsonWriter::~ndjsonWriter() {
+    flush();
+}
+
+/**
+ * @brief Formats one channel event into the buffer, writing it out when full.
+ *
+ * @param event The event.
+ */
+void ndjsonWriter::write(const channelEvent& event) {
+    if (m_failed) {
+        return;
+    }
+    int64_t receiveNs = event.receiveTimestampNs != 0 ? event.receiveTimestampNs : tscClock::instance().nowNs();
+    size_t written = 0;
+    if (event.channel.rfind("user.orders", 0) == 0) {
+        // "raw" channels send one order, aggregated ones an array
+        if (event.data.is_array()) {
+            for (const auto& order : event.data) {
+                written += writeOrder(event.channel, order, receiveNs);
+            }
+        } else {
+            written += writeOrder(event.channel, event.data, receiveNs);
+        }
+    }
+
+    const char* cursor = event.events.data();
+    const char* end = cursor + event.events.size();
+    eventHeader header;
+    while (const char* binary = nextEvent(cursor, end, header)) {
+        if (header.type == eventType::instrument) {
+            learn(binary);
+        } else {
+            writeEvent(event.channel, binary, header);
+            ++written;
+        }
+    }
+    if (written == 0) {
+        writeRaw(event, receiveNs);
+    }
+    if (m_buffer.size() >= m_bufferSize) {
+        flush();
+    }
+}
+
+/**
+ * @brief Writes out buffered lines.
+ *
+ * @return False if the descriptor failed (e.g., the reader closed the pipe); the
+ *         writer then discards all further output.
+ */
+bool ndjsonWriter::flush() {
+    const char* data = m_buffer.data();
+    size_t remaining = m_failed ? 0 : m_buffer.size();
+    while (remaining > 0) {
+        ssize_t n = ::write(m_fd, data, remaining);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fmt::print(stderr, "NDJSON output failed: {}\n", std::strerror(errno));
+            m_failed = true;
+            break;
+        }
+        data += n;
+        remaining -= static_cast<size_t>(n);
+    }
+    m_buffer.clear();
+    return !m_failed;
+}
+
+/**
+ * @brief Gets the number of lines written so far.
+ *
+ * @return uint64_t The count.
+ */
+uint64_t ndjsonWriter::lines() const {
+    return m_lines;
+}
+
+/**
+ * @brief Writes one binary event as a line.
+ *
+ * @param channel The channel the event came from.
+ * @param event The start of the binary event.
+ * @param header The event's header.
+ */
+void ndjsonWriter::writeEvent(const std::string& channel, const char* event, const eventHeader& header) {
+    m_buffer.push_back('{');
+    put(type, typeName(header.type));
+    put(field::channel, channel);
+    put(instrument, instrumentName(header.instrumentId));
+    put(seq, header.sequence);
+    put(exchangeTs, header.exchangeTimestampNs);
+    put(receiveTs, header.receiveTimestampNs);
+
+    switch (header.type) {
+        case eventType::bookLevel: {
+            bookLevelEvent book;
+            if (!read(event, eventType::bookLevel, book)) {
+                break;
+            }
+            put(field::side, sideName(book.levelSide));
+            put(action, actionName(book.action));
+            put(price, book.price);
+            put(amount, book.amount);
+            put(changeId, book.changeId);
+            put(prevChangeId, book.prevChangeId);
+            put(snapshot, (book.flags & kBookSnapshot) != 0);
+            put(last, (book.flags & kBookLast) != 0);
+            break;
+        }
+        case eventType::topOfBook: {
+            topOfBookEvent quote;
+            if (!read(event, eventType::topOfBook, quote)) {
+                break;
+            }
+            put(bidPrice, quote.bidPrice);
+            put(bidAmount, quote.bidAmount);
+            put(askPrice, quote.askPrice);
+            put(askAmount, quote.askAmount);
+            break;
+        }
+        case eventType::trade: {
+            tradeEvent trade;
+            if (!read(event, eventType::trade, trade)) {
+                break;
+            }
+            put(field::side, sideName(trade.aggressor));
+            put(price, trade.price);
+            put(amount, trade.amount);
+            put(tradeSeq, trade.tradeSeq);
+            break;
+        }
+        case eventType::ticker: {
+            tickerEvent ticker;
+            if (!read(event, eventType::ticker, ticker)) {
+                break;
+            }
+            put(bidPrice, ticker.bidPrice);
+            put(bidAmount, ticker.bidAmount);
+            put(askPrice, ticker.askPrice);
+            put(askAmount, ticker.askAmount);
+            put(lastPrice, ticker.lastPrice);
+            put(markPrice, ticker.markPrice);
+            put(indexPrice, ticker.indexPrice);
+            put(openInterest, ticker.openInterest);
+            break;
+        }
+        case eventType::orderUpdate: {
+            orderUpdateEvent order;
+            if (!read(event, eventType::orderUpdate, order)) {
+                break;
+            }
+            put(orderId, std::string(order.orderId, strnlen(order.orderId, sizeof(order.orderId))));
+            put(label, std::string(order.label, strnlen(order.label, sizeof(order.label))));
+            put(status, statusName(order.status));
+            put(direction, order.direction == side::bid ? "buy" : order.direction == side::ask ? "sell" : "none");
+            put(price, order.price);
+            put(amount, order.amount);
+            put(filledAmount, order.filledAmount);
+            put(averagePrice, order.averagePrice);
+            break;
+        }
+        case eventType::instrument:
+            break;
+    }
+    endLine();
+}
+
+/**
+ * @brief Writes one order of a user.orders notification as a line.
+ *
+ * @param channel The channel the order came from.
+ * @param order The order object.
+ * @param receiveTimestampNs Local receive time in nanoseconds.
+ * @return True if the order was written.
+ */
+bool ndjsonWriter::writeOrder(const std::string& channel, const nlohmann::json& order, int64_t receiveTimestampNs) {
+    if (!order.is_object() || !order.contains("instrument_name")) {
+        return false;
+    }
+    auto updated = order.find("last_update_timestamp");
+    m_buffer.push_back('{');
+    put(type, "order");
+    put(field::channel, channel);
+    put(instrument, text(order, "instrument_name"));
+    put(exchangeTs, updated != order.end() && updated->is_number_integer() ? updated->get<int64_t>() * 1000000 : int64_t(0));
+    put(receiveTs, receiveTimestampNs);
+    put(orderId, text(order, "order_id"));
+    put(label, text(order, "label"));
+    put(status, text(order, "order_state"));
+    put(direction, text(order, "direction"));
+    put(price, number(order, "price")); // "market_price" for market orders -> null
+    put(amount, number(order, "amount"));
+    put(filledAmount, number(order, "filled_amount"));
+    put(averagePrice, number(order, "average_price"));
+    endLine();
+    return true;
+}
+
+/**
+ * @brief Records the name of an instrument from its definition event.
+ *
+ * @param event The start of the `instrument` event.
+ */
+void ndjsonWriter::learn(const char* event) {
+    instrumentEvent definition;
+    if (!read(event, eventType::instrument, definition)) {
+        return;
+    }
+    uint32_t id = definition.header.instrumentId;
+    if (id >= m_names.size()) {
+        m_names.resize(id + 1);
+    }
+    m_names[id].assign(definition.name, strnlen(definition.name, sizeof(definition.name)));
+}
+
+/**
+ * @brief Gets the name of an instrument ID.
+ *
+ * @param id The instrument ID.
+ * @return const std::string& The name, or an empty string if it was never defined.
+ */
+const std::string& ndjsonWriter::instrumentName(uint32_t id) const {
+    static const std::string unknown;
+    return id < m_names.size() ? m_names[id] : unknown;
+}
+
+/**
+ * @brief Writes a channel event that has no normalized form as a `raw` line.
+ *
+ * @param event The channel event.
+ * @param receiveTimestampNs Local receive time in nanoseconds.
+ */
+void ndjsonWriter::writeRaw(const channelEvent& event, int64_t receiveTimestampNs) {
+    m_buffer.push_back('{');
+    put(type, "raw");
+    put(field::channel, event.channel);
+    put(receiveTs, receiveTimestampNs);
+    if (beginKey(data)) {
+        std::string compact = event.data.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        m_buffer.append(compact.data(), compact.data() + compact.size());
+    }
+    endLine();
+}
+
+/**
+ * @brief Starts a key if it is selected, writing the separator and the quoted name.
+ *
+ * @param key The key.
+ * @return True if the key is selected and its value must follow.
+ */
+bool ndjsonWriter::beginKey(field key) {
+    if (((m_mask >> key) & 1) == 0) {
+        return false;
+    }
+    if (!m_firstKey) {
+        m_buffer.push_back(',');
+    }
+    m_firstKey = false;
+    fmt::format_to(std::back_inserter(m_buffer), "\"{}\":", kKeys[key]);
+    return true;
+}
+
+/**
+ * @brief Writes a number if its key is selected; NaN and infinities become null.
+ *
+ * @param key The key.
+ * @param number The number.
+ */
+void ndjsonWriter::put(field key, double number) {
+    if (!beginKey(key)) {
+        return;
+    }
+    if (std::isfinite(number)) {
+        fmt::format_to(std::back_inserter(m_buffer), "{}", number);
+    } else {
+        fmt::format_to(std::back_inserter(m_buffer), "null");
+    }
+}
+
+/**
+ * @brief Writes an integer if its key is selected.
+ *
+ * @param key The key.
+ * @param number The integer.
+ */
+void ndjsonWriter::put(field key, int64_t number) {
+    if (beginKey(key)) {
+        fmt::format_to(std::back_inserter(m_buffer), "{}", number);
+    }
+}
+
+/**
+ * @brief Writes an unsigned integer if its key is selected.
+ *
+ * @param key The key.
+ * @param number The integer.
+ */
+void ndjsonWriter::put(field key, uint64_t number) {
+    if (beginKey(key)) {
+        fmt::format_to(std::back_inserter(m_buffer), "{}", number);
+    }
+}
+
+/**
+ * @brief Writes a boolean if its key is selected.
+ *
+ * @param key The key.
+ * @param flag The boolean.
+ */
+void ndjsonWriter::put(field key, bool flag) {
+    if (beginKey(key)) {
+        fmt::format_to(std::back_inserter(m_buffer), "{}", flag ? "true" : "false");
+    }
+}
+
+/**
+ * @brief Writes a name that needs no escaping, quoted, if its key is selected.
+ *
+ * @param key The key.
+ * @param name The name (one of the fixed enum names above).
+ */
+void ndjsonWriter::put(field key, const char* name) {
+    if (beginKey(key)) {
+        fmt::format_to(std::back_inserter(m_buffer), "\"{}\"", name);
+    }
+}
+
+/**
+ * @brief Writes a string, quoted and escaped, if its key is selected.
+ *
+ * @param key The key.
+ * @param text The string.
+ */
+void ndjsonWriter::put(field key, const std::string& text) {
+    if (!beginKey(key)) {
+        return;
+    }
+    m_buffer.push_back('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            m_buffer.push_back('\\');
+            m_buffer.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fmt::format_to(std::back_inserter(m_buffer), "\\u{:04x}", static_cast<unsigned>(c));
+        } else {
+            m_buffer.push_back(c);
+        }
+    }
+    m_buffer.push_back('"');
+}
+
+/**
+ * @brief Ends the current line.
+ */
+void ndjsonWriter::endLine() {
+    m_buffer.push_back('}');
+    m_buffer.push_back('\n');
+    m_firstKey = true;
+    ++m_lines;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file ndjsonWriter.h
+ * @brief Header file for the NDJSON event writer.
+ *
+ * This file defines the `ndjsonWriter` class, which formats channel events as one compact
+ * JSON object per normalized event per line, for piping DeriConsole into other tools.
+ */
+
+#ifndef NDJSONWRITER_H
+#define NDJSONWRITER_H
+
+#include "binaryEvents.h"
+#include "conflatingQueue.h"
+#include <fmt/format.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class ndjsonWriter
+ * @brief Buffered writer of normalized events as newline-delimited JSON.
+ *
+ * Every binary event the client decoded for a channel event (the same events, sequence
+ * numbers and instrument IDs the shared-memory publisher and the gateway see) becomes one
+ * line, formatted straight into a large buffer with fmt and written to a file descriptor
+ * in big chunks. Instrument names are learned from the definitions carried along.
+ * Private order updates are not part of the binary stream and are written from their
+ * JSON, without `seq`. Channels without a normalized form are written as one `raw` line
+ * with the compact payload. An optional field list limits the keys written. Used from
+ * the output thread only.
+ *
+ * Keys: type, channel, instrument, seq, exchange_ts, receive_ts (nanoseconds), side,
+ * action, price, amount, change_id, prev_change_id, snapshot, last, bid_price, bid_amount,
+ * ask_price, ask_amount, last_price, mark_price, index_price, open_interest, trade_seq,
+ * order_id, label, status, filled_amount, average_price, direction, data. Missing numbers
+ * are written as null.
+ */
+class ndjsonWriter {
+public:
+    /**
+     * @brief Constructs a writer.
+     *
+     * @param fd The file descriptor to write to; not closed by the writer.
+     * @param fields Comma-separated keys to write, or empty for all keys.
+     * @param bufferSize Bytes buffered before a write.
+     * @throws std::runtime_error If a field name is unknown.
+     */
+    explicit ndjsonWriter(int fd, const std::string& fields = std::string(), size_t bufferSize = 1 << 20);
+
+    /**
+     * @brief Flushes buffered lines.
+     */
+    ~ndjsonWriter();
+
+    ndjsonWriter(const ndjsonWriter&) = delete;
+    ndjsonWriter& operator=(const ndjsonWriter&) = delete;
+
+    /**
+     * @brief Formats one channel event into the buffer, writing it out when full.
+     *
+     * @param event The event.
+     */
+    void write(const channelEvent& event);
+
+    /**
+     * @brief Writes out buffered lines.
+     *
+     * @return False if the descriptor failed (e.g., the reader closed the pipe); the
+     *         writer then discards all further output.
+     */
+    bool flush();
+
+    /**
+     * @brief Gets the number of lines written so far.
+     *
+     * @return uint64_t The count.
+     */
+    uint64_t lines() const;
+
+private:
+    /**
+     * @brief Key identifiers, in the order of the key table.
+     */
+    enum field : uint8_t {
+        type, channel, instrument, seq, exchangeTs, receiveTs, side, action, price, amount,
+        changeId, prevChangeId, snapshot, last, bidPrice, bidAmount, askPrice, askAmount,
+        lastPrice, markPrice, indexPrice, openInterest, tradeSeq, orderId, label, status,
+        filledAmount, averagePrice, direction, data, fieldCount
+    };
+
+    /**
+     * @brief Writes one binary event as a line.
+     *
+     * @param channel The channel the event came from.
+     * @param event The start of the binary event.
+     * @param header The event's header.
+     */
+    void writeEvent(const std::string& channel, const char* event, const binaryEvents::eventHeader& header);
+
+    /**
+     * @brief Writes one order of a user.orders notification as a line.
+     *
+     * @param channel The channel the order came from.
+     * @param order The order object.
+     * @param receiveTimestampNs Local receive time in nanoseconds.
+     * @return True if the order was written.
+     */
+    bool writeOrder(const std::string& channel, const nlohmann::json& order, int64_t receiveTimestampNs);
+
+    /**
+     * @brief Records the name of an instrument from its definition event.
+     *
+     * @param event The start of the `instrument` event.
+     */
+    void learn(const char* event);
+
+    /**
+     * @brief Gets the name of an instrument ID.
+     *
+     * @param id The instrument ID.
+     * @return const std::string& The name, or an empty string if it was never defined.
+     */
+    const std::string& instrumentName(uint32_t id) const;
+
+    /**
+     * @brief Writes a channel event that has no normalized form as a `raw` line.
+     *
+     * @param event The channel event.
+     * @param receiveTimestampNs Local receive time in nanoseconds.
+     */
+    void writeRaw(const channelEvent& event, int64_t receiveTimestampNs);
+
+    /**
+     * @brief Starts a key if it is selected, writing the separator and the quoted name.
+     *
+     * @param key The key.
+     * @return True if the key is selected and its value must follow.
+     */
+    bool beginKey(field key);
+
+    // Write one key and its value if the key is selected
+    void put(field key, double number);
+    void put(field key, int64_t number);
+    void put(field key, uint64_t number);
+    void put(field key, bool flag);
+    void put(field key, const char* name);
+    void put(field key, const std::string& text);
+
+    /**
+     * @brief Ends the current line.
+     */
+    void endLine();
+
+    int m_fd; ///< Output file descriptor.
+    uint64_t m_mask; ///< Selected keys, one bit per field.
+    size_t m_bufferSize; ///< Flush threshold in bytes.
+    fmt::memory_buffer m_buffer; ///< Pending output.
+    bool m_firstKey; ///< Whether the current line has no key yet.
+    bool m_failed; ///< Whether the descriptor failed.
+    uint64_t m_lines; ///< Lines written.
+    std::vector<std::string> m_names; ///< Instrument names by ID, learned from definitions.
+};
+
+#endif // NDJSONWRITER_H
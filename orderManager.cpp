@@ -0,0 +1,600 @@
+/**
+ * @file orderManager.cpp
+ * @brief Implementation of the local order management system.
+ */
+
+#include "orderManager.h"
+#include <chrono>
+#include <functional>
+
+/**
+ * @brief Returns a printable name for an order state.
+ *
+ * @param state The order state.
+ * @return const char* The state name.
+ */
+const char* toString(orderState state) {
+    switch (state) {
+        case orderState::free: return "free";
+        case orderState::pendingNew: return "pending_new";
+        case orderState::open: return "open";
+        case orderState::partiallyFilled: return "partially_filled";
+        case orderState::filled: return "filled";
+        case orderState::cancelled: return "cancelled";
+        case orderState::rejected: return "rejected";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Constructs an index sized for the given slab capacity.
+ *
+ * The table is kept at most half full so probe sequences stay short.
+ *
+ * @param slab The slab the index points into.
+ * @param key The member of `order` used as key.
+ * @param capacity The slab capacity.
+ */
+orderManager::index::index(const std::vector<order>& slab, std::string order::*key, size_t capacity)
+    : m_slab(slab), m_key(key) {
+    size_t size = 16;
+    while (size < capacity * 2) {
+        size <<= 1;
+    }
+    m_entries.resize(size);
+    m_mask = size - 1;
+}
+
+/**
+ * @brief Finds the slot stored for a key.
+ *
+ * @param key The key to look up.
+ * @return uint32_t The slot, or kInvalidId if the key is not indexed.
+ */
+uint32_t orderManager::index::find(const std::string& key) const {
+    if (key.empty()) {
+        return kInvalidId;
+    }
+    uint64_t hash = std::hash<std::string>{}(key);
+    size_t i = hash & m_mask;
+    for (size_t probes = 0; probes < m_entries.size(); ++probes, i = (i + 1) & m_mask) {
+        const entry& e = m_entries[i];
+        if (e.slot == kEmpty) {
+            return kInvalidId;
+        }
+        if (e.hash == hash && m_slab[e.slot].*m_key == key) {
+            return e.slot;
+        }
+    }
+    return kInvalidId;
+}
+
+/**
+ * @brief Indexes a slot under a key, replacing any slot stored for the same key.
+ *
+ * @param key The key, which must equal the slot's key member.
+ * @param slot The slab slot.
+ */
+void orderManager::index::insert(const std::string& key, uint32_t slot) {
+    if (key.empty()) {
+        return;
+    }
+    uint64_t hash = std::hash<std::string>{}(key);
+    size_t i = hash & m_mask;
+    for (size_t probes = 0; probes < m_entries.size(); ++probes, i = (i + 1) & m_mask) {
+        entry& e = m_entries[i];
+        if (e.slot == kEmpty) {
+            e.hash = hash;
+            e.slot = slot;
+            return;
+        }
+        if (e.hash == hash && m_slab[e.slot].*m_key == key) {
+            e.slot = slot;
+            return;
+        }
+    }
+    // Unreachable while every indexed key belongs to a live slab slot: the table is twice the slab
+}
+
+/**
+ * @brief Removes a key if it still points at the given slot.
+ *
+ * Uses backward-shift deletion: later entries of the same probe run move up into the
+ * hole, so the table never accumulates tombstones and every run ends at an empty entry.
+ *
+ * @param key The key to remove.
+ * @param slot The slot the key is expected to point at.
+ */
+void orderManager::index::erase(const std::string& key, uint32_t slot) {
+    if (key.empty()) {
+        return;
+    }
+    uint64_t hash = std::hash<std::string>{}(key);
+    size_t hole = hash & m_mask;
+    size_t probes = 0;
+    for (; probes < m_entries.size(); ++probes, hole = (hole + 1) & m_mask) {
+        const entry& e = m_entries[hole];
+        if (e.slot == kEmpty) {
+            return;
+        }
+        if (e.slot == slot && e.hash == hash) {
+            break;
+        }
+    }
+    if (probes == m_entries.size()) {
+        return;
+    }
+    for (size_t i = (hole + 1) & m_mask; m_entries[i].slot != kEmpty; i = (i + 1) & m_mask) {
+        // An entry may fill the hole only if its home position is not after the hole in probe order
+        size_t home = m_entries[i].hash & m_mask;
+        if (((i - home) & m_mask) >= ((i - hole) & m_mask)) {
+            m_entries[hole] = m_entries[i];
+            hole = i;
+        }
+    }
+    m_entries[hole] = entry();
+}
+
+/**
+ * @brief Constructs an order manager with a fixed capacity.
+ *
+ * @param capacity The maximum number of orders tracked at once.
+ */
+orderManager::orderManager(size_t capacity)
+    : m_slab(capacity),
+      m_retired(capacity),
+      m_retiredHead(0),
+      m_retiredCount(0),
+      m_livePrev(capacity, kInvalidId),
+      m_liveNext(capacity, kInvalidId),
+      m_liveHead(kInvalidId),
+      m_editInFlight(capacity, 0),
+      m_hasPendingEdit(capacity, 0),
+      m_pendingEdits(capacity),
+      m_editsCoalesced(0),
+      m_pendingRequests(capacity),
+      m_attempts(capacity, 0),
+      m_labelPrefix("dc" + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count()) + "-"),
+      m_labelSequence(0),
+      m_byOrderId(m_slab, &order::orderId, capacity),
+      m_byLabel(m_slab, &order::label, capacity) {
+    m_freeSlots.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i) {
+        m_freeSlots.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+/**
+ * @brief Sets the callback invoked after every state change.
+ *
+ * @param callback The callback to invoke.
+ */
+void orderManager::setStateCallback(stateCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stateCallback = callback;
+}
+
+/**
+ * @brief Takes a free slot, recycling the oldest finished order if needed.
+ *
+ * @return uint32_t The slot, or kInvalidId if every slot holds a live order.
+ */
+uint32_t orderManager::allocate() {
+    uint32_t slot = kInvalidId;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else if (m_retiredCount > 0) {
+        slot = m_retired[m_retiredHead];
+        m_retiredHead = (m_retiredHead + 1) % m_retired.size();
+        --m_retiredCount;
+        order& old = m_slab[slot];
+        m_byOrderId.erase(old.orderId, slot);
+        m_byLabel.erase(old.label, slot);
+    } else {
+        return kInvalidId;
+    }
+    m_slab[slot] = order{};
+    m_slab[slot].clientId = slot;
+    m_editInFlight[slot] = 0;
+    m_hasPendingEdit[slot] = 0;
+    m_attempts[slot] = 0;
+    return slot;
+}
+
+/**
+ * @brief Queues a finished order for recycling.
+ *
+ * @param slot The slot of the finished order.
+ */
+void orderManager::retire(uint32_t slot) {
+    m_retired[(m_retiredHead + m_retiredCount) % m_retired.size()] = slot;
+    ++m_retiredCount;
+}
+
+/**
+ * @brief Links a slot at the head of the live-order list.
+ *
+ * @param slot The slot that became live.
+ */
+void orderManager::link(uint32_t slot) {
+    m_livePrev[slot] = kInvalidId;
+    m_liveNext[slot] = m_liveHead;
+    if (m_liveHead != kInvalidId) {
+        m_livePrev[m_liveHead] = slot;
+    }
+    m_liveHead = slot;
+}
+
+/**
+ * @brief Removes a slot from the live-order list.
+ *
+ * @param slot The slot that is no longer live.
+ */
+void orderManager::unlink(uint32_t slot) {
+    uint32_t prev = m_livePrev[slot];
+    uint32_t next = m_liveNext[slot];
+    if (prev != kInvalidId) {
+        m_liveNext[prev] = next;
+    } else {
+        m_liveHead = next;
+    }
+    if (next != kInvalidId) {
+        m_livePrev[next] = prev;
+    }
+}
+
+/**
+ * @brief Moves an order to a new state, retiring it and notifying the callback as needed.
+ *
+ * Finished orders never go back to a live state; late notifications are ignored.
+ *
+ * @param o The order to update.
+ * @param state The new state.
+ */
+void orderManager::setState(order& o, orderState state) {
+    orderState previous = o.state;
+    if (previous == state) {
+        return;
+    }
+    bool wasLive = o.isLive() || previous == orderState::free;
+    if (!wasLive) {
+        return;
+    }
+    o.state = state;
+    if (previous == orderState::pendingNew) {
+        m_pendingRequests[o.clientId].clear();
+    }
+    if (previous == orderState::free && o.isLive()) {
+        link(o.clientId);
+    } else if (previous != orderState::free && !o.isLive()) {
+        unlink(o.clientId);
+    }
+    if (!o.isLive()) {
+        retire(o.clientId);
+    }
+    if (m_stateCallback) {
+        m_stateCallback(o, previous);
+    }
+}
+
+/**
+ * @brief Copies the fields of a Deribit order object into a tracked order.
+ *
+ * @param o The order to update.
+ * @param data The order object as sent by Deribit.
+ */
+void orderManager::apply(order& o, const nlohmann::json& data) {
+    std::string orderId = data.value("order_id", "");
+    if (!orderId.empty() && orderId != o.orderId) {
+        m_byOrderId.erase(o.orderId, o.clientId);
+        o.orderId = orderId;
+        m_byOrderId.insert(o.orderId, o.clientId);
+    }
+    std::string label = data.value("label", "");
+    if (!label.empty() && label != o.label) {
+        m_byLabel.erase(o.label, o.clientId);
+        o.label = label;
+        m_byLabel.insert(o.label, o.clientId);
+    }
+    if (data.contains("instrument_name")) o.instrument = data["instrument_name"].get<std::string>();
+    if (data.contains("direction")) o.direction = data["direction"].get<std::string>();
+    if (data.contains("order_type")) o.orderType = data["order_type"].get<std::string>();
+    if (data.contains("amount") && data["amount"].is_number()) o.amount = data["amount"].get<double>();
+    if (data.contains("price") && data["price"].is_number()) o.price = data["price"].get<double>();
+    if (data.contains("filled_amount") && data["filled_amount"].is_number()) o.filledAmount = data["filled_amount"].get<double>();
+    if (data.contains("average_price") && data["average_price"].is_number()) o.averagePrice = data["average_price"].get<double>();
+    o.lastUpdate = data.value("last_update_timestamp", o.lastUpdate);
+
+    std::string exchangeState = data.value("order_state", "");
+    if (exchangeState == "open" || exchangeState == "untriggered") {
+        setState(o, o.filledAmount > 0.0 ? orderState::partiallyFilled : orderState::open);
+    } else if (exchangeState == "filled") {
+        setState(o, orderState::filled);
+    } else if (exchangeState == "cancelled") {
+        setState(o, orderState::cancelled);
+    } else if (exchangeState == "rejected") {
+        setState(o, orderState::rejected);
+    }
+}
+
+/**
+ * @brief Registers a new order that is about to be sent.
+ *
+ * @param instrument The instrument name.
+ * @param direction "buy" or "sell".
+ * @param orderType The order type (e.g., "limit").
+ * @param amount The order amount.
+ * @param price The limit price.
+ * @param label The order label; an empty label is replaced by a unique generated one.
+ * @param assignedLabel [optional] Receives the label the order was registered with.
+ * @return uint32_t The client-side ID, or kInvalidId if every slot holds a live order.
+ */
+uint32_t orderManager::createPending(const std::string& instrument, const std::string& direction, const std::string& orderType, double amount, double price, const std::string& label, std::string* assignedLabel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t slot = allocate();
+    if (slot == kInvalidId) {
+        return kInvalidId;
+    }
+    order& o = m_slab[slot];
+    o.instrument = instrument;
+    o.direction = direction;
+    o.orderType = orderType;
+    o.amount = amount;
+    o.price = price;
+    o.label = label.empty() ? m_labelPrefix + std::to_string(m_labelSequence++) : label;
+    m_byLabel.insert(o.label, slot);
+    setState(o, orderState::pendingNew);
+    if (assignedLabel) {
+        *assignedLabel = o.label;
+    }
+    return slot;
+}
+
+/**
+ * @brief Stores the request of a pending order so it can be resubmitted.
+ *
+ * @param clientId The client-side ID of the order.
+ * @param request The serialized order request.
+ */
+void orderManager::setPendingRequest(uint32_t clientId, std::string request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (clientId < m_slab.size() && m_slab[clientId].state == orderState::pendingNew) {
+        m_pendingRequests[clientId] = std::move(request);
+        m_attempts[clientId] = 1;
+    }
+}
+
+/**
+ * @brief Takes the stored request of a pending order for one more attempt.
+ *
+ * @param clientId The client-side ID of the order.
+ * @param maxAttempts The maximum number of submissions, including the first one.
+ * @param request Receives the request to resend.
+ * @return True if the order is still pending and has attempts left.
+ */
+bool orderManager::takeRetry(uint32_t clientId, int maxAttempts, std::string& request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (clientId >= m_slab.size() || m_slab[clientId].state != orderState::pendingNew ||
+        m_pendingRequests[clientId].empty() || m_attempts[clientId] >= maxAttempts) {
+        return false;
+    }
+    ++m_attempts[clientId];
+    request = m_pendingRequests[clientId];
+    return true;
+}
+
+/**
+ * @brief Lists the orders still waiting for an acknowledgement.
+ *
+ * @return std::vector<order> Copies of the pending-new orders.
+ */
+std::vector<order> orderManager::pendingOrders() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<order> result;
+    for (uint32_t slot = m_liveHead; slot != kInvalidId; slot = m_liveNext[slot]) {
+        if (m_slab[slot].state == orderState::pendingNew) {
+            result.push_back(m_slab[slot]);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Applies an order object from an acknowledgement or `user.orders` notification.
+ *
+ * @param data The order object as sent by Deribit.
+ * @param clientId [optional] The client-side ID the response belongs to.
+ * @return uint32_t The client-side ID of the updated order, or kInvalidId if it could not be stored.
+ */
+uint32_t orderManager::onOrderUpdate(const nlohmann::json& data, uint32_t clientId) {
+    if (!data.is_object()) {
+        return kInvalidId;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t slot = kInvalidId;
+    if (clientId < m_slab.size() && m_slab[clientId].state != orderState::free) {
+        // Request IDs name a slab slot; a late response for a recycled slot must not touch its new order
+        const order& current = m_slab[clientId];
+        std::string orderId = data.value("order_id", "");
+        std::string label = data.value("label", "");
+        bool otherOrder = !current.orderId.empty() && !orderId.empty() && current.orderId != orderId;
+        bool otherLabel = !current.label.empty() && !label.empty() && current.label != label;
+        if (!otherOrder && !otherLabel) {
+            slot = clientId;
+        }
+    }
+    if (slot == kInvalidId) {
+        slot = m_byOrderId.find(data.value("order_id", ""));
+    }
+    if (slot == kInvalidId) {
+        uint32_t byLabel = m_byLabel.find(data.value("label", ""));
+        if (byLabel != kInvalidId && m_slab[byLabel].state == orderState::pendingNew && m_slab[byLabel].orderId.empty()) {
+            slot = byLabel;
+        }
+    }
+    if (slot == kInvalidId) {
+        slot = allocate();
+        if (slot == kInvalidId) {
+            return kInvalidId;
+        }
+    }
+    apply(m_slab[slot], data);
+    if (m_slab[slot].state == orderState::free) {
+        // Adopted object without a usable order_state; give the slot back.
+        m_byOrderId.erase(m_slab[slot].orderId, slot);
+        m_byLabel.erase(m_slab[slot].label, slot);
+        m_slab[slot] = order{};
+        m_freeSlots.push_back(slot);
+        return kInvalidId;
+    }
+    return slot;
+}
+
+/**
+ * @brief Marks a pending order as rejected.
+ *
+ * @param clientId The client-side ID of the rejected order.
+ */
+void orderManager::onReject(uint32_t clientId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (clientId < m_slab.size() && m_slab[clientId].state == orderState::pendingNew) {
+        setState(m_slab[clientId], orderState::rejected);
+    }
+}
+
+/**
+ * @brief Registers an edit for an order.
+ *
+ * @param clientId The client-side ID of the order.
+ * @param edit The target parameters.
+ * @return True if the caller should send the edit now, false if it was coalesced.
+ */
+bool orderManager::requestEdit(uint32_t clientId, const orderEdit& edit) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (clientId >= m_slab.size()) {
+        return true;
+    }
+    if (!m_editInFlight[clientId]) {
+        m_editInFlight[clientId] = 1;
+        return true;
+    }
+    if (m_hasPendingEdit[clientId]) {
+        ++m_editsCoalesced;
+    }
+    m_pendingEdits[clientId] = edit;
+    m_hasPendingEdit[clientId] = 1;
+    return false;
+}
+
+/**
+ * @brief Resolves the in-flight edit of an order.
+ *
+ * @param clientId The client-side ID of the order.
+ * @param next Receives the pending edit to send.
+ * @return True if `next` holds an edit that should be sent now.
+ */
+bool orderManager::completeEdit(uint32_t clientId, orderEdit& next) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (clientId >= m_slab.size()) {
+        return false;
+    }
+    if (m_hasPendingEdit[clientId] && m_slab[clientId].isLive()) {
+        next = std::move(m_pendingEdits[clientId]);
+        m_hasPendingEdit[clientId] = 0;
+        return true;
+    }
+    if (m_hasPendingEdit[clientId]) {
+        // The order finished while the edit was waiting; it can no longer be applied
+        ++m_editsCoalesced;
+        m_hasPendingEdit[clientId] = 0;
+    }
+    m_editInFlight[clientId] = 0;
+    return false;
+}
+
+/**
+ * @brief Forgets every in-flight and pending edit.
+ *
+ * Called when the connection drops: responses to edits sent on it will never arrive.
+ *
+ * @return size_t The number of edits that were in flight.
+ */
+size_t orderManager::abandonEdits() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t inFlight = 0;
+    for (size_t slot = 0; slot < m_slab.size(); ++slot) {
+        inFlight += m_editInFlight[slot];
+        m_editsCoalesced += m_hasPendingEdit[slot];
+        m_editInFlight[slot] = 0;
+        m_hasPendingEdit[slot] = 0;
+    }
+    return inFlight;
+}
+
+/**
+ * @brief Gets the number of edits superseded before they were sent.
+ *
+ * @return uint64_t The number of coalesced edits.
+ */
+uint64_t orderManager::editsCoalesced() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_editsCoalesced;
+}
+
+/**
+ * @brief Copies an order by client-side ID.
+ *
+ * @param clientId The client-side ID.
+ * @param out Receives the order.
+ * @return True if the slot holds an order.
+ */
+bool orderManager::get(uint32_t clientId, order& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (clientId >= m_slab.size() || m_slab[clientId].state == orderState::free) {
+        return false;
+    }
+    out = m_slab[clientId];
+    return true;
+}
+
+/**
+ * @brief Looks up an order by exchange order ID.
+ *
+ * @param orderId The exchange order ID.
+ * @return uint32_t The client-side ID, or kInvalidId if unknown.
+ */
+uint32_t orderManager::findByOrderId(const std::string& orderId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byOrderId.find(orderId);
+}
+
+/**
+ * @brief Looks up the most recent order with a label.
+ *
+ * @param label The order label.
+ * @return uint32_t The client-side ID, or kInvalidId if unknown.
+ */
+uint32_t orderManager::findByLabel(const std::string& label) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byLabel.find(label);
+}
+
+/**
+ * @brief Lists all live orders.
+ *
+ * @param instrument [optional] Restricts the result to one instrument.
+ * @return std::vector<order> Copies of the live orders.
+ */
+std::vector<order> orderManager::openOrders(const std::string& instrument) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<order> result;
+    for (uint32_t slot = m_liveHead; slot != kInvalidId; slot = m_liveNext[slot]) {
+        const order& o = m_slab[slot];
+        if (instrument.empty() || o.instrument == instrument) {
+            result.push_back(o);
+        }
+    }
+    return result;
+}
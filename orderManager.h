@@ -0,0 +1,316 @@
+/**
+ * @file orderManager.h
+ * @brief Header file for the local order management system.
+ *
+ * This file defines the `orderManager` class, which tracks the lifecycle of every
+ * order placed through the client from request acknowledgements and `user.orders`
+ * notifications, so open orders can be answered locally without a round-trip.
+ */
+
+#ifndef ORDERMANAGER_H
+#define ORDERMANAGER_H
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lifecycle states of a locally tracked order.
+ */
+enum class orderState : uint8_t {
+    free,            ///< Slot is unused.
+    pendingNew,      ///< Request sent, no acknowledgement yet.
+    open,            ///< Resting on the book with nothing filled.
+    partiallyFilled, ///< Resting on the book with part of the amount filled.
+    filled,          ///< Completely filled.
+    cancelled,       ///< Cancelled by us or by the exchange.
+    rejected         ///< Rejected by the exchange.
+};
+
+/**
+ * @brief Returns a printable name for an order state.
+ *
+ * @param state The order state.
+ * @return const char* The state name.
+ */
+const char* toString(orderState state);
+
+/**
+ * @brief A locally tracked order.
+ */
+struct order {
+    uint32_t clientId = 0;                  ///< Client-side ID (slab index).
+    orderState state = orderState::free;    ///< Current lifecycle state.
+    std::string orderId;                    ///< Exchange order ID, empty until acknowledged.
+    std::string label;                      ///< User label of the order.
+    std::string instrument;                 ///< Instrument name (e.g., "BTC-PERPETUAL").
+    std::string direction;                  ///< "buy" or "sell".
+    std::string orderType;                  ///< Order type (e.g., "limit").
+    double amount = 0.0;                    ///< Order amount.
+    double price = 0.0;                     ///< Limit price.
+    double filledAmount = 0.0;              ///< Filled amount.
+    double averagePrice = 0.0;              ///< Average fill price.
+    long long lastUpdate = 0;               ///< Exchange timestamp of the last update.
+
+    /**
+     * @brief Checks whether the order is still working on the exchange.
+     *
+     * @return True for pending-new, open and partially filled orders.
+     */
+    bool isLive() const {
+        return state == orderState::pendingNew || state == orderState::open || state == orderState::partiallyFilled;
+    }
+};
+
+/**
+ * @brief Target parameters of an edit (private/edit) request.
+ */
+struct orderEdit {
+    double amount = 0.0;        ///< New amount.
+    double price = 0.0;         ///< New price.
+    std::string timeInForce;    ///< New time-in-force.
+    bool postOnly = false;      ///< Whether the order should be post-only.
+    bool reduceOnly = false;    ///< Whether the order should be reduce-only.
+};
+
+/**
+ * @class orderManager
+ * @brief Local order management system with O(1) lookups.
+ *
+ * Orders live in a slab preallocated at construction and are addressed by their
+ * client-side ID. Two open-addressed hash indexes map exchange order IDs and labels
+ * to slab slots, and live orders are chained in an intrusive list so "what is open"
+ * never scans the slab. Slots of finished orders are recycled oldest first once the
+ * slab runs out of free slots. All methods are thread-safe.
+ */
+class orderManager {
+public:
+    static constexpr uint32_t kInvalidId = UINT32_MAX; ///< Returned when no order matches.
+
+    /**
+     * @brief Callback invoked after an order changes state.
+     *
+     * The callback receives the order after the update and its previous state. It is
+     * called with the manager's lock held and must not call back into the manager.
+     */
+    using stateCallback = std::function<void(const order&, orderState)>;
+
+    /**
+     * @brief Constructs an order manager with a fixed capacity.
+     *
+     * @param capacity The maximum number of orders tracked at once.
+     */
+    explicit orderManager(size_t capacity = 4096);
+
+    /**
+     * @brief Gets the slab capacity.
+     *
+     * @return size_t The maximum number of orders tracked at once.
+     */
+    size_t capacity() const { return m_slab.size(); }
+
+    /**
+     * @brief Sets the callback invoked after every state change.
+     *
+     * @param callback The callback to invoke.
+     */
+    void setStateCallback(stateCallback callback);
+
+    /**
+     * @brief Registers a new order that is about to be sent.
+     *
+     * @param instrument The instrument name.
+     * @param direction "buy" or "sell".
+     * @param orderType The order type (e.g., "limit").
+     * @param amount The order amount.
+     * @param price The limit price.
+     * @param label The order label; an empty label is replaced by a unique generated one.
+     * @param assignedLabel [optional] Receives the label the order was registered with.
+     * @return uint32_t The client-side ID, or kInvalidId if every slot holds a live order.
+     */
+    uint32_t createPending(const std::string& instrument, const std::string& direction, const std::string& orderType, double amount, double price, const std::string& label, std::string* assignedLabel = nullptr);
+
+    /**
+     * @brief Stores the request of a pending order so it can be resubmitted.
+     *
+     * The request is dropped as soon as the order leaves the pending-new state.
+     *
+     * @param clientId The client-side ID of the order.
+     * @param request The serialized order request.
+     */
+    void setPendingRequest(uint32_t clientId, std::string request);
+
+    /**
+     * @brief Takes the stored request of a pending order for one more attempt.
+     *
+     * Callers must first have confirmed (e.g., by querying the label) that the order did
+     * not reach the exchange.
+     *
+     * @param clientId The client-side ID of the order.
+     * @param maxAttempts The maximum number of submissions, including the first one.
+     * @param request Receives the request to resend.
+     * @return True if the order is still pending and has attempts left.
+     */
+    bool takeRetry(uint32_t clientId, int maxAttempts, std::string& request);
+
+    /**
+     * @brief Lists the orders still waiting for an acknowledgement.
+     *
+     * @return std::vector<order> Copies of the pending-new orders.
+     */
+    std::vector<order> pendingOrders() const;
+
+    /**
+     * @brief Applies an order object from an acknowledgement or `user.orders` notification.
+     *
+     * The order is matched by client-side ID when known, then by exchange order ID, then
+     * by label of a pending order. The client-side ID is only trusted if the slot's order
+     * ID and label agree with the object's, since a late response may name a slot that has
+     * been recycled. Unknown orders (e.g., placed from another session) are adopted.
+     *
+     * @param data The order object as sent by Deribit.
+     * @param clientId [optional] The client-side ID the response belongs to.
+     * @return uint32_t The client-side ID of the updated order, or kInvalidId if it could not be stored.
+     */
+    uint32_t onOrderUpdate(const nlohmann::json& data, uint32_t clientId = kInvalidId);
+
+    /**
+     * @brief Marks a pending order as rejected.
+     *
+     * @param clientId The client-side ID of the rejected order.
+     */
+    void onReject(uint32_t clientId);
+
+    /**
+     * @brief Registers an edit for an order.
+     *
+     * At most one edit per order is in flight. If one already is, the new edit replaces
+     * whatever is waiting in the order's pending-edit slot and nothing should be sent.
+     *
+     * @param clientId The client-side ID of the order.
+     * @param edit The target parameters.
+     * @return True if the caller should send the edit now, false if it was coalesced.
+     */
+    bool requestEdit(uint32_t clientId, const orderEdit& edit);
+
+    /**
+     * @brief Resolves the in-flight edit of an order.
+     *
+     * If a newer edit is waiting and the order is still live, it becomes the in-flight
+     * edit and is returned for sending.
+     *
+     * @param clientId The client-side ID of the order.
+     * @param next Receives the pending edit to send.
+     * @return True if `next` holds an edit that should be sent now.
+     */
+    bool completeEdit(uint32_t clientId, orderEdit& next);
+
+    /**
+     * @brief Forgets every in-flight and pending edit.
+     *
+     * Called when the connection drops: responses to edits sent on it will never arrive.
+     *
+     * @return size_t The number of edits that were in flight.
+     */
+    size_t abandonEdits();
+
+    /**
+     * @brief Gets the number of edits superseded before they were sent.
+     *
+     * @return uint64_t The number of coalesced edits.
+     */
+    uint64_t editsCoalesced() const;
+
+    /**
+     * @brief Copies an order by client-side ID.
+     *
+     * @param clientId The client-side ID.
+     * @param out Receives the order.
+     * @return True if the slot holds an order.
+     */
+    bool get(uint32_t clientId, order& out) const;
+
+    /**
+     * @brief Looks up an order by exchange order ID.
+     *
+     * @param orderId The exchange order ID.
+     * @return uint32_t The client-side ID, or kInvalidId if unknown.
+     */
+    uint32_t findByOrderId(const std::string& orderId) const;
+
+    /**
+     * @brief Looks up the most recent order with a label.
+     *
+     * @param label The order label.
+     * @return uint32_t The client-side ID, or kInvalidId if unknown.
+     */
+    uint32_t findByLabel(const std::string& label) const;
+
+    /**
+     * @brief Lists all live orders.
+     *
+     * @param instrument [optional] Restricts the result to one instrument.
+     * @return std::vector<order> Copies of the live orders.
+     */
+    std::vector<order> openOrders(const std::string& instrument = "") const;
+
+private:
+    /**
+     * @brief Open-addressed hash index from a string member of `order` to slab slots.
+     *
+     * Keys are not copied into the table; probes compare against the slab entry.
+     */
+    class index {
+    public:
+        index(const std::vector<order>& slab, std::string order::*key, size_t capacity);
+        uint32_t find(const std::string& key) const;
+        void insert(const std::string& key, uint32_t slot);
+        void erase(const std::string& key, uint32_t slot);
+
+    private:
+        static constexpr uint32_t kEmpty = UINT32_MAX;
+
+        struct entry {
+            uint64_t hash = 0;
+            uint32_t slot = kEmpty;
+        };
+
+        const std::vector<order>& m_slab;
+        std::string order::*m_key;
+        std::vector<entry> m_entries;
+        size_t m_mask;
+    };
+
+    uint32_t allocate();
+    void retire(uint32_t slot);
+    void link(uint32_t slot);
+    void unlink(uint32_t slot);
+    void apply(order& o, const nlohmann::json& data);
+    void setState(order& o, orderState state);
+
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    std::vector<order> m_slab; ///< Preallocated order storage indexed by client-side ID.
+    std::vector<uint32_t> m_freeSlots; ///< Slots never used or already recycled.
+    std::vector<uint32_t> m_retired; ///< Ring of finished orders, oldest first.
+    size_t m_retiredHead; ///< Index of the oldest finished order in m_retired.
+    size_t m_retiredCount; ///< Number of finished orders in m_retired.
+    std::vector<uint32_t> m_livePrev; ///< Previous slot in the live-order list.
+    std::vector<uint32_t> m_liveNext; ///< Next slot in the live-order list.
+    uint32_t m_liveHead; ///< First slot in the live-order list.
+    std::vector<uint8_t> m_editInFlight; ///< Whether an edit of the slot's order is in flight.
+    std::vector<uint8_t> m_hasPendingEdit; ///< Whether the slot's pending-edit slot is filled.
+    std::vector<orderEdit> m_pendingEdits; ///< Latest edit waiting behind the in-flight one.
+    uint64_t m_editsCoalesced; ///< Edits replaced before they were sent.
+    std::vector<std::string> m_pendingRequests; ///< Serialized requests of pending-new orders.
+    std::vector<uint8_t> m_attempts; ///< Number of times the slot's order was submitted.
+    std::string m_labelPrefix; ///< Per-session prefix of generated labels.
+    uint64_t m_labelSequence; ///< Sequence number of the next generated label.
+    index m_byOrderId; ///< Exchange order ID index.
+    index m_byLabel; ///< Label index.
+    stateCallback m_stateCallback; ///< Invoked after every state change.
+};
+
+#endif // ORDERMANAGER_H
@@ -0,0 +1,180 @@
+/**
+ * @file positionTracker.cpp
+ * @brief Implementation of the incremental position tracker.
+ */
+
+#include "positionTracker.h"
+#include "instrumentKey.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    /// Sizes closer than this are considered equal during reconciliation.
+    constexpr double kDriftTolerance = 1e-9;
+
+    /// Average prices within this relative difference are considered equal (exchange rounding).
+    constexpr double kAveragePriceTolerance = 1e-6;
+
+    /**
+     * @brief Checks whether an instrument is an inverse future or perpetual.
+     *
+     * @param instrument The instrument name.
+     * @return True if amounts are in USD and PnL is in the base coin.
+     */
+    bool isInverse(const std::string& instrument) {
+        uint64_t key;
+        return instrumentKey::parse(instrument, key) && instrumentKey::isInverse(key);
+    }
+}
+
+/**
+ * @brief Constructs an empty tracker.
+ *
+ * @param tradeHistory Number of recent trade IDs kept for de-duplication.
+ */
+positionTracker::positionTracker(size_t tradeHistory)
+    : m_tradeHistory(tradeHistory),
+      m_driftCount(0) {}
+
+/**
+ * @brief Applies one fill.
+ *
+ * Fills in the direction of the position extend it at a volume-weighted (linear) or
+ * harmonic (inverse) average price; opposite fills realize PnL against the average price,
+ * and any remainder past flat opens a new position at the fill price.
+ *
+ * @param trade The trade object from `user.trades` or an order response.
+ * @param out Receives the position after the fill.
+ * @return True if the fill was applied, false if it was a duplicate or malformed.
+ */
+bool positionTracker::onTrade(const nlohmann::json& trade, position* out) {
+    if (!trade.is_object() || !trade.contains("instrument_name") || !trade.contains("amount") || !trade.contains("price")) {
+        return false;
+    }
+    std::string tradeId = trade.value("trade_id", "");
+    std::string instrument = trade["instrument_name"].get<std::string>();
+    double amount = trade["amount"].get<double>();
+    double price = trade["price"].get<double>();
+    double signedAmount = trade.value("direction", "") == "sell" ? -amount : amount;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!tradeId.empty()) {
+        if (!m_seenTrades.insert(tradeId).second) {
+            return false;
+        }
+        m_tradeOrder.push_back(tradeId);
+        if (m_tradeOrder.size() > m_tradeHistory) {
+            m_seenTrades.erase(m_tradeOrder.front());
+            m_tradeOrder.pop_front();
+        }
+    }
+
+    position& p = m_positions[instrument];
+    if (p.instrument.empty()) {
+        p.instrument = instrument;
+        p.inverse = isInverse(instrument);
+    }
+    ++p.fills;
+    if (p.size == 0.0 || (p.size > 0.0) == (signedAmount > 0.0)) {
+        double newSize = std::fabs(p.size) + amount;
+        if (p.inverse) {
+            // USD amounts buy amount / price coins; the average is USD per coin held
+            double coins = p.size == 0.0 ? 0.0 : std::fabs(p.size) / p.averagePrice;
+            p.averagePrice = newSize / (coins + amount / price);
+        } else {
+            p.averagePrice = (std::fabs(p.size) * p.averagePrice + amount * price) / newSize;
+        }
+        p.size += signedAmount;
+    } else {
+        double closed = std::min(amount, std::fabs(p.size));
+        double pnl = p.inverse ? closed * (1.0 / p.averagePrice - 1.0 / price) : closed * (price - p.averagePrice);
+        p.realizedPnl += pnl * (p.size > 0.0 ? 1.0 : -1.0);
+        p.size += signedAmount;
+        if (std::fabs(p.size) <= kDriftTolerance) {
+            p.size = 0.0;
+            p.averagePrice = 0.0;
+        } else if (amount > closed) {
+            p.averagePrice = price;
+        }
+    }
+    if (out) {
+        *out = p;
+    }
+    return true;
+}
+
+/**
+ * @brief Reconciles one instrument against the exchange, adopting the exchange's view.
+ *
+ * @param instrument The instrument name.
+ * @param exchangeSize The signed size reported by the exchange.
+ * @param exchangeAveragePrice The average price reported by the exchange.
+ * @return positionDrift The differences before adoption.
+ */
+positionDrift positionTracker::reconcile(const std::string& instrument, double exchangeSize, double exchangeAveragePrice) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    position& p = m_positions[instrument];
+    if (p.instrument.empty()) {
+        p.instrument = instrument;
+        p.inverse = isInverse(instrument);
+    }
+    positionDrift drift;
+    drift.localAveragePrice = p.averagePrice;
+    drift.size = exchangeSize - p.size;
+    if (std::fabs(drift.size) > kDriftTolerance) {
+        ++m_driftCount;
+    } else {
+        drift.size = 0.0;
+        double scale = std::max(std::fabs(exchangeAveragePrice), std::fabs(p.averagePrice));
+        if (exchangeSize != 0.0 && std::fabs(exchangeAveragePrice - p.averagePrice) > kAveragePriceTolerance * scale) {
+            drift.averagePriceMismatch = true;
+            ++m_driftCount;
+        }
+    }
+    p.size = exchangeSize;
+    p.averagePrice = exchangeSize == 0.0 ? 0.0 : exchangeAveragePrice;
+    return drift;
+}
+
+/**
+ * @brief Copies the position of one instrument.
+ *
+ * @param instrument The instrument name.
+ * @param out Receives the position.
+ * @return True if the instrument has been seen.
+ */
+bool positionTracker::get(const std::string& instrument, position& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_positions.find(instrument);
+    if (it == m_positions.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+/**
+ * @brief Copies all known positions.
+ *
+ * @return std::vector<position> The positions, including flat ones.
+ */
+std::vector<position> positionTracker::all() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<position> result;
+    result.reserve(m_positions.size());
+    for (const auto& entry : m_positions) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+/**
+ * @brief Gets the number of reconciliations that found a drift.
+ *
+ * @return uint64_t The number of drifts detected.
+ */
+uint64_t positionTracker::driftCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_driftCount;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file positionTracker.h
+ * @brief Header file for the incremental position tracker.
+ *
+ * This file defines the `positionTracker` class, which applies fills from `user.trades`
+ * to per-instrument positions and reconciles them against `private/get_positions`.
+ */
+
+#ifndef POSITIONTRACKER_H
+#define POSITIONTRACKER_H
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Locally tracked position of one instrument.
+ *
+ * For linear instruments the average price is volume-weighted and PnL is amount times
+ * price difference, in the quote currency. For inverse futures and perpetuals (amounts in
+ * USD, e.g. "BTC-PERPETUAL") the average price is the harmonic mean and PnL is
+ * amount * (1/average - 1/price), in the base coin, as Deribit computes them.
+ */
+struct position {
+    std::string instrument;     ///< Instrument name.
+    bool inverse = false;       ///< Whether amounts are in USD and PnL is in the base coin.
+    double size = 0.0;          ///< Signed size (negative for short).
+    double averagePrice = 0.0;  ///< Average entry price of the open size.
+    double realizedPnl = 0.0;   ///< Realized PnL of closed size since start-up.
+    uint64_t fills = 0;         ///< Number of fills applied.
+};
+
+/**
+ * @brief Differences found by a reconciliation.
+ */
+struct positionDrift {
+    double size = 0.0;                 ///< Exchange size minus local size; 0 if they agree.
+    double localAveragePrice = 0.0;    ///< Local average price before adoption.
+    bool averagePriceMismatch = false; ///< Whether the sizes agree but the average prices do not.
+};
+
+/**
+ * @class positionTracker
+ * @brief Applies fills incrementally and reconciles against the exchange.
+ *
+ * Fills are de-duplicated by trade ID, so trades delivered both in order responses and
+ * on `user.trades` are applied once. All methods are thread-safe.
+ */
+class positionTracker {
+public:
+    /**
+     * @brief Constructs an empty tracker.
+     *
+     * @param tradeHistory [optional] Number of recent trade IDs kept for de-duplication.
+     */
+    explicit positionTracker(size_t tradeHistory = 4096);
+
+    /**
+     * @brief Applies one fill.
+     *
+     * @param trade The trade object from `user.trades` or an order response.
+     * @param out [optional] Receives the position after the fill.
+     * @return True if the fill was applied, false if it was a duplicate or malformed.
+     */
+    bool onTrade(const nlohmann::json& trade, position* out = nullptr);
+
+    /**
+     * @brief Reconciles one instrument against the exchange, adopting the exchange's view.
+     *
+     * @param instrument The instrument name.
+     * @param exchangeSize The signed size reported by the exchange.
+     * @param exchangeAveragePrice The average price reported by the exchange.
+     * @return positionDrift The differences before adoption.
+     */
+    positionDrift reconcile(const std::string& instrument, double exchangeSize, double exchangeAveragePrice);
+
+    /**
+     * @brief Copies the position of one instrument.
+     *
+     * @param instrument The instrument name.
+     * @param out Receives the position.
+     * @return True if the instrument has been seen.
+     */
+    bool get(const std::string& instrument, position& out) const;
+
+    /**
+     * @brief Copies all known positions.
+     *
+     * @return std::vector<position> The positions, including flat ones.
+     */
+    std::vector<position> all() const;
+
+    /**
+     * @brief Gets the number of reconciliations that found a drift.
+     *
+     * @return uint64_t The number of drifts detected.
+     */
+    uint64_t driftCount() const;
+
+private:
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    std::unordered_map<std::string, position> m_positions; ///< Positions by instrument name.
+    std::unordered_set<std::string> m_seenTrades; ///< Recent trade IDs.
+    std::deque<std::string> m_tradeOrder; ///< Recent trade IDs, oldest first.
+    size_t m_tradeHistory; ///< Number of trade IDs kept.
+    uint64_t m_driftCount; ///< Reconciliations that found a drift.
+};
+
+#endif // POSITIONTRACKER_H
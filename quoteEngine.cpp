@@ -0,0 +1,251 @@
+/**
+ * @file quoteEngine.cpp
+ * @brief Implementation of the two-sided quoting engine.
+ */
+
+#include "quoteEngine.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructs a quoting engine.
+ *
+ * @param orders The order manager holding the quotes' live state.
+ */
+quoteEngine::quoteEngine(orderManager& orders)
+    : m_orders(orders) {}
+
+/**
+ * @brief Starts (or reconfigures) quoting an instrument.
+ *
+ * Existing slots keep their orders when the number of levels does not change.
+ *
+ * @param instrument The instrument name.
+ * @param config The quoting parameters.
+ */
+void quoteEngine::start(const std::string& instrument, const quoteConfig& config) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    book& b = m_books[instrument];
+    b.config = config;
+    if (b.config.levels < 1) {
+        b.config.levels = 1;
+    }
+    b.bids.resize(b.config.levels);
+    b.asks.resize(b.config.levels);
+}
+
+/**
+ * @brief Stops quoting an instrument.
+ *
+ * @param instrument The instrument name.
+ * @param out Receives cancels for the live quotes.
+ */
+void quoteEngine::stop(const std::string& instrument, std::vector<quoteAction>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_books.find(instrument);
+    if (it == m_books.end()) {
+        return;
+    }
+    for (std::vector<slot>* side : {&it->second.bids, &it->second.asks}) {
+        for (const slot& s : *side) {
+            order o;
+            if (s.clientId < kPlacing && m_orders.get(s.clientId, o) && o.isLive() && !o.orderId.empty()) {
+                quoteAction action;
+                action.type = quoteAction::kind::cancel;
+                action.instrument = instrument;
+                action.direction = o.direction;
+                action.orderId = o.orderId;
+                out.push_back(action);
+                ++m_stats.cancels;
+            }
+        }
+    }
+    m_books.erase(it);
+}
+
+/**
+ * @brief Stops quoting every instrument without emitting cancels.
+ */
+void quoteEngine::stopAll() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_books.clear();
+}
+
+/**
+ * @brief Checks whether an instrument is being quoted.
+ *
+ * @param instrument The instrument name.
+ * @return True if quoting is active.
+ */
+bool quoteEngine::isQuoting(const std::string& instrument) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_books.count(instrument) != 0;
+}
+
+/**
+ * @brief Compares one slot with its target and emits the request needed, if any.
+ *
+ * @param instrument The instrument name.
+ * @param config The quoting parameters.
+ * @param s The ladder slot.
+ * @param direction "buy" or "sell".
+ * @param level The ladder level.
+ * @param target The target price.
+ * @param now The current time.
+ * @param out Receives the request.
+ */
+void quoteEngine::diff(const std::string& instrument, const quoteConfig& config, slot& s, const char* direction, int level, double target, clock::time_point now, std::vector<quoteAction>& out) {
+    if (target <= 0.0 || s.clientId == kPlacing) {
+        return;
+    }
+    quoteAction action;
+    action.instrument = instrument;
+    action.direction = direction;
+    action.level = level;
+    action.amount = config.size;
+    action.price = target;
+
+    order o;
+    bool known = s.clientId != orderManager::kInvalidId && m_orders.get(s.clientId, o);
+    bool live = known && o.isLive();
+    if (!live) {
+        if (known && o.state == orderState::rejected) {
+            backOff(s, now);
+            s.clientId = orderManager::kInvalidId;
+        }
+        if (now < s.retryAfter) {
+            ++m_stats.suppressed;
+            return;
+        }
+        action.type = quoteAction::kind::place;
+        s.clientId = kPlacing;
+        out.push_back(action);
+        ++m_stats.places;
+        return;
+    }
+    if (o.orderId.empty()) {
+        return; // Still waiting for the acknowledgement
+    }
+    s.rejects = 0;
+    bool moved = std::fabs(o.price - target) >= std::max(config.hysteresis, config.tickSize * 0.5);
+    if (!moved) {
+        return;
+    }
+    if (now - s.lastEdit < std::chrono::milliseconds(config.minRequoteMs)) {
+        ++m_stats.suppressed;
+        return;
+    }
+    action.type = quoteAction::kind::edit;
+    action.orderId = o.orderId;
+    s.lastEdit = now;
+    out.push_back(action);
+    ++m_stats.edits;
+}
+
+/**
+ * @brief Delays the next placement of a slot after a reject, doubling the wait each time.
+ *
+ * @param s The ladder slot.
+ * @param now The current time.
+ */
+void quoteEngine::backOff(slot& s, clock::time_point now) {
+    ++m_stats.rejected;
+    long delayMs = kRejectBackoffMs << std::min<uint32_t>(s.rejects, 16);
+    s.retryAfter = now + std::chrono::milliseconds(std::min(delayMs, kMaxRejectBackoffMs));
+    ++s.rejects;
+}
+
+/**
+ * @brief Recomputes the targets of one instrument from its last top of book.
+ *
+ * Bids are rounded down and asks up to the tick size, so quotes never cross the mid.
+ *
+ * @param instrument The instrument name.
+ * @param b The instrument's quoting state.
+ * @param out Receives the requests to send.
+ */
+void quoteEngine::requote(const std::string& instrument, book& b, std::vector<quoteAction>& out) {
+    if (b.bestBid <= 0.0 || b.bestAsk <= 0.0) {
+        return;
+    }
+    const quoteConfig& config = b.config;
+    double tick = config.tickSize > 0.0 ? config.tickSize : 1.0;
+    double mid = (b.bestBid + b.bestAsk) / 2.0;
+    clock::time_point now = clock::now();
+    for (int level = 0; level < config.levels; ++level) {
+        double offset = config.halfSpread + level * config.levelStep;
+        double bid = std::floor((mid - offset) / tick) * tick;
+        double ask = std::ceil((mid + offset) / tick) * tick;
+        diff(instrument, config, b.bids[level], "buy", level, bid, now, out);
+        diff(instrument, config, b.asks[level], "sell", level, ask, now, out);
+    }
+}
+
+/**
+ * @brief Recomputes targets after a top-of-book change.
+ *
+ * @param instrument The instrument name.
+ * @param bestBid The best bid price.
+ * @param bestAsk The best ask price.
+ * @param out Receives the requests to send.
+ */
+void quoteEngine::onTopOfBook(const std::string& instrument, double bestBid, double bestAsk, std::vector<quoteAction>& out) {
+    if (bestBid <= 0.0 || bestAsk <= 0.0 || bestAsk < bestBid) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_books.find(instrument);
+    if (it == m_books.end()) {
+        return;
+    }
+    it->second.bestBid = bestBid;
+    it->second.bestAsk = bestAsk;
+    requote(instrument, it->second, out);
+}
+
+/**
+ * @brief Recomputes targets of every instrument from the last top of book.
+ *
+ * @param out Receives the requests to send.
+ */
+void quoteEngine::refresh(std::vector<quoteAction>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_books) {
+        requote(entry.first, entry.second, out);
+    }
+}
+
+/**
+ * @brief Binds a placed quote to its ladder slot.
+ *
+ * @param instrument The instrument name.
+ * @param direction "buy" or "sell".
+ * @param level The ladder level.
+ * @param clientId The client-side ID returned by placeOrder (kInvalidId if it was rejected).
+ */
+void quoteEngine::bind(const std::string& instrument, const std::string& direction, int level, uint32_t clientId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_books.find(instrument);
+    if (it == m_books.end()) {
+        return;
+    }
+    std::vector<slot>& side = direction == "sell" ? it->second.asks : it->second.bids;
+    if (level >= 0 && level < static_cast<int>(side.size())) {
+        clock::time_point now = clock::now();
+        side[level].clientId = clientId;
+        side[level].lastEdit = now;
+        if (clientId == orderManager::kInvalidId) {
+            backOff(side[level], now);
+        }
+    }
+}
+
+/**
+ * @brief Gets the engine counters.
+ *
+ * @return quoteStats A snapshot of the counters.
+ */
+quoteStats quoteEngine::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file quoteEngine.h
+ * @brief Header file for the two-sided quoting engine.
+ *
+ * This file defines the `quoteEngine` class, which keeps bid/ask ladders per instrument
+ * and turns top-of-book changes into the minimal set of new, edit and cancel requests.
+ */
+
+#ifndef QUOTEENGINE_H
+#define QUOTEENGINE_H
+
+#include "orderManager.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Quoting parameters of one instrument.
+ */
+struct quoteConfig {
+    int levels = 1;              ///< Number of quotes per side.
+    double size = 0.0;           ///< Amount of every quote.
+    double halfSpread = 0.0;     ///< Distance of the first level from the mid price.
+    double levelStep = 0.0;      ///< Distance between consecutive levels.
+    double tickSize = 0.5;       ///< Price increment of the instrument.
+    double hysteresis = 0.0;     ///< Minimum price move before a live quote is edited.
+    long minRequoteMs = 100;     ///< Minimum time between edits of the same quote.
+};
+
+/**
+ * @brief A request the quoting engine wants sent.
+ */
+struct quoteAction {
+    /**
+     * @brief Kind of request.
+     */
+    enum class kind : uint8_t {
+        place, ///< Place a new quote (private/buy or private/sell).
+        edit,  ///< Move a live quote (private/edit).
+        cancel ///< Pull a live quote (private/cancel).
+    };
+
+    kind type = kind::place;    ///< Kind of request.
+    std::string instrument;     ///< Instrument name.
+    std::string direction;      ///< "buy" or "sell".
+    int level = 0;              ///< Ladder level (0 is closest to mid).
+    double amount = 0.0;        ///< Quote amount.
+    double price = 0.0;         ///< Target price.
+    std::string orderId;        ///< Exchange order ID for edits and cancels.
+};
+
+/**
+ * @brief Counters of the quoting engine.
+ */
+struct quoteStats {
+    uint64_t places = 0;        ///< New quotes requested.
+    uint64_t edits = 0;         ///< Edits requested.
+    uint64_t cancels = 0;       ///< Cancels requested.
+    uint64_t suppressed = 0;    ///< Re-quotes skipped by hysteresis or throttling.
+    uint64_t rejected = 0;      ///< Quotes rejected locally or by the exchange.
+};
+
+/**
+ * @class quoteEngine
+ * @brief Diffs target quotes against live orders.
+ *
+ * Targets are computed from the top of book and compared with the live order of every
+ * ladder slot (looked up in the order manager). Slots without a live order get a new
+ * quote; live quotes are moved with an edit only when the target moved by at least the
+ * hysteresis and the slot's throttle interval has elapsed, instead of cancel/replace.
+ * A slot whose quote was rejected (risk, kill switch, rate limiter or exchange) backs off
+ * exponentially before placing again, so a persistent reject does not retry every tick.
+ * All methods are thread-safe.
+ */
+class quoteEngine {
+public:
+    /**
+     * @brief Constructs a quoting engine.
+     *
+     * @param orders The order manager holding the quotes' live state.
+     */
+    explicit quoteEngine(orderManager& orders);
+
+    /**
+     * @brief Starts (or reconfigures) quoting an instrument.
+     *
+     * @param instrument The instrument name.
+     * @param config The quoting parameters.
+     */
+    void start(const std::string& instrument, const quoteConfig& config);
+
+    /**
+     * @brief Stops quoting an instrument.
+     *
+     * @param instrument The instrument name.
+     * @param out Receives cancels for the live quotes.
+     */
+    void stop(const std::string& instrument, std::vector<quoteAction>& out);
+
+    /**
+     * @brief Stops quoting every instrument without emitting cancels.
+     *
+     * Used when the orders are being cancelled by other means (e.g., the kill switch).
+     */
+    void stopAll();
+
+    /**
+     * @brief Checks whether an instrument is being quoted.
+     *
+     * @param instrument The instrument name.
+     * @return True if quoting is active.
+     */
+    bool isQuoting(const std::string& instrument) const;
+
+    /**
+     * @brief Recomputes targets after a top-of-book change.
+     *
+     * @param instrument The instrument name.
+     * @param bestBid The best bid price.
+     * @param bestAsk The best ask price.
+     * @param out Receives the requests to send.
+     */
+    void onTopOfBook(const std::string& instrument, double bestBid, double bestAsk, std::vector<quoteAction>& out);
+
+    /**
+     * @brief Recomputes targets of every instrument from the last top of book.
+     *
+     * Called periodically so re-quotes held back by the throttle are sent even when the
+     * book goes quiet.
+     *
+     * @param out Receives the requests to send.
+     */
+    void refresh(std::vector<quoteAction>& out);
+
+    /**
+     * @brief Binds a placed quote to its ladder slot.
+     *
+     * @param instrument The instrument name.
+     * @param direction "buy" or "sell".
+     * @param level The ladder level.
+     * @param clientId The client-side ID returned by placeOrder (kInvalidId if it was rejected).
+     */
+    void bind(const std::string& instrument, const std::string& direction, int level, uint32_t clientId);
+
+    /**
+     * @brief Gets the engine counters.
+     *
+     * @return quoteStats A snapshot of the counters.
+     */
+    quoteStats stats() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr uint32_t kPlacing = orderManager::kInvalidId - 1; ///< Slot awaiting bind().
+    static constexpr long kRejectBackoffMs = 250; ///< Wait before placing again after the first reject.
+    static constexpr long kMaxRejectBackoffMs = 30000; ///< Longest wait between placement attempts.
+
+    /**
+     * @brief One ladder slot.
+     */
+    struct slot {
+        uint32_t clientId = orderManager::kInvalidId; ///< Order quoting this slot.
+        clock::time_point lastEdit;                   ///< Time of the last edit.
+        clock::time_point retryAfter;                 ///< No new quote before this time.
+        uint32_t rejects = 0;                         ///< Consecutive rejected placements.
+    };
+
+    /**
+     * @brief Quoting state of one instrument.
+     */
+    struct book {
+        quoteConfig config;
+        std::vector<slot> bids;
+        std::vector<slot> asks;
+        double bestBid = 0.0;   ///< Last best bid seen.
+        double bestAsk = 0.0;   ///< Last best ask seen.
+    };
+
+    void requote(const std::string& instrument, book& b, std::vector<quoteAction>& out);
+    void backOff(slot& s, clock::time_point now);
+    void diff(const std::string& instrument, const quoteConfig& config, slot& s, const char* direction, int level, double target, clock::time_point now, std::vector<quoteAction>& out);
+
+    orderManager& m_orders; ///< Live order state.
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    std::unordered_map<std::string, book> m_books; ///< Quoting state by instrument.
+    quoteStats m_stats; ///< Counters.
+};
+
+#endif // QUOTEENGINE_H
@@ -0,0 +1,205 @@
+/**
+ * @file rateLimiter.cpp
+ * @brief Implementation of the client-side rate limiter.
+ */
+
+#include "rateLimiter.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+/**
+ * @brief Adds the credits earned since the last refill.
+ *
+ * @param now The current monotonic time.
+ */
+void rateLimiter::bucket::refill(clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    if (elapsed > 0.0) {
+        credits = std::min(capacity, credits + elapsed * refillPerSecond);
+        lastRefill = now;
+    }
+}
+
+/**
+ * @brief Computes how long until one request's worth of credits is available.
+ *
+ * @return long Milliseconds to wait, at least 1.
+ */
+long rateLimiter::bucket::millisUntilAvailable() const {
+    if (refillPerSecond <= 0.0) {
+        return 1000;
+    }
+    double missing = std::max(0.0, cost - credits);
+    return std::max(1L, static_cast<long>(std::ceil(missing * 1000.0 / refillPerSecond)));
+}
+
+/**
+ * @brief Constructs a limiter with Deribit's default limits.
+ */
+rateLimiter::rateLimiter()
+    : m_policy(overflowPolicy::queue),
+      m_maxQueueDepth(1000),
+      m_exchangeRejects(0) {
+    configure(creditPool::nonMatching, 50000.0, 10000.0, 500.0);
+    configure(creditPool::matching, 10000.0, 2500.0, 500.0);
+}
+
+/**
+ * @brief Configures one credit pool.
+ *
+ * The pool starts full.
+ *
+ * @param pool The pool to configure.
+ * @param capacity The maximum number of credits.
+ * @param refillPerSecond Credits added per second.
+ * @param cost Credits charged per request.
+ */
+void rateLimiter::configure(creditPool pool, double capacity, double refillPerSecond, double cost) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bucket& b = poolOf(pool);
+    b.capacity = capacity;
+    b.refillPerSecond = refillPerSecond;
+    b.cost = cost;
+    b.credits = capacity;
+    b.lastRefill = clock::now();
+}
+
+/**
+ * @brief Sets the overflow policy and queue limit.
+ *
+ * @param policy What to do when a pool is out of credits.
+ * @param maxQueueDepth Maximum number of queued messages per pool.
+ */
+void rateLimiter::setPolicy(overflowPolicy policy, size_t maxQueueDepth) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy = policy;
+    m_maxQueueDepth = maxQueueDepth;
+}
+
+/**
+ * @brief Submits a message for sending.
+ *
+ * @param pool The pool the request is charged to.
+ * @param message The serialized request; moved into the queue if it has to wait.
+ * @return admission Whether to send now, or whether it was queued or rejected.
+ */
+admission rateLimiter::admit(creditPool pool, std::string& message) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bucket& b = poolOf(pool);
+    b.refill(clock::now());
+    if (b.queue.empty() && !b.draining && b.credits >= b.cost) {
+        b.credits -= b.cost;
+        ++b.stats.sent;
+        return admission::send;
+    }
+    if (m_policy == overflowPolicy::reject || b.queue.size() >= m_maxQueueDepth) {
+        ++b.stats.rejected;
+        return admission::rejected;
+    }
+    b.queue.push_back(std::move(message));
+    ++b.stats.queued;
+    return admission::queued;
+}
+
+/**
+ * @brief Removes queued messages that now have credits.
+ *
+ * @param out Receives the messages to send, in order.
+ * @return long Milliseconds until the next queued message has credits, or -1 if nothing is queued.
+ */
+long rateLimiter::drain(std::vector<std::string>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    clock::time_point now = clock::now();
+    long next = -1;
+    for (bucket& b : m_pools) {
+        b.refill(now);
+        while (!b.queue.empty() && b.credits >= b.cost) {
+            b.credits -= b.cost;
+            out.push_back(std::move(b.queue.front()));
+            b.queue.pop_front();
+            b.draining = true;
+            ++b.stats.sent;
+        }
+        if (!b.queue.empty()) {
+            long wait = b.millisUntilAvailable();
+            next = next < 0 ? wait : std::min(next, wait);
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Marks the messages returned by the last drain as written.
+ */
+void rateLimiter::endDrain() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (bucket& b : m_pools) {
+        b.draining = false;
+    }
+}
+
+/**
+ * @brief Drops every queued message of a pool.
+ *
+ * @param pool The pool to clear.
+ * @return std::vector<std::string> The dropped messages, oldest first.
+ */
+std::vector<std::string> rateLimiter::clear(creditPool pool) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bucket& b = poolOf(pool);
+    std::vector<std::string> dropped(std::make_move_iterator(b.queue.begin()), std::make_move_iterator(b.queue.end()));
+    b.queue.clear();
+    b.stats.rejected += dropped.size();
+    return dropped;
+}
+
+/**
+ * @brief Gets the number of messages waiting for credits across all pools.
+ *
+ * @return size_t The number of queued messages.
+ */
+size_t rateLimiter::queueDepth() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pools[0].queue.size() + m_pools[1].queue.size();
+}
+
+/**
+ * @brief Records a rate-limit error (10028) returned by the exchange.
+ *
+ * @param pool The pool the failed request was charged to.
+ */
+void rateLimiter::onRateLimited(creditPool pool) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bucket& b = poolOf(pool);
+    b.refill(clock::now());
+    b.credits = 0.0;
+    ++m_exchangeRejects;
+}
+
+/**
+ * @brief Gets the counters of one pool.
+ *
+ * @param pool The pool.
+ * @return creditPoolStats A snapshot of the counters.
+ */
+creditPoolStats rateLimiter::stats(creditPool pool) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bucket& b = poolOf(pool);
+    b.refill(clock::now());
+    creditPoolStats result = b.stats;
+    result.credits = b.credits;
+    result.capacity = b.capacity;
+    result.queueDepth = b.queue.size();
+    return result;
+}
+
+/**
+ * @brief Gets the number of rate-limit errors returned by the exchange.
+ *
+ * @return uint64_t The number of 10028 errors seen.
+ */
+uint64_t rateLimiter::exchangeRejects() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_exchangeRejects;
+}
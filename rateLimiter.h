@@ -0,0 +1,191 @@
+/**
+ * @file rateLimiter.h
+ * @brief Header file for the client-side rate limiter.
+ *
+ * This file defines the `rateLimiter` class, which mirrors Deribit's credit-based rate
+ * limits with one token bucket per credit pool, so bursts are queued or rejected locally
+ * instead of being answered with `too_many_requests` (10028) by the exchange.
+ */
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Deribit credit pools.
+ */
+enum class creditPool : uint8_t {
+    matching,    ///< Matching-engine requests (buy, sell, edit, cancel, ...).
+    nonMatching  ///< Every other request.
+};
+
+/**
+ * @brief Outcome of submitting a message to the rate limiter.
+ */
+enum class admission : uint8_t {
+    send,     ///< Credits were available; send the message now.
+    queued,   ///< The message was queued until credits refill.
+    rejected  ///< The message was dropped locally.
+};
+
+/**
+ * @brief Counters of one credit pool.
+ */
+struct creditPoolStats {
+    double credits = 0.0;        ///< Credits currently available.
+    double capacity = 0.0;       ///< Maximum credits (burst size times cost).
+    size_t queueDepth = 0;       ///< Messages waiting for credits.
+    uint64_t sent = 0;           ///< Messages admitted immediately or from the queue.
+    uint64_t queued = 0;         ///< Messages that had to wait for credits.
+    uint64_t rejected = 0;       ///< Messages dropped locally.
+};
+
+/**
+ * @class rateLimiter
+ * @brief Token-bucket limiter modeled on Deribit's credit system.
+ *
+ * Each pool holds up to `capacity` credits, refills at `refillPerSecond` and charges
+ * `cost` credits per request. Refill is computed lazily from a monotonic clock on every
+ * call, so no timer thread is needed; the owner drains queued messages from its own
+ * event loop using the delay returned by `drain`. All methods are thread-safe.
+ */
+class rateLimiter {
+public:
+    /**
+     * @brief What to do with a message when its pool is out of credits.
+     */
+    enum class overflowPolicy : uint8_t {
+        queue, ///< Hold the message until credits refill (up to the queue limit).
+        reject ///< Drop the message.
+    };
+
+    /**
+     * @brief Constructs a limiter with Deribit's default limits.
+     *
+     * Non-matching: 50000 credits, 10000 credits/s, 500 per request (20 req/s, burst 100).
+     * Matching: 10000 credits, 2500 credits/s, 500 per request (5 req/s, burst 20).
+     */
+    rateLimiter();
+
+    /**
+     * @brief Configures one credit pool.
+     *
+     * @param pool The pool to configure.
+     * @param capacity The maximum number of credits.
+     * @param refillPerSecond Credits added per second.
+     * @param cost Credits charged per request.
+     */
+    void configure(creditPool pool, double capacity, double refillPerSecond, double cost);
+
+    /**
+     * @brief Sets the overflow policy and queue limit.
+     *
+     * @param policy What to do when a pool is out of credits.
+     * @param maxQueueDepth Maximum number of queued messages per pool.
+     */
+    void setPolicy(overflowPolicy policy, size_t maxQueueDepth = 1000);
+
+    /**
+     * @brief Submits a message for sending.
+     *
+     * Messages are admitted in FIFO order per pool: while older messages are queued, or
+     * drained but not yet written (see endDrain), new ones queue behind them even if
+     * credits are available.
+     *
+     * @param pool The pool the request is charged to.
+     * @param message The serialized request; moved into the queue if it has to wait.
+     * @return admission Whether to send now, or whether it was queued or rejected.
+     */
+    admission admit(creditPool pool, std::string& message);
+
+    /**
+     * @brief Removes queued messages that now have credits.
+     *
+     * @param out Receives the messages to send, in order.
+     * @return long Milliseconds until the next queued message has credits, or -1 if nothing is queued.
+     */
+    long drain(std::vector<std::string>& out);
+
+    /**
+     * @brief Marks the messages returned by the last drain as written.
+     *
+     * Until then, admit() queues every message of a pool that drain returned messages
+     * from, so nothing overtakes them between the drain and the write.
+     */
+    void endDrain();
+
+    /**
+     * @brief Drops every queued message of a pool.
+     *
+     * @param pool The pool to clear.
+     * @return std::vector<std::string> The dropped messages, oldest first.
+     */
+    std::vector<std::string> clear(creditPool pool);
+
+    /**
+     * @brief Gets the number of messages waiting for credits across all pools.
+     *
+     * @return size_t The number of queued messages.
+     */
+    size_t queueDepth() const;
+
+    /**
+     * @brief Records a rate-limit error (10028) returned by the exchange.
+     *
+     * The pool is emptied so subsequent requests back off until credits refill.
+     *
+     * @param pool The pool the failed request was charged to.
+     */
+    void onRateLimited(creditPool pool);
+
+    /**
+     * @brief Gets the counters of one pool.
+     *
+     * @param pool The pool.
+     * @return creditPoolStats A snapshot of the counters.
+     */
+    creditPoolStats stats(creditPool pool);
+
+    /**
+     * @brief Gets the number of rate-limit errors returned by the exchange.
+     *
+     * @return uint64_t The number of 10028 errors seen.
+     */
+    uint64_t exchangeRejects() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Token bucket and queue of one pool.
+     */
+    struct bucket {
+        double capacity = 0.0;
+        double refillPerSecond = 0.0;
+        double cost = 0.0;
+        double credits = 0.0;
+        clock::time_point lastRefill;
+        std::deque<std::string> queue;
+        bool draining = false;
+        creditPoolStats stats;
+
+        void refill(clock::time_point now);
+        long millisUntilAvailable() const;
+    };
+
+    bucket& poolOf(creditPool pool) { return m_pools[static_cast<size_t>(pool)]; }
+
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    bucket m_pools[2]; ///< Buckets indexed by creditPool.
+    overflowPolicy m_policy; ///< Overflow policy.
+    size_t m_maxQueueDepth; ///< Queue limit per pool.
+    uint64_t m_exchangeRejects; ///< Number of 10028 errors seen.
+};
+
+#endif // RATELIMITER_H
@@ -0,0 +1,272 @@
+/**
+ * @file riskManager.cpp
+ * @brief Implementation of the pre-trade risk gate.
+ */
+
+#include "riskManager.h"
+#include "instrumentKey.h"
+#include <cmath>
+#include <functional>
+
+namespace {
+
+    constexpr double kUnlimited = std::numeric_limits<double>::infinity();
+
+    /**
+     * @brief Maps a configured limit to its stored form (0 means unlimited).
+     *
+     * @param value The configured limit.
+     * @return double The limit, or infinity if disabled.
+     */
+    double limitOrUnlimited(double value) {
+        return value > 0.0 ? value : kUnlimited;
+    }
+
+    /**
+     * @brief Adds to an atomic double.
+     *
+     * @param target The atomic to update.
+     * @param delta The value to add.
+     */
+    void atomicAdd(std::atomic<double>& target, double delta) {
+        double current = target.load(std::memory_order_relaxed);
+        while (!target.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+/**
+ * @brief Returns a printable description of a risk check outcome.
+ *
+ * @param result The risk check outcome.
+ * @return const char* The description.
+ */
+const char* toString(riskResult result) {
+    switch (result) {
+        case riskResult::accepted: return "accepted";
+        case riskResult::orderTooLarge: return "order amount above limit";
+        case riskResult::notionalTooLarge: return "order notional above limit";
+        case riskResult::noReferencePrice: return "no reference price for notional";
+        case riskResult::outsideCollar: return "price outside collar around mark";
+        case riskResult::tooManyOpenOrders: return "too many open orders on instrument";
+        case riskResult::positionLimit: return "instrument position limit";
+        case riskResult::accountOpenOrders: return "too many open orders on account";
+        case riskResult::accountPosition: return "account gross position limit";
+        case riskResult::tooManyInstruments: return "instrument table full";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Constructs a limit set with every check disabled.
+ */
+riskManager::limitSet::limitSet()
+    : maxOrderAmount(kUnlimited),
+      maxOrderNotional(kUnlimited),
+      priceCollar(kUnlimited),
+      maxOpenOrders(kUnlimited),
+      maxPosition(kUnlimited) {}
+
+/**
+ * @brief Stores configured limits, mapping 0 to unlimited.
+ *
+ * @param limits The configured limits.
+ */
+void riskManager::limitSet::store(const riskLimits& limits) {
+    maxOrderAmount.store(limitOrUnlimited(limits.maxOrderAmount), std::memory_order_relaxed);
+    maxOrderNotional.store(limitOrUnlimited(limits.maxOrderNotional), std::memory_order_relaxed);
+    priceCollar.store(limitOrUnlimited(limits.priceCollar), std::memory_order_relaxed);
+    maxOpenOrders.store(limitOrUnlimited(limits.maxOpenOrders), std::memory_order_relaxed);
+    maxPosition.store(limitOrUnlimited(limits.maxPosition), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Constructs a risk manager with no limits configured.
+ */
+riskManager::riskManager()
+    : m_instruments(kMaxInstruments),
+      m_maxAccountOpenOrders(kUnlimited),
+      m_maxGrossPosition(kUnlimited),
+      m_accountOpenOrders(0),
+      m_grossPosition(0.0) {}
+
+/**
+ * @brief Finds or claims the table slot of an instrument.
+ *
+ * Slots are claimed with a compare-and-swap on the key and never released. Names that
+ * parse are keyed exactly by their packed instrument key; others by a string hash tagged
+ * with kind bits no packed key uses, so the two never collide.
+ *
+ * @param instrument The instrument name.
+ * @return instrumentState* The slot, or nullptr if the table is full.
+ */
+riskManager::instrumentState* riskManager::slot(const std::string& instrument) {
+    uint64_t key;
+    if (!instrumentKey::parse(instrument, key)) {
+        key = (std::hash<std::string>{}(instrument) << 3) | 0x7;
+    }
+    size_t mask = kMaxInstruments - 1;
+    for (size_t probe = 0, i = instrumentKey::hash(key) & mask; probe < kMaxInstruments; ++probe, i = (i + 1) & mask) {
+        instrumentState& state = m_instruments[i];
+        uint64_t current = state.key.load(std::memory_order_acquire);
+        if (current == key) {
+            return &state;
+        }
+        if (current == 0) {
+            if (state.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || current == key) {
+                return &state;
+            }
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Sets the limits used by instruments without their own limits.
+ *
+ * @param limits The default limits.
+ */
+void riskManager::setDefaultLimits(const riskLimits& limits) {
+    m_defaults.store(limits);
+}
+
+/**
+ * @brief Sets the limits for one instrument.
+ *
+ * @param instrument The instrument name.
+ * @param limits The limits for the instrument.
+ */
+void riskManager::setLimits(const std::string& instrument, const riskLimits& limits) {
+    instrumentState* state = slot(instrument);
+    if (state) {
+        state->limits.store(limits);
+        state->hasLimits.store(true, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Sets the account-wide limits.
+ *
+ * @param maxOpenOrders The maximum number of open orders across all instruments (0 disables).
+ * @param maxGrossPosition The maximum sum of absolute positions across all instruments (0 disables).
+ */
+void riskManager::setAccountLimits(int maxOpenOrders, double maxGrossPosition) {
+    m_maxAccountOpenOrders.store(limitOrUnlimited(maxOpenOrders), std::memory_order_relaxed);
+    m_maxGrossPosition.store(limitOrUnlimited(maxGrossPosition), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Checks an order against the cached state.
+ *
+ * A collar is only enforced once a mark price has been seen for the instrument. Inverse
+ * contracts are already sized in USD, so their amount is the notional; other orders are
+ * valued at the limit price or the mark, and are rejected when a notional limit is set but
+ * neither is known yet. Position limits never block an order that reduces the position.
+ *
+ * @param instrument The instrument name.
+ * @param direction "buy" or "sell".
+ * @param amount The order amount.
+ * @param price The limit price, or 0 for orders without a price (the mark is used for notional).
+ * @return riskResult The first failed check, or riskResult::accepted.
+ */
+riskResult riskManager::check(const std::string& instrument, const std::string& direction, double amount, double price) {
+    instrumentState* state = slot(instrument);
+    if (!state) {
+        return riskResult::tooManyInstruments;
+    }
+    const limitSet& limits = state->hasLimits.load(std::memory_order_acquire) ? state->limits : m_defaults;
+
+    double mark = state->markPrice.load(std::memory_order_relaxed);
+    double position = state->position.load(std::memory_order_relaxed);
+    double signedAmount = direction == "sell" ? -amount : amount;
+    double effectivePrice = price > 0.0 ? price : mark;
+    double after = position + signedAmount;
+
+    if (amount > limits.maxOrderAmount.load(std::memory_order_relaxed)) {
+        return riskResult::orderTooLarge;
+    }
+    double maxNotional = limits.maxOrderNotional.load(std::memory_order_relaxed);
+    if (instrumentKey::isInverse(state->key.load(std::memory_order_relaxed))) {
+        if (amount > maxNotional) {
+            return riskResult::notionalTooLarge;
+        }
+    } else if (maxNotional != kUnlimited) {
+        if (!(effectivePrice > 0.0)) {
+            return riskResult::noReferencePrice;
+        }
+        if (amount * effectivePrice > maxNotional) {
+            return riskResult::notionalTooLarge;
+        }
+    }
+    if (price > 0.0 && mark > 0.0 && std::fabs(price - mark) > limits.priceCollar.load(std::memory_order_relaxed) * mark) {
+        return riskResult::outsideCollar;
+    }
+    if (state->openOrders.load(std::memory_order_relaxed) >= limits.maxOpenOrders.load(std::memory_order_relaxed)) {
+        return riskResult::tooManyOpenOrders;
+    }
+    if (std::fabs(after) > limits.maxPosition.load(std::memory_order_relaxed) && std::fabs(after) > std::fabs(position)) {
+        return riskResult::positionLimit;
+    }
+    if (m_accountOpenOrders.load(std::memory_order_relaxed) >= m_maxAccountOpenOrders.load(std::memory_order_relaxed)) {
+        return riskResult::accountOpenOrders;
+    }
+    double gross = m_grossPosition.load(std::memory_order_relaxed);
+    double grossAfter = gross - std::fabs(position) + std::fabs(after);
+    if (grossAfter > m_maxGrossPosition.load(std::memory_order_relaxed) && grossAfter > gross) {
+        return riskResult::accountPosition;
+    }
+    return riskResult::accepted;
+}
+
+/**
+ * @brief Updates the cached mark price of an instrument.
+ *
+ * @param instrument The instrument name.
+ * @param markPrice The mark price.
+ */
+void riskManager::onMarkPrice(const std::string& instrument, double markPrice) {
+    instrumentState* state = slot(instrument);
+    if (state) {
+        state->markPrice.store(markPrice, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Updates the cached position of an instrument.
+ *
+ * @param instrument The instrument name.
+ * @param size The signed position size (negative for short).
+ */
+void riskManager::onPosition(const std::string& instrument, double size) {
+    instrumentState* state = slot(instrument);
+    if (state) {
+        double previous = state->position.exchange(size, std::memory_order_relaxed);
+        atomicAdd(m_grossPosition, std::fabs(size) - std::fabs(previous));
+    }
+}
+
+/**
+ * @brief Counts an order that became live.
+ *
+ * @param instrument The instrument name.
+ */
+void riskManager::onOrderOpened(const std::string& instrument) {
+    instrumentState* state = slot(instrument);
+    if (state) {
+        state->openOrders.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_accountOpenOrders.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Releases an order that is no longer live.
+ *
+ * @param instrument The instrument name.
+ */
+void riskManager::onOrderClosed(const std::string& instrument) {
+    instrumentState* state = slot(instrument);
+    if (state) {
+        state->openOrders.fetch_sub(1, std::memory_order_relaxed);
+    }
+    m_accountOpenOrders.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,177 @@
+/**
+ * @file riskManager.h
+ * @brief Header file for the pre-trade risk gate.
+ *
+ * This file defines the `riskManager` class, which checks every outgoing order against
+ * size, notional, price collar, open-order and position limits using cached state only.
+ */
+
+#ifndef RISKMANAGER_H
+#define RISKMANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Outcome of a pre-trade risk check.
+ */
+enum class riskResult : uint8_t {
+    accepted,            ///< The order passed every check.
+    orderTooLarge,       ///< Amount exceeds the per-order limit.
+    notionalTooLarge,    ///< Amount times price (the amount alone for inverse contracts) exceeds the notional limit.
+    noReferencePrice,    ///< A notional limit is set but the order has no price and no mark has been seen.
+    outsideCollar,       ///< Price is too far from the local mark price.
+    tooManyOpenOrders,   ///< The instrument already has the maximum number of open orders.
+    positionLimit,       ///< The fill would take the instrument position past its limit.
+    accountOpenOrders,   ///< The account already has the maximum number of open orders.
+    accountPosition,     ///< The fill would take the account gross position past its limit.
+    tooManyInstruments   ///< The instrument table is full.
+};
+
+/**
+ * @brief Returns a printable description of a risk check outcome.
+ *
+ * @param result The risk check outcome.
+ * @return const char* The description.
+ */
+const char* toString(riskResult result);
+
+/**
+ * @brief Per-instrument risk limits. A value of 0 disables the check.
+ */
+struct riskLimits {
+    double maxOrderAmount = 0.0;   ///< Maximum amount of a single order.
+    double maxOrderNotional = 0.0; ///< Maximum amount times price of a single order (the amount for inverse contracts).
+    double priceCollar = 0.0;      ///< Maximum distance from the mark price as a fraction (0.05 = 5%).
+    int maxOpenOrders = 0;         ///< Maximum number of open orders.
+    double maxPosition = 0.0;      ///< Maximum absolute position.
+};
+
+/**
+ * @class riskManager
+ * @brief Lock-free pre-trade risk gate.
+ *
+ * Instrument state lives in a fixed open-addressed table of atomics keyed by the packed
+ * instrument key (instrumentKey.h), or by a tagged string hash for names that do not
+ * parse. Marks, positions and open-order counts are written from the I/O thread
+ * while checks run on whichever thread places the order, without taking a lock.
+ * Disabled limits are stored as infinity so a check is a fixed sequence of compares.
+ */
+class riskManager {
+public:
+    /**
+     * @brief Constructs a risk manager with no limits configured.
+     */
+    riskManager();
+
+    /**
+     * @brief Sets the limits used by instruments without their own limits.
+     *
+     * @param limits The default limits.
+     */
+    void setDefaultLimits(const riskLimits& limits);
+
+    /**
+     * @brief Sets the limits for one instrument.
+     *
+     * @param instrument The instrument name.
+     * @param limits The limits for the instrument.
+     */
+    void setLimits(const std::string& instrument, const riskLimits& limits);
+
+    /**
+     * @brief Sets the account-wide limits.
+     *
+     * @param maxOpenOrders The maximum number of open orders across all instruments (0 disables).
+     * @param maxGrossPosition The maximum sum of absolute positions across all instruments (0 disables).
+     */
+    void setAccountLimits(int maxOpenOrders, double maxGrossPosition);
+
+    /**
+     * @brief Checks an order against the cached state.
+     *
+     * Inverse contracts are already sized in USD, so their amount is the notional; other orders are
+     * valued at the limit price or the mark, and are rejected when a notional limit is set but
+     * neither is known yet. Position limits never block an order that reduces the position.
+     *
+     * @param instrument The instrument name.
+     * @param direction "buy" or "sell".
+     * @param amount The order amount.
+     * @param price The limit price, or 0 for orders without a price (the mark is used for notional).
+     * @return riskResult The first failed check, or riskResult::accepted.
+     */
+    riskResult check(const std::string& instrument, const std::string& direction, double amount, double price);
+
+    /**
+     * @brief Updates the cached mark price of an instrument.
+     *
+     * @param instrument The instrument name.
+     * @param markPrice The mark price.
+     */
+    void onMarkPrice(const std::string& instrument, double markPrice);
+
+    /**
+     * @brief Updates the cached position of an instrument.
+     *
+     * @param instrument The instrument name.
+     * @param size The signed position size (negative for short).
+     */
+    void onPosition(const std::string& instrument, double size);
+
+    /**
+     * @brief Counts an order that became live.
+     *
+     * @param instrument The instrument name.
+     */
+    void onOrderOpened(const std::string& instrument);
+
+    /**
+     * @brief Releases an order that is no longer live.
+     *
+     * @param instrument The instrument name.
+     */
+    void onOrderClosed(const std::string& instrument);
+
+private:
+    static constexpr size_t kMaxInstruments = 1024; ///< Table size; must be a power of two.
+
+    /**
+     * @brief Limits with disabled checks stored as infinity.
+     */
+    struct limitSet {
+        std::atomic<double> maxOrderAmount;
+        std::atomic<double> maxOrderNotional;
+        std::atomic<double> priceCollar;
+        std::atomic<double> maxOpenOrders;
+        std::atomic<double> maxPosition;
+
+        limitSet();
+        void store(const riskLimits& limits);
+    };
+
+    /**
+     * @brief Cached state of one instrument.
+     */
+    struct instrumentState {
+        std::atomic<uint64_t> key{0};        ///< Packed instrument key (or tagged name hash); 0 marks an empty slot.
+        std::atomic<double> markPrice{0.0};  ///< Last mark price.
+        std::atomic<double> position{0.0};   ///< Signed position size.
+        std::atomic<int> openOrders{0};      ///< Number of live orders.
+        std::atomic<bool> hasLimits{false};  ///< Whether `limits` overrides the defaults.
+        limitSet limits;                     ///< Instrument-specific limits.
+    };
+
+    instrumentState* slot(const std::string& instrument);
+
+    std::vector<instrumentState> m_instruments; ///< Open-addressed instrument table.
+    limitSet m_defaults; ///< Limits of instruments without their own.
+    std::atomic<double> m_maxAccountOpenOrders; ///< Account open-order limit.
+    std::atomic<double> m_maxGrossPosition; ///< Account gross position limit.
+    std::atomic<int> m_accountOpenOrders; ///< Live orders across all instruments.
+    std::atomic<double> m_grossPosition; ///< Sum of absolute positions.
+};
+
+#endif // RISKMANAGER_H
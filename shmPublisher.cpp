@@ -0,0 +1,240 @@
+/**
+ * @file shmPublisher.cpp
+ * @brief Implementation of the shared-memory market data publisher and reader.
+ */
+
+#include "shmPublisher.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    /**
+     * @brief Computes the size of a region.
+     *
+     * @param ringCapacity The number of ring slots.
+     * @param directoryCapacity The number of directory entries.
+     * @return size_t The size in bytes.
+     */
+    size_t regionSize(size_t ringCapacity, size_t directoryCapacity) {
+        return sizeof(shmHeader) + directoryCapacity * sizeof(shmInstrument) + ringCapacity * sizeof(shmSlot);
+    }
+}
+
+/**
+ * @brief Creates (or recreates) the shared-memory region.
+ *
+ * An existing region of the same name is unlinked first; readers still attached to it
+ * keep their mapping and must reattach to see the new one.
+ *
+ * @param name The shm_open name, starting with '/'.
+ * @param ringCapacity The number of ring slots; rounded up to a power of two.
+ * @param directoryCapacity The maximum number of instruments.
+ * @throws std::runtime_error If the region cannot be created or mapped.
+ */
+shmPublisher::shmPublisher(const std::string& name, size_t ringCapacity, size_t directoryCapacity)
+    : m_name(name), m_base(nullptr), m_size(0), m_header(nullptr), m_directory(nullptr), m_ring(nullptr), m_mask(0) {
+    size_t capacity = 1;
+    while (capacity < ringCapacity) {
+        capacity <<= 1;
+    }
+    m_size = regionSize(capacity, directoryCapacity);
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open failed for " + name + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(m_size)) != 0) {
+        int error = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("ftruncate failed for " + name + ": " + std::strerror(error));
+    }
+    m_base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_base == MAP_FAILED) {
+        int error = errno;
+        shm_unlink(name.c_str());
+        throw std::runtime_error("mmap failed for " + name + ": " + std::strerror(error));
+    }
+
+    // ftruncate zero-fills, so every slot starts with sequence 0 (never written)
+    char* base = static_cast<char*>(m_base);
+    m_header = reinterpret_cast<shmHeader*>(base);
+    m_directory = reinterpret_cast<shmInstrument*>(base + sizeof(shmHeader));
+    m_ring = reinterpret_cast<shmSlot*>(base + sizeof(shmHeader) + directoryCapacity * sizeof(shmInstrument));
+    m_mask = capacity - 1;
+    m_header->version = shmHeader::kVersion;
+    m_header->directoryCapacity = static_cast<uint32_t>(directoryCapacity);
+    m_header->ringCapacity = static_cast<uint32_t>(capacity);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = shmHeader::kMagic; // Readers check this last
+}
+
+/**
+ * @brief Unmaps and unlinks the region.
+ */
+shmPublisher::~shmPublisher() {
+    if (m_base && m_base != MAP_FAILED) {
+        munmap(m_base, m_size);
+    }
+    shm_unlink(m_name.c_str());
+}
+
+/**
+ * @brief Publishes a buffer of concatenated binary events.
+ *
+ * Each event takes one slot. `instrument` events also fill the directory entry of
+ * their ID, so readers can name instruments without replaying the ring.
+ *
+ * @param events The events, as produced by eventNormalizer.
+ * @param length The length of the buffer in bytes.
+ */
+void shmPublisher::publish(const char* events, size_t length) {
+    const char* cursor = events;
+    const char* end = events + length;
+    binaryEvents::eventHeader header;
+    while (const char* event = binaryEvents::nextEvent(cursor, end, header)) {
+        if (header.size > binaryEvents::kMaxEventSize) {
+            continue;
+        }
+        binaryEvents::instrumentEvent definition;
+        if (binaryEvents::read(event, binaryEvents::eventType::instrument, definition) &&
+            header.instrumentId < m_header->directoryCapacity) {
+            // Directory entries are written once, before the count that publishes them
+            uint32_t count = m_header->instrumentCount.load(std::memory_order_relaxed);
+            if (header.instrumentId >= count) {
+                std::memcpy(m_directory[header.instrumentId].name, definition.name, sizeof(definition.name));
+                m_directory[header.instrumentId].name[sizeof(shmInstrument::name) - 1] = '\0';
+                m_header->instrumentCount.store(header.instrumentId + 1, std::memory_order_release);
+            }
+        }
+
+        uint64_t n = m_header->writeIndex.load(std::memory_order_relaxed);
+        shmSlot& slot = m_ring[n & m_mask];
+        slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(slot.event, event, header.size);
+        slot.sequence.store(2 * n + 2, std::memory_order_release);
+        m_header->writeIndex.store(n + 1, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Gets the number of events published.
+ *
+ * @return uint64_t The count.
+ */
+uint64_t shmPublisher::published() const {
+    return m_header->writeIndex.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the shm_open name of the region.
+ *
+ * @return const std::string& The name.
+ */
+const std::string& shmPublisher::name() const {
+    return m_name;
+}
+
+/**
+ * @brief Attaches to an existing region.
+ *
+ * @param name The shm_open name used by the publisher.
+ * @throws std::runtime_error If the region does not exist or has another layout.
+ */
+shmReader::shmReader(const std::string& name)
+    : m_base(nullptr), m_size(0), m_header(nullptr), m_directory(nullptr), m_ring(nullptr), m_mask(0), m_next(0) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open failed for " + name + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(shmHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Shared-memory region " + name + " is not initialized");
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    m_base = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_base == MAP_FAILED) {
+        m_base = nullptr;
+        throw std::runtime_error("mmap failed for " + name + ": " + std::strerror(errno));
+    }
+
+    const char* base = static_cast<const char*>(m_base);
+    m_header = reinterpret_cast<const shmHeader*>(base);
+    uint32_t magic = m_header->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (magic != shmHeader::kMagic || m_header->version != shmHeader::kVersion ||
+        regionSize(m_header->ringCapacity, m_header->directoryCapacity) != m_size) {
+        munmap(m_base, m_size);
+        m_base = nullptr;
+        throw std::runtime_error("Shared-memory region " + name + " has an unknown layout");
+    }
+    m_directory = reinterpret_cast<const shmInstrument*>(base + sizeof(shmHeader));
+    m_ring = reinterpret_cast<const shmSlot*>(base + sizeof(shmHeader) + m_header->directoryCapacity * sizeof(shmInstrument));
+    m_mask = m_header->ringCapacity - 1;
+    m_next = m_header->writeIndex.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Unmaps the region.
+ */
+shmReader::~shmReader() {
+    if (m_base) {
+        munmap(m_base, m_size);
+    }
+}
+
+/**
+ * @brief Reads the next event, if there is one.
+ *
+ * @param event Receives the binary event; read it with binaryEvents::read.
+ * @return shmPoll What was read.
+ */
+shmPoll shmReader::poll(char (&event)[binaryEvents::kMaxEventSize]) {
+    uint64_t written = m_header->writeIndex.load(std::memory_order_acquire);
+    if (m_next >= written) {
+        return shmPoll::empty;
+    }
+    if (written - m_next > m_mask) {
+        m_next = written - m_mask; // Leave one slot of slack for the writer
+        return shmPoll::overrun;
+    }
+    const shmSlot& slot = m_ring[m_next & m_mask];
+    uint64_t expected = 2 * m_next + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+        m_next = m_header->writeIndex.load(std::memory_order_acquire) - m_mask;
+        return shmPoll::overrun;
+    }
+    std::memcpy(event, slot.event, sizeof(slot.event));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+        m_next = m_header->writeIndex.load(std::memory_order_acquire) - m_mask;
+        return shmPoll::overrun;
+    }
+    ++m_next;
+    return shmPoll::event;
+}
+
+/**
+ * @brief Gets the instrument name of a directory ID.
+ *
+ * @param id The instrument ID.
+ * @return std::string The name, or an empty string for an unknown ID.
+ */
+std::string shmReader::instrumentName(uint32_t id) const {
+    if (id >= m_header->instrumentCount.load(std::memory_order_acquire)) {
+        return std::string();
+    }
+    const char* name = m_directory[id].name;
+    return std::string(name, strnlen(name, sizeof(shmInstrument::name)));
+}
@@ -0,0 +1,185 @@
+/**
+ * @file shmPublisher.h
+ * @brief Header file for the shared-memory market data publisher.
+ *
+ * This file defines the shared-memory layout, the `shmPublisher` class, which writes
+ * normalized binary events (binaryEvents.h) into it, and the `shmReader` class, which
+ * other processes on the host use to consume them without a socket of their own.
+ */
+
+#ifndef SHMPUBLISHER_H
+#define SHMPUBLISHER_H
+
+#include "binaryEvents.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Header at the start of the shared-memory region.
+ */
+struct shmHeader {
+    static constexpr uint32_t kMagic = 0x444d4344; ///< "DCMD" in little-endian.
+    static constexpr uint32_t kVersion = 2; ///< Layout version; readers must match it.
+
+    uint32_t magic; ///< kMagic once the region is initialized.
+    uint32_t version; ///< kVersion.
+    uint32_t directoryCapacity; ///< Number of directory entries.
+    uint32_t ringCapacity; ///< Number of ring slots (a power of two).
+    std::atomic<uint32_t> instrumentCount; ///< Directory entries in use; published after the entry.
+    uint32_t reserved; ///< Padding.
+    alignas(64) std::atomic<uint64_t> writeIndex; ///< Number of events published so far.
+};
+
+/**
+ * @brief Directory entry: the instrument name of a dense instrument ID.
+ */
+struct shmInstrument {
+    char name[64]; ///< NUL-terminated instrument name.
+};
+
+/**
+ * @brief One ring slot, guarded by its own seqlock.
+ *
+ * Event `n` lives in slot `n % ringCapacity`. The writer sets `sequence` to 2n+1 before
+ * writing and to 2n+2 after; a reader that sees 2n+2 both before and after copying the
+ * payload has a consistent event. The payload is one binary event (binaryEvents.h).
+ */
+struct alignas(64) shmSlot {
+    std::atomic<uint64_t> sequence; ///< Seqlock sequence; odd while the slot is written.
+    uint64_t reserved; ///< Keeps the payload 16-byte aligned.
+    char event[binaryEvents::kMaxEventSize]; ///< The binary event.
+};
+
+static_assert(sizeof(shmSlot) == 192, "shmSlot must stay three cache lines");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+/**
+ * @class shmPublisher
+ * @brief Single-writer publisher of market data events into POSIX shared memory.
+ *
+ * The region holds a header, a directory mapping dense instrument IDs to names, and a
+ * ring of seqlocked slots holding one binary event each. The writer never waits for
+ * readers; a reader that falls more than a ring behind detects the overrun and skips
+ * ahead. `publish` must be called from one thread (the client's event loop).
+ */
+class shmPublisher {
+public:
+    static constexpr const char* kDefaultName = "/dericonsole-md"; ///< Default shm_open name.
+
+    /**
+     * @brief Creates (or recreates) the shared-memory region.
+     *
+     * @param name The shm_open name, starting with '/'.
+     * @param ringCapacity The number of ring slots; rounded up to a power of two.
+     * @param directoryCapacity The maximum number of instruments.
+     * @throws std::runtime_error If the region cannot be created or mapped.
+     */
+    explicit shmPublisher(const std::string& name = kDefaultName, size_t ringCapacity = 65536, size_t directoryCapacity = 4096);
+
+    /**
+     * @brief Unmaps and unlinks the region.
+     */
+    ~shmPublisher();
+
+    shmPublisher(const shmPublisher&) = delete;
+    shmPublisher& operator=(const shmPublisher&) = delete;
+
+    /**
+     * @brief Publishes a buffer of concatenated binary events.
+     *
+     * Each event takes one slot. `instrument` events also fill the directory entry of
+     * their ID, so readers can name instruments without replaying the ring.
+     *
+     * @param events The events, as produced by eventNormalizer.
+     * @param length The length of the buffer in bytes.
+     */
+    void publish(const char* events, size_t length);
+
+    /**
+     * @brief Gets the number of events published.
+     *
+     * @return uint64_t The count.
+     */
+    uint64_t published() const;
+
+    /**
+     * @brief Gets the shm_open name of the region.
+     *
+     * @return const std::string& The name.
+     */
+    const std::string& name() const;
+
+private:
+    std::string m_name; ///< shm_open name.
+    void* m_base; ///< Start of the mapping.
+    size_t m_size; ///< Size of the mapping.
+    shmHeader* m_header; ///< Header in the mapping.
+    shmInstrument* m_directory; ///< Directory in the mapping.
+    shmSlot* m_ring; ///< Ring in the mapping.
+    uint64_t m_mask; ///< ringCapacity - 1.
+};
+
+/**
+ * @brief Result of polling a shared-memory reader.
+ */
+enum class shmPoll : uint8_t {
+    event,    ///< An event was read.
+    empty,    ///< No new event yet.
+    overrun   ///< The reader fell a ring behind; it skipped to the oldest available event.
+};
+
+/**
+ * @class shmReader
+ * @brief Reader of a region written by `shmPublisher`, for use in other processes.
+ *
+ * A reader maps the region read-only and starts at the writer's current position.
+ * Readers never write to the region, so any number can attach.
+ */
+class shmReader {
+public:
+    /**
+     * @brief Attaches to an existing region.
+     *
+     * @param name The shm_open name used by the publisher.
+     * @throws std::runtime_error If the region does not exist or has another layout.
+     */
+    explicit shmReader(const std::string& name = shmPublisher::kDefaultName);
+
+    /**
+     * @brief Unmaps the region.
+     */
+    ~shmReader();
+
+    shmReader(const shmReader&) = delete;
+    shmReader& operator=(const shmReader&) = delete;
+
+    /**
+     * @brief Reads the next event, if there is one.
+     *
+     * @param event Receives the binary event; read it with binaryEvents::read.
+     * @return shmPoll What was read.
+     */
+    shmPoll poll(char (&event)[binaryEvents::kMaxEventSize]);
+
+    /**
+     * @brief Gets the instrument name of a directory ID.
+     *
+     * @param id The instrument ID.
+     * @return std::string The name, or an empty string for an unknown ID.
+     */
+    std::string instrumentName(uint32_t id) const;
+
+private:
+    void* m_base; ///< Start of the mapping.
+    size_t m_size; ///< Size of the mapping.
+    const shmHeader* m_header; ///< Header in the mapping.
+    const shmInstrument* m_directory; ///< Directory in the mapping.
+    const shmSlot* m_ring; ///< Ring in the mapping.
+    uint64_t m_mask; ///< ringCapacity - 1.
+    uint64_t m_next; ///< Number of the next event to read.
+};
+
+#endif // SHMPUBLISHER_H
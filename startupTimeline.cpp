@@ -0,0 +1,112 @@
+/**
+ * @file startupTimeline.cpp
+ * @brief Implementation of the startup timeline.
+ */
+
+#include "startupTimeline.h"
+#include "tscClock.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Returns a printable name for a startup stage.
+ *
+ * @param stage The stage.
+ * @return const char* The name.
+ */
+const char* toString(startupStage stage) {
+    switch (stage) {
+        case startupStage::created: return "client created";
+        case startupStage::connectStarted: return "connect started";
+        case startupStage::connected: return "TLS/WebSocket open";
+        case startupStage::authSent: return "auth sent";
+        case startupStage::authenticated: return "authenticated";
+        case startupStage::cancelOnDisconnect: return "cancel-on-disconnect enabled";
+        case startupStage::subscribed: return "subscriptions acknowledged";
+        case startupStage::snapshotsLoaded: return "snapshots loaded";
+        case startupStage::firstMarketData: return "first market data";
+        case startupStage::tradeable: return "tradeable";
+        case startupStage::count: break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Constructs a timeline and records the `created` stage.
+ */
+startupTimeline::startupTimeline() : m_startNs(tscClock::instance().monotonicNs()) {
+    for (std::atomic<int64_t>& stamp : m_stampsNs) {
+        stamp = 0;
+    }
+    m_stampsNs[static_cast<size_t>(startupStage::created)] = m_startNs;
+}
+
+/**
+ * @brief Records a stage if it has not been reached before.
+ *
+ * @param stage The stage.
+ * @return True if this call recorded it.
+ */
+bool startupTimeline::mark(startupStage stage) {
+    std::atomic<int64_t>& stamp = m_stampsNs[static_cast<size_t>(stage)];
+    // Hot paths call this on every message; only the first call pays for the clock
+    if (stamp.load(std::memory_order_relaxed) != 0) {
+        return false;
+    }
+    int64_t expected = 0;
+    return stamp.compare_exchange_strong(expected, tscClock::instance().monotonicNs());
+}
+
+/**
+ * @brief Checks whether a stage was reached.
+ *
+ * @param stage The stage.
+ * @return True if it was recorded.
+ */
+bool startupTimeline::reached(startupStage stage) const {
+    return m_stampsNs[static_cast<size_t>(stage)].load() != 0;
+}
+
+/**
+ * @brief Gets the time from construction to a stage.
+ *
+ * @param stage The stage.
+ * @return int64_t Nanoseconds, or -1 if the stage was not reached.
+ */
+int64_t startupTimeline::elapsedNs(startupStage stage) const {
+    int64_t stamp = m_stampsNs[static_cast<size_t>(stage)].load();
+    return stamp == 0 ? -1 : stamp - m_startNs;
+}
+
+/**
+ * @brief Formats the reached stages, one per line, in the order they were reached.
+ *
+ * @return std::string The report.
+ */
+std::string startupTimeline::report() const {
+    std::vector<std::pair<int64_t, startupStage>> reachedStages;
+    for (size_t i = 0; i < m_stampsNs.size(); ++i) {
+        int64_t elapsed = elapsedNs(static_cast<startupStage>(i));
+        if (elapsed >= 0) {
+            reachedStages.emplace_back(elapsed, static_cast<startupStage>(i));
+        }
+    }
+    std::stable_sort(reachedStages.begin(), reachedStages.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::string out;
+    int64_t previous = 0;
+    for (const auto& [elapsed, stage] : reachedStages) {
+        fmt::format_to(std::back_inserter(out), "  {:>9.1f} ms  (+{:>7.1f})  {}\n", elapsed / 1e6, (elapsed - previous) / 1e6,
+                       toString(stage));
+        previous = elapsed;
+    }
+    for (size_t i = 0; i < m_stampsNs.size(); ++i) {
+        if (!reached(static_cast<startupStage>(i))) {
+            fmt::format_to(std::back_inserter(out), "  {:>9}{:16}{}\n", "-", "", toString(static_cast<startupStage>(i)));
+        }
+    }
+    return out;
+}
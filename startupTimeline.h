@@ -0,0 +1,93 @@
+/**
+ * @file startupTimeline.h
+ * @brief Header file for the startup timeline.
+ *
+ * This file defines the `startupTimeline` class, which records when each stage of
+ * bringing the client up (connection, authentication, subscriptions, snapshots) was
+ * first reached.
+ */
+
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Stages of startup, in their usual order.
+ */
+enum class startupStage : uint8_t {
+    created,              ///< Client constructed.
+    connectStarted,       ///< DNS, TCP and TLS handshake started.
+    connected,            ///< WebSocket open.
+    authSent,             ///< Authorization request written.
+    authenticated,        ///< Access token received.
+    cancelOnDisconnect,   ///< Cancel-on-disconnect enabled.
+    subscribed,           ///< Every desired channel acknowledged.
+    snapshotsLoaded,      ///< Every book summary requested so far answered.
+    firstMarketData,      ///< First channel notification received.
+    tradeable,            ///< Orders can be sent and their updates are tracked.
+    count                 ///< Number of stages.
+};
+
+/**
+ * @brief Returns a printable name for a startup stage.
+ *
+ * @param stage The stage.
+ * @return const char* The name.
+ */
+const char* toString(startupStage stage);
+
+/**
+ * @class startupTimeline
+ * @brief Monotonic timestamps of the first time each startup stage was reached.
+ *
+ * Stages are recorded once; later reconnects do not move them. Marking and reading are
+ * lock-free and may happen on any thread.
+ */
+class startupTimeline {
+public:
+    /**
+     * @brief Constructs a timeline and records the `created` stage.
+     */
+    startupTimeline();
+
+    /**
+     * @brief Records a stage if it has not been reached before.
+     *
+     * @param stage The stage.
+     * @return True if this call recorded it.
+     */
+    bool mark(startupStage stage);
+
+    /**
+     * @brief Checks whether a stage was reached.
+     *
+     * @param stage The stage.
+     * @return True if it was recorded.
+     */
+    bool reached(startupStage stage) const;
+
+    /**
+     * @brief Gets the time from construction to a stage.
+     *
+     * @param stage The stage.
+     * @return int64_t Nanoseconds, or -1 if the stage was not reached.
+     */
+    int64_t elapsedNs(startupStage stage) const;
+
+    /**
+     * @brief Formats the reached stages, one per line, in the order they were reached.
+     *
+     * @return std::string The report.
+     */
+    std::string report() const;
+
+private:
+    int64_t m_startNs; ///< Monotonic time of construction.
+    std::array<std::atomic<int64_t>, static_cast<size_t>(startupStage::count)> m_stampsNs; ///< Monotonic time per stage, 0 until reached.
+};
+
+#endif // STARTUPTIMELINE_H
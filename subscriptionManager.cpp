@@ -0,0 +1,462 @@
+/**
+ * @file subscriptionManager.cpp
+ * @brief Implementation of the subscription manager.
+ */
+
+#include "subscriptionManager.h"
+#include <algorithm>
+#include <unordered_set>
+
+/**
+ * @brief Returns a printable name for a channel state.
+ *
+ * @param state The channel state.
+ * @return const char* The state name.
+ */
+const char* toString(channelState state) {
+    switch (state) {
+        case channelState::unsubscribed: return "unsubscribed";
+        case channelState::subscribing: return "subscribing";
+        case channelState::subscribed: return "subscribed";
+        case channelState::unsubscribing: return "unsubscribing";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Constructs a subscription manager.
+ *
+ * @param maxChannelsPerRequest The maximum number of channels packed into one request.
+ */
+subscriptionManager::subscriptionManager(size_t maxChannelsPerRequest)
+    : m_maxChannelsPerRequest(maxChannelsPerRequest > 0 ? maxChannelsPerRequest : 1),
+      m_nextSequence(0),
+      m_quietWindows(0) {}
+
+/**
+ * @brief Adds channels to the desired set on behalf of an owner.
+ *
+ * @param channels The channels to subscribe to.
+ * @param owner The party that wants them.
+ */
+void subscriptionManager::add(const std::vector<std::string>& channels, subscriptionOwner owner) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint8_t bit = uint8_t(1) << static_cast<unsigned>(owner);
+    for (const std::string& channel : channels) {
+        uint8_t& owners = m_owners[channel];
+        bool wanted = owners != 0;
+        owners |= bit;
+        if (owner == subscriptionOwner::gateway) {
+            // Downstream clients asked for this exact channel; a slower variant would starve them
+            for (size_t i = 0; i < m_downgrades.size(); ++i) {
+                if (m_downgrades[i].raw == channel) {
+                    restore(i, nullptr);
+                    break;
+                }
+            }
+        }
+        if (wanted) {
+            continue; // Already in the desired set for another owner
+        }
+        bool downgraded = false;
+        for (downgrade& d : m_downgrades) {
+            downgraded = downgraded || d.raw == channel;
+            if (d.slow == channel) {
+                d.addedSlow = false; // Wanted on its own now; keep it after an upgrade
+            }
+        }
+        if (!downgraded) {
+            m_channels[channel].desired = true;
+        }
+    }
+}
+
+/**
+ * @brief Releases an owner's interest in channels.
+ *
+ * A channel leaves the desired set only once no owner wants it any more.
+ *
+ * @param channels The channels to unsubscribe from.
+ * @param owner The party releasing them.
+ */
+void subscriptionManager::remove(const std::vector<std::string>& channels, subscriptionOwner owner) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint8_t bit = uint8_t(1) << static_cast<unsigned>(owner);
+    for (const std::string& channel : channels) {
+        auto owners = m_owners.find(channel);
+        if (owners == m_owners.end() || (owners->second & bit) == 0) {
+            continue; // This owner never asked for it
+        }
+        owners->second &= static_cast<uint8_t>(~bit);
+        if (owners->second != 0) {
+            continue; // Still wanted by another owner
+        }
+        m_owners.erase(owners);
+        bool keep = false;
+        for (size_t i = 0; i < m_downgrades.size(); ++i) {
+            downgrade& d = m_downgrades[i];
+            if (d.raw == channel) {
+                if (d.addedSlow) {
+                    m_channels[d.slow].desired = false;
+                }
+                m_downgrades.erase(m_downgrades.begin() + i);
+                break;
+            }
+            if (d.slow == channel) {
+                d.addedSlow = true; // Still feeding a downgraded raw channel
+                keep = true;
+            }
+        }
+        auto it = m_channels.find(channel);
+        if (it != m_channels.end() && !keep) {
+            it->second.desired = false;
+        }
+    }
+}
+
+/**
+ * @brief Checks whether an owner wants a channel.
+ *
+ * @param channel The channel name.
+ * @param owner The owner.
+ * @return True if the owner added the channel and has not removed it.
+ */
+bool subscriptionManager::isWantedBy(const std::string& channel, subscriptionOwner owner) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_owners.find(channel);
+    return it != m_owners.end() && (it->second & (uint8_t(1) << static_cast<unsigned>(owner))) != 0;
+}
+
+/**
+ * @brief Checks whether a channel is in the desired set.
+ *
+ * @param channel The channel name.
+ * @return True if the channel is wanted.
+ */
+bool subscriptionManager::isDesired(const std::string& channel) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_channels.find(channel);
+    if (it != m_channels.end() && it->second.desired) {
+        return true;
+    }
+    for (const downgrade& d : m_downgrades) {
+        if (d.raw == channel) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Appends a channel to the open batch of its kind, starting a new batch when full.
+ *
+ * @param out The batches being planned.
+ * @param open Index in `out` of the open batch per (subscribe, private) kind.
+ * @param subscribe True for subscribe, false for unsubscribe.
+ * @param channel The channel name.
+ */
+void subscriptionManager::addToBatch(std::vector<subscriptionBatch>& out, size_t (&open)[2][2], bool subscribe, const std::string& channel) {
+    bool isPrivate = channel.rfind("user.", 0) == 0;
+    size_t& index = open[subscribe][isPrivate];
+    if (index == SIZE_MAX || out[index].channels.size() >= m_maxChannelsPerRequest) {
+        subscriptionBatch batch;
+        batch.subscribe = subscribe;
+        batch.isPrivate = isPrivate;
+        batch.requestId = kRequestBase + m_nextSequence;
+        m_nextSequence = (m_nextSequence + 1) % kRequestRange;
+        index = out.size();
+        out.push_back(std::move(batch));
+    }
+    out[index].channels.push_back(channel);
+}
+
+/**
+ * @brief Computes the requests that move the exchange towards the desired set.
+ *
+ * @param out Receives the batches to send.
+ */
+void subscriptionManager::plan(std::vector<subscriptionBatch>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t first = out.size();
+    size_t open[2][2] = {{SIZE_MAX, SIZE_MAX}, {SIZE_MAX, SIZE_MAX}};
+    for (auto it = m_channels.begin(); it != m_channels.end();) {
+        entry& e = it->second;
+        if (e.desired && e.state == channelState::unsubscribed) {
+            e.state = channelState::subscribing;
+            addToBatch(out, open, true, it->first);
+        } else if (!e.desired && e.state == channelState::subscribed) {
+            e.state = channelState::unsubscribing;
+            addToBatch(out, open, false, it->first);
+        } else if (!e.desired && e.state == channelState::unsubscribed) {
+            it = m_channels.erase(it);
+            continue;
+        }
+        ++it;
+    }
+    for (size_t i = first; i < out.size(); ++i) {
+        m_inFlight[out[i].requestId] = out[i];
+    }
+}
+
+/**
+ * @brief Checks whether a request ID belongs to a subscription batch.
+ *
+ * @param requestId The JSON-RPC request ID.
+ * @return True if the ID is in the batch range.
+ */
+bool subscriptionManager::isBatchRequest(int requestId) {
+    return requestId >= kRequestBase && requestId < kRequestBase + kRequestRange;
+}
+
+/**
+ * @brief Applies the response to a batch.
+ *
+ * @param requestId The JSON-RPC request ID of the response.
+ * @param response The full JSON response.
+ * @param rejected Receives the channels the exchange did not acknowledge.
+ * @return size_t The number of channels acknowledged.
+ */
+size_t subscriptionManager::onResponse(int requestId, const nlohmann::json& response, std::vector<std::string>& rejected) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_inFlight.find(requestId);
+    if (found == m_inFlight.end()) {
+        return 0; // Stale: sent before a reset
+    }
+    subscriptionBatch batch = std::move(found->second);
+    m_inFlight.erase(found);
+
+    std::unordered_set<std::string> acknowledged;
+    if (response.contains("result") && response["result"].is_array()) {
+        for (const auto& channel : response["result"]) {
+            if (channel.is_string()) {
+                acknowledged.insert(channel.get<std::string>());
+            }
+        }
+    }
+    channelState pending = batch.subscribe ? channelState::subscribing : channelState::unsubscribing;
+    size_t count = 0;
+    for (const std::string& channel : batch.channels) {
+        auto it = m_channels.find(channel);
+        if (it == m_channels.end() || it->second.state != pending) {
+            continue;
+        }
+        bool ok = acknowledged.count(channel) != 0;
+        if (batch.subscribe) {
+            it->second.state = ok ? channelState::subscribed : channelState::unsubscribed;
+        } else {
+            it->second.state = ok ? channelState::unsubscribed : channelState::subscribed;
+        }
+        if (ok) {
+            ++count;
+        } else {
+            rejected.push_back(channel);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Forgets every exchange-side state, e.g., after the connection dropped.
+ */
+void subscriptionManager::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_inFlight.clear();
+    for (auto it = m_channels.begin(); it != m_channels.end();) {
+        if (!it->second.desired) {
+            it = m_channels.erase(it);
+        } else {
+            it->second.state = channelState::unsubscribed;
+            ++it;
+        }
+    }
+}
+
+/**
+ * @brief Lists every known channel with its desired and actual state.
+ *
+ * @return std::vector<channelStatus> The channels, sorted by name.
+ */
+std::vector<channelStatus> subscriptionManager::list() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<channelStatus> result;
+    result.reserve(m_channels.size());
+    for (const auto& item : m_channels) {
+        channelStatus status;
+        status.channel = item.first;
+        status.desired = item.second.desired;
+        status.state = item.second.state;
+        result.push_back(std::move(status));
+    }
+    return result;
+}
+
+/**
+ * @brief Keeps an instrument's channels on raw regardless of load.
+ *
+ * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+ * @param pinned True to pin, false to release.
+ */
+void subscriptionManager::setPinned(const std::string& instrument, bool pinned) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!pinned) {
+        m_pinned.erase(instrument);
+        return;
+    }
+    m_pinned.insert(instrument);
+    for (size_t i = m_downgrades.size(); i-- > 0;) {
+        if (instrumentOf(m_downgrades[i].raw) == instrument) {
+            restore(i, nullptr);
+        }
+    }
+}
+
+/**
+ * @brief Checks whether an instrument is pinned to raw.
+ *
+ * @param instrument The instrument name.
+ * @return True if the instrument is pinned.
+ */
+bool subscriptionManager::isPinned(const std::string& instrument) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pinned.count(instrument) != 0;
+}
+
+/**
+ * @brief Adds the decode cost of one channel message to the current window.
+ *
+ * @param channel The channel the message arrived on.
+ * @param ns Time spent decoding and handling the message, in nanoseconds.
+ */
+void subscriptionManager::recordCost(const std::string& channel, int64_t ns) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_costs[channel] += ns;
+}
+
+/**
+ * @brief Closes a load window and downgrades or upgrades channels.
+ *
+ * A saturated window downgrades the costliest eligible channels until the shed cost
+ * covers the excess over the middle of the hysteresis band; at least one channel is
+ * downgraded. Channels the gateway owns are never downgraded. Recovery upgrades one
+ * channel every kRecoveryWindows quiet windows.
+ *
+ * @param utilization Fraction of the window the event loop spent handling messages.
+ * @param changes Receives the channels moved to a different interval.
+ */
+void subscriptionManager::adapt(double utilization, std::vector<intervalChange>& changes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<std::string, int64_t> costs;
+    costs.swap(m_costs);
+
+    if (utilization < kUpgradeBelow) {
+        if (!m_downgrades.empty() && ++m_quietWindows >= kRecoveryWindows) {
+            m_quietWindows = 0;
+            restore(m_downgrades.size() - 1, &changes);
+        }
+        return;
+    }
+    m_quietWindows = 0;
+    if (utilization <= kDowngradeAbove) {
+        return;
+    }
+
+    int64_t total = 0;
+    std::vector<std::pair<int64_t, std::string>> candidates;
+    for (const auto& cost : costs) {
+        total += cost.second;
+        auto it = m_channels.find(cost.first);
+        if (it == m_channels.end() || !it->second.desired || slowVariant(cost.first).empty() ||
+            m_pinned.count(instrumentOf(cost.first)) != 0) {
+            continue;
+        }
+        // The gateway forwards channels by their exact name, so its channels are never slowed
+        auto owners = m_owners.find(cost.first);
+        if (owners != m_owners.end() && (owners->second & (uint8_t(1) << static_cast<unsigned>(subscriptionOwner::gateway))) != 0) {
+            continue;
+        }
+        candidates.emplace_back(cost.second, cost.first);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    double target = (kDowngradeAbove + kUpgradeBelow) / 2;
+    int64_t needed = static_cast<int64_t>(static_cast<double>(total) * (utilization - target) / utilization);
+    int64_t shed = 0;
+    for (const auto& candidate : candidates) {
+        if (shed > 0 && shed >= needed) {
+            break;
+        }
+        downgrade d;
+        d.raw = candidate.second;
+        d.slow = slowVariant(candidate.second);
+        entry& slow = m_channels[d.slow];
+        d.addedSlow = !slow.desired;
+        slow.desired = true;
+        m_channels[d.raw].desired = false;
+        changes.push_back({d.raw, d.slow});
+        m_downgrades.push_back(std::move(d));
+        shed += candidate.first;
+    }
+}
+
+/**
+ * @brief Lists the raw channels currently replaced by a slower variant.
+ *
+ * @return std::vector<intervalChange> The downgrades, oldest first.
+ */
+std::vector<intervalChange> subscriptionManager::downgrades() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<intervalChange> result;
+    result.reserve(m_downgrades.size());
+    for (const downgrade& d : m_downgrades) {
+        result.push_back({d.raw, d.slow});
+    }
+    return result;
+}
+
+/**
+ * @brief Moves a downgraded channel back to raw. The mutex must be held.
+ *
+ * @param index Index of the downgrade in m_downgrades.
+ * @param changes Receives the upgrade, if not null.
+ */
+void subscriptionManager::restore(size_t index, std::vector<intervalChange>* changes) {
+    downgrade d = std::move(m_downgrades[index]);
+    m_downgrades.erase(m_downgrades.begin() + index);
+    m_channels[d.raw].desired = true;
+    if (d.addedSlow) {
+        m_channels[d.slow].desired = false;
+    }
+    if (changes) {
+        changes->push_back({d.slow, d.raw});
+    }
+}
+
+/**
+ * @brief Extracts the instrument from a channel name ("book.BTC-PERPETUAL.raw").
+ *
+ * @param channel The channel name.
+ * @return std::string The instrument, or an empty string if there is none.
+ */
+std::string subscriptionManager::instrumentOf(const std::string& channel) {
+    size_t first = channel.find('.');
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    size_t second = channel.find('.', first + 1);
+    return channel.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+}
+
+/**
+ * @brief Gets the 100ms variant of a raw book or ticker channel.
+ *
+ * @param channel The channel name.
+ * @return std::string The slower channel, or an empty string if the channel has none.
+ */
+std::string subscriptionManager::slowVariant(const std::string& channel) {
+    static const std::string raw = ".raw";
+    bool eligible = channel.rfind("book.", 0) == 0 || channel.rfind("ticker.", 0) == 0;
+    if (!eligible || channel.size() <= raw.size() || channel.compare(channel.size() - raw.size(), raw.size(), raw) != 0) {
+        return std::string();
+    }
+    return channel.substr(0, channel.size() - raw.size()) + ".100ms";
+}
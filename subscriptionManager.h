@@ -0,0 +1,263 @@
+/**
+ * @file subscriptionManager.h
+ * @brief Header file for the subscription manager.
+ *
+ * This file defines the `subscriptionManager` class, which keeps the desired set of
+ * channels, diffs it against what the exchange has acknowledged, and packs the
+ * difference into as few subscribe/unsubscribe requests as possible. Under load it
+ * moves raw book and ticker channels of unpinned instruments to their 100ms variants.
+ */
+
+#ifndef SUBSCRIPTIONMANAGER_H
+#define SUBSCRIPTIONMANAGER_H
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Exchange-side state of a channel.
+ */
+enum class channelState : uint8_t {
+    unsubscribed,   ///< Not subscribed and no request in flight.
+    subscribing,    ///< Subscribe request sent, not acknowledged yet.
+    subscribed,     ///< Acknowledged by the exchange.
+    unsubscribing   ///< Unsubscribe request sent, not acknowledged yet.
+};
+
+/**
+ * @brief Returns a printable name for a channel state.
+ *
+ * @param state The channel state.
+ * @return const char* The state name.
+ */
+const char* toString(channelState state);
+
+/**
+ * @brief One subscribe or unsubscribe request covering several channels.
+ */
+struct subscriptionBatch {
+    bool subscribe = true;              ///< True for subscribe, false for unsubscribe.
+    bool isPrivate = false;             ///< Whether the channels need the private method.
+    int requestId = 0;                  ///< JSON-RPC request ID of the batch.
+    std::vector<std::string> channels;  ///< Channels in the request.
+};
+
+/**
+ * @brief A channel with its desired and actual state.
+ */
+struct channelStatus {
+    std::string channel;                            ///< Channel name.
+    bool desired = false;                           ///< Whether the channel is wanted.
+    channelState state = channelState::unsubscribed; ///< Exchange-side state.
+};
+
+/**
+ * @brief Parties that want channels; a channel stays subscribed while any of them wants it.
+ */
+enum class subscriptionOwner : uint8_t {
+    console = 0, ///< The console user and the client's own private feeds.
+    gateway = 1  ///< Downstream clients of the local gateway.
+};
+
+/**
+ * @brief A channel moved to a different interval by the load governor.
+ */
+struct intervalChange {
+    std::string from; ///< Channel that was replaced.
+    std::string to;   ///< Channel that replaced it.
+};
+
+/**
+ * @class subscriptionManager
+ * @brief Reconciles desired subscriptions with acknowledged ones.
+ *
+ * Callers only change the desired set; `plan` returns the requests needed to reach it,
+ * skipping channels with a request already in flight. Acknowledgements are applied per
+ * channel, so a partially accepted batch leaves the rejected channels to be retried by
+ * the next plan.
+ *
+ * The manager also governs channel intervals. The client reports the decode cost of every
+ * channel message and, once per window, the event loop's utilization. When the loop
+ * saturates, the costliest raw `book.*`/`ticker.*` channels of unpinned instruments are
+ * replaced by their 100ms variants; after the loop has stayed quiet for a few windows
+ * they are moved back, one per window, most recent first. All methods are thread-safe.
+ */
+class subscriptionManager {
+public:
+    static constexpr int kRequestBase = 6000000; ///< Request IDs of batches: base + sequence.
+    static constexpr int kRequestRange = 1000000; ///< Size of the batch request ID range.
+    static constexpr double kDowngradeAbove = 0.75; ///< Utilization above which channels are downgraded.
+    static constexpr double kUpgradeBelow = 0.35; ///< Utilization below which the loop counts as recovered.
+    static constexpr int kRecoveryWindows = 5; ///< Quiet windows required before each upgrade.
+
+    /**
+     * @brief Constructs a subscription manager.
+     *
+     * @param maxChannelsPerRequest The maximum number of channels packed into one request.
+     */
+    explicit subscriptionManager(size_t maxChannelsPerRequest = 200);
+
+    /**
+     * @brief Adds channels to the desired set on behalf of an owner.
+     *
+     * @param channels The channels to subscribe to.
+     * @param owner [optional] The party that wants them.
+     */
+    void add(const std::vector<std::string>& channels, subscriptionOwner owner = subscriptionOwner::console);
+
+    /**
+     * @brief Releases an owner's interest in channels.
+     *
+     * A channel leaves the desired set only once no owner wants it any more.
+     *
+     * @param channels The channels to unsubscribe from.
+     * @param owner [optional] The party releasing them.
+     */
+    void remove(const std::vector<std::string>& channels, subscriptionOwner owner = subscriptionOwner::console);
+
+    /**
+     * @brief Checks whether an owner wants a channel.
+     *
+     * @param channel The channel name.
+     * @param owner The owner.
+     * @return True if the owner added the channel and has not removed it.
+     */
+    bool isWantedBy(const std::string& channel, subscriptionOwner owner) const;
+
+    /**
+     * @brief Checks whether a channel is in the desired set.
+     *
+     * @param channel The channel name.
+     * @return True if the channel is wanted.
+     */
+    bool isDesired(const std::string& channel) const;
+
+    /**
+     * @brief Computes the requests that move the exchange towards the desired set.
+     *
+     * Channels in the returned batches are marked as in flight.
+     *
+     * @param out Receives the batches to send.
+     */
+    void plan(std::vector<subscriptionBatch>& out);
+
+    /**
+     * @brief Checks whether a request ID belongs to a subscription batch.
+     *
+     * @param requestId The JSON-RPC request ID.
+     * @return True if the ID is in the batch range.
+     */
+    static bool isBatchRequest(int requestId);
+
+    /**
+     * @brief Applies the response to a batch.
+     *
+     * Channels listed in the result are acknowledged; the rest of the batch (or the whole
+     * batch on an error) goes back to its previous state.
+     *
+     * @param requestId The JSON-RPC request ID of the response.
+     * @param response The full JSON response.
+     * @param rejected Receives the channels the exchange did not acknowledge.
+     * @return size_t The number of channels acknowledged.
+     */
+    size_t onResponse(int requestId, const nlohmann::json& response, std::vector<std::string>& rejected);
+
+    /**
+     * @brief Forgets every exchange-side state, e.g., after the connection dropped.
+     *
+     * The desired set is kept, so the next plan subscribes everything again.
+     */
+    void reset();
+
+    /**
+     * @brief Lists every known channel with its desired and actual state.
+     *
+     * @return std::vector<channelStatus> The channels, sorted by name.
+     */
+    std::vector<channelStatus> list() const;
+
+    /**
+     * @brief Keeps an instrument's channels on raw regardless of load.
+     *
+     * Pinning an instrument whose channels are downgraded restores them on the next plan.
+     *
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param pinned True to pin, false to release.
+     */
+    void setPinned(const std::string& instrument, bool pinned);
+
+    /**
+     * @brief Checks whether an instrument is pinned to raw.
+     *
+     * @param instrument The instrument name.
+     * @return True if the instrument is pinned.
+     */
+    bool isPinned(const std::string& instrument) const;
+
+    /**
+     * @brief Adds the decode cost of one channel message to the current window.
+     *
+     * @param channel The channel the message arrived on.
+     * @param ns Time spent decoding and handling the message, in nanoseconds.
+     */
+    void recordCost(const std::string& channel, int64_t ns);
+
+    /**
+     * @brief Closes a load window and downgrades or upgrades channels.
+     *
+     * Changes only touch the desired set; the caller sends them with the next plan.
+     *
+     * @param utilization Fraction of the window the event loop spent handling messages.
+     * @param changes Receives the channels moved to a different interval.
+     */
+    void adapt(double utilization, std::vector<intervalChange>& changes);
+
+    /**
+     * @brief Lists the raw channels currently replaced by a slower variant.
+     *
+     * @return std::vector<intervalChange> The downgrades, oldest first.
+     */
+    std::vector<intervalChange> downgrades() const;
+
+private:
+    /**
+     * @brief Tracking state of one channel.
+     */
+    struct entry {
+        bool desired = false;
+        channelState state = channelState::unsubscribed;
+    };
+
+    /**
+     * @brief A raw channel replaced by its 100ms variant.
+     */
+    struct downgrade {
+        std::string raw;        ///< The channel the caller asked for.
+        std::string slow;       ///< The channel subscribed instead.
+        bool addedSlow = false; ///< Whether the slow channel was not wanted on its own.
+    };
+
+    void addToBatch(std::vector<subscriptionBatch>& out, size_t (&open)[2][2], bool subscribe, const std::string& channel);
+    void restore(size_t index, std::vector<intervalChange>* changes);
+    static std::string instrumentOf(const std::string& channel);
+    static std::string slowVariant(const std::string& channel);
+
+    const size_t m_maxChannelsPerRequest; ///< Channels per request.
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    std::map<std::string, entry> m_channels; ///< Every known channel, by name.
+    std::unordered_map<std::string, uint8_t> m_owners; ///< Owner bits of every requested channel.
+    std::unordered_map<int, subscriptionBatch> m_inFlight; ///< Sent batches by request ID.
+    int m_nextSequence; ///< Sequence of the next batch request ID.
+    std::set<std::string> m_pinned; ///< Instruments kept on raw.
+    std::unordered_map<std::string, int64_t> m_costs; ///< Decode cost per channel in the current window.
+    std::vector<downgrade> m_downgrades; ///< Active downgrades, oldest first.
+    int m_quietWindows; ///< Consecutive windows below kUpgradeBelow.
+};
+
+#endif // SUBSCRIPTIONMANAGER_H
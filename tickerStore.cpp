@@ -0,0 +1,496 @@
+/**
+ * @file tickerStore.cpp
+ * @brief Implementation of the columnar ticker store.
+ */
+
+#include "tickerStore.h"
+#include "tscClock.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+    /**
+     * @brief Fields of a book summary entry that the store keeps.
+     */
+    enum class summaryField : uint8_t {
+        none, instrument, bidPrice, askPrice, markPrice, lastPrice, volume, openInterest,
+        underlyingPrice, deliveryPrice, timestamp
+    };
+
+    /**
+     * @brief Maps a book summary key to its field.
+     *
+     * @param key The key.
+     * @return summaryField The field, or `none` for keys the store does not keep.
+     */
+    summaryField fieldOf(const std::string& key) {
+        switch (key.size()) {
+            case 4:
+                return key == "last" ? summaryField::lastPrice : summaryField::none;
+            case 6:
+                return key == "volume" ? summaryField::volume : summaryField::none;
+            case 9:
+                return key == "bid_price" ? summaryField::bidPrice : key == "ask_price" ? summaryField::askPrice : summaryField::none;
+            case 10:
+                return key == "mark_price" ? summaryField::markPrice : summaryField::none;
+            case 13:
+                return key == "open_interest" ? summaryField::openInterest : summaryField::none;
+            case 15:
+                return key == "instrument_name" ? summaryField::instrument : summaryField::none;
+            case 16:
+                return key == "underlying_price" ? summaryField::underlyingPrice : summaryField::none;
+            case 18:
+                return key == "creation_timestamp" ? summaryField::timestamp : summaryField::none;
+            case 24:
+                return key == "estimated_delivery_price" ? summaryField::deliveryPrice : summaryField::none;
+            default:
+                return summaryField::none;
+        }
+    }
+
+    /**
+     * @brief Reads a numeric field, or NaN if it is missing or not a number.
+     *
+     * @param object The JSON object.
+     * @param key The field name.
+     * @return double The value.
+     */
+    double number(const nlohmann::json& object, const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_number() ? it->get<double>() : kNaN;
+    }
+}
+
+/**
+ * @class tickerStore::bookSummaryHandler
+ * @brief SAX handler that writes book summary entries into the store's columns.
+ *
+ * Only scalar values of the entries of the top-level "result" array are looked at; each
+ * entry is staged in a few locals and written as one row when its object closes.
+ */
+class tickerStore::bookSummaryHandler {
+public:
+    using json = nlohmann::json;
+
+    explicit bookSummaryHandler(tickerStore& store)
+        : m_store(store), m_depth(0), m_inResult(false), m_field(summaryField::none), m_rows(0) {
+        reset();
+    }
+
+    // nlohmann::json SAX interface; returning false would stop the parse
+
+    bool null() {
+        return value(kNaN);
+    }
+
+    bool boolean(bool) {
+        return true;
+    }
+
+    bool number_integer(json::number_integer_t number) {
+        return value(static_cast<double>(number));
+    }
+
+    bool number_unsigned(json::number_unsigned_t number) {
+        return value(static_cast<double>(number));
+    }
+
+    bool number_float(json::number_float_t number, const json::string_t&) {
+        return value(number);
+    }
+
+    bool string(json::string_t& text) {
+        if (m_depth == 3 && m_inResult && m_field == summaryField::instrument) {
+            m_instrument = std::move(text);
+        } else if (m_depth == 2 && m_topKey == "error" && m_key == "message") {
+            m_error = std::move(text);
+        }
+        return true;
+    }
+
+    bool binary(json::binary_t&) {
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        ++m_depth;
+        if (m_depth == 3 && m_inResult) {
+            reset();
+        }
+        if (m_depth == 2 && m_topKey == "error") {
+            m_error = "Unknown error";
+        }
+        return true;
+    }
+
+    bool end_object() {
+        if (m_depth == 3 && m_inResult && !m_instrument.empty()) {
+            commit();
+        }
+        --m_depth;
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        ++m_depth;
+        if (m_depth == 2 && m_topKey == "result") {
+            m_inResult = true;
+            m_sawResult = true;
+        }
+        return true;
+    }
+
+    bool end_array() {
+        if (m_depth == 2) {
+            m_inResult = false;
+        }
+        --m_depth;
+        return true;
+    }
+
+    bool key(json::string_t& name) {
+        if (m_depth == 1) {
+            m_topKey = std::move(name);
+        } else if (m_depth == 3 && m_inResult) {
+            m_field = fieldOf(name);
+        } else if (m_depth == 2) {
+            m_key = std::move(name);
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& e) {
+        m_error = "Parse error at byte " + std::to_string(position) + ": " + e.what();
+        return false;
+    }
+
+    /**
+     * @brief Gets the number of rows written.
+     *
+     * @return size_t The count.
+     */
+    size_t rows() const {
+        return m_rows;
+    }
+
+    /**
+     * @brief Whether the response carried a result array.
+     *
+     * @return True if a result array was seen.
+     */
+    bool sawResult() const {
+        return m_sawResult;
+    }
+
+    /**
+     * @brief Gets the error reported by the exchange or the parser.
+     *
+     * @return const std::string& The error, empty if none.
+     */
+    const std::string& error() const {
+        return m_error;
+    }
+
+private:
+    /**
+     * @brief Stores a scalar at the current entry field.
+     *
+     * @param number The value.
+     * @return bool Always true (continue parsing).
+     */
+    bool value(double number) {
+        if (m_depth != 3 || !m_inResult) {
+            return true;
+        }
+        switch (m_field) {
+            case summaryField::bidPrice: m_bid = number; break;
+            case summaryField::askPrice: m_ask = number; break;
+            case summaryField::markPrice: m_mark = number; break;
+            case summaryField::lastPrice: m_last = number; break;
+            case summaryField::volume: m_volume = number; break;
+            case summaryField::openInterest: m_openInterest = number; break;
+            case summaryField::underlyingPrice: m_underlying = number; break;
+            case summaryField::deliveryPrice: m_delivery = number; break;
+            case summaryField::timestamp: m_timestampMs = static_cast<int64_t>(number); break;
+            case summaryField::instrument:
+            case summaryField::none:
+                break;
+        }
+        m_field = summaryField::none;
+        return true;
+    }
+
+    /**
+     * @brief Clears the staged entry.
+     */
+    void reset() {
+        m_instrument.clear();
+        m_bid = m_ask = m_mark = m_last = m_volume = m_openInterest = m_underlying = m_delivery = kNaN;
+        m_timestampMs = 0;
+        m_field = summaryField::none;
+    }
+
+    /**
+     * @brief Writes the staged entry into its row.
+     */
+    void commit() {
+        size_t row = m_store.rowOf(m_instrument);
+        m_store.m_bidPrices[row] = m_bid;
+        m_store.m_askPrices[row] = m_ask;
+        m_store.m_markPrices[row] = m_mark;
+        m_store.m_lastPrices[row] = m_last;
+        m_store.m_volumes[row] = m_volume;
+        m_store.m_openInterests[row] = m_openInterest;
+        m_store.m_underlyingPrices[row] = std::isnan(m_underlying) ? m_delivery : m_underlying; // Futures only have a delivery estimate
+        m_store.m_timestampsMs[row] = m_timestampMs;
+        ++m_rows;
+    }
+
+    tickerStore& m_store; ///< Store being written; its mutex is held.
+    int m_depth; ///< Nesting depth: 1 is the response, 3 an entry of "result".
+    std::string m_topKey; ///< Last key of the response object.
+    std::string m_key; ///< Last key at depth 2 (inside "error").
+    bool m_inResult; ///< Whether the parse is inside the "result" array.
+    bool m_sawResult = false; ///< Whether a "result" array was seen.
+    summaryField m_field; ///< Field the next entry value belongs to.
+    size_t m_rows; ///< Rows written.
+    std::string m_error; ///< Exchange or parse error.
+    std::string m_instrument; ///< Staged entry: instrument name.
+    double m_bid, m_ask, m_mark, m_last, m_volume, m_openInterest, m_underlying, m_delivery; ///< Staged entry values.
+    int64_t m_timestampMs; ///< Staged entry: creation timestamp.
+};
+
+/**
+ * @brief Constructs an empty store.
+ */
+tickerStore::tickerStore() {}
+
+/**
+ * @brief Decodes a get_book_summary_by_currency response into the store.
+ *
+ * The response is parsed once, as a stream, with rows written as their entries close;
+ * no JSON document is built. New instruments are then added to the perfect-hash index.
+ *
+ * @param payload The raw response text.
+ * @return bookSummaryResult What was written.
+ */
+bookSummaryResult tickerStore::ingestBookSummary(const std::string& payload) {
+    bookSummaryResult result;
+    int64_t startNs = tscClock::instance().monotonicNs();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bookSummaryHandler handler(*this);
+    bool parsed = nlohmann::json::sax_parse(payload, &handler);
+    result.rows = handler.rows();
+    result.ok = parsed && handler.sawResult() && handler.error().empty();
+    result.error = handler.error();
+    if (!result.ok && result.error.empty()) {
+        result.error = "Response has no result";
+    }
+    if (m_indexRows.size() != m_rowsByKey.size()) {
+        reindex();
+    }
+    result.parseNs = tscClock::instance().monotonicNs() - startNs;
+    return result;
+}
+
+/**
+ * @brief Updates an instrument's row from a ticker channel notification.
+ *
+ * Only fields present in the notification are overwritten.
+ *
+ * @param data The notification's "data" object.
+ */
+void tickerStore::onTicker(const nlohmann::json& data) {
+    auto name = data.find("instrument_name");
+    if (name == data.end() || !name->is_string()) {
+        return;
+    }
+    auto update = [](std::vector<double>& column, size_t row, double value) {
+        if (!std::isnan(value)) {
+            column[row] = value;
+        }
+    };
+    double volume = kNaN;
+    auto stats = data.find("stats");
+    if (stats != data.end() && stats->is_object()) {
+        volume = number(*stats, "volume");
+    }
+    double underlying = number(data, "underlying_price");
+    if (std::isnan(underlying)) {
+        underlying = number(data, "estimated_delivery_price");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t row = rowOf(name->get_ref<const std::string&>());
+    update(m_bidPrices, row, number(data, "best_bid_price"));
+    update(m_askPrices, row, number(data, "best_ask_price"));
+    update(m_markPrices, row, number(data, "mark_price"));
+    update(m_lastPrices, row, number(data, "last_price"));
+    update(m_volumes, row, volume);
+    update(m_openInterests, row, number(data, "open_interest"));
+    update(m_underlyingPrices, row, underlying);
+    auto timestamp = data.find("timestamp");
+    if (timestamp != data.end() && timestamp->is_number_integer()) {
+        m_timestampsMs[row] = timestamp->get<int64_t>();
+    }
+}
+
+/**
+ * @brief Gets the number of instruments in the store.
+ *
+ * @return size_t The count.
+ */
+size_t tickerStore::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_instruments.size();
+}
+
+/**
+ * @brief Gets the instruments with the highest volume.
+ *
+ * Scans only the volume column (and the name column when filtering).
+ *
+ * @param count The maximum number of rows.
+ * @param prefix Only instruments whose name starts with this (e.g., "BTC-"); empty for all.
+ * @return std::vector<tickerRow> The rows, by descending volume.
+ */
+std::vector<tickerRow> tickerStore::topByVolume(size_t count, const std::string& prefix) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<uint32_t> rows;
+    rows.reserve(m_volumes.size());
+    for (uint32_t row = 0; row < m_volumes.size(); ++row) {
+        if (!std::isnan(m_volumes[row]) && (prefix.empty() || m_instruments[row].compare(0, prefix.size(), prefix) == 0)) {
+            rows.push_back(row);
+        }
+    }
+    count = std::min(count, rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + count, rows.end(),
+                      [this](uint32_t a, uint32_t b) { return m_volumes[a] > m_volumes[b]; });
+    std::vector<tickerRow> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(copyRow(rows[i]));
+    }
+    return result;
+}
+
+/**
+ * @brief Gets one instrument's snapshot.
+ *
+ * @param instrument The instrument name.
+ * @param row Receives the snapshot.
+ * @return True if the instrument is in the store.
+ */
+bool tickerStore::find(const std::string& instrument, tickerRow& row) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t index;
+    if (!lookup(instrument, index)) {
+        return false;
+    }
+    row = copyRow(index);
+    return true;
+}
+
+/**
+ * @brief Finds or adds the row of an instrument. The caller holds m_mutex.
+ *
+ * @param instrument The instrument name.
+ * @return size_t The row.
+ */
+size_t tickerStore::rowOf(const std::string& instrument) {
+    size_t row;
+    if (lookup(instrument, row)) {
+        return row;
+    }
+    row = m_instruments.size();
+    uint64_t key;
+    if (instrumentKey::parse(instrument, key)) {
+        m_rowsByKey.emplace(key, static_cast<uint32_t>(row));
+    } else {
+        m_rowsByName.emplace(instrument, static_cast<uint32_t>(row));
+    }
+    m_instruments.push_back(instrument);
+    m_bidPrices.push_back(kNaN);
+    m_askPrices.push_back(kNaN);
+    m_markPrices.push_back(kNaN);
+    m_lastPrices.push_back(kNaN);
+    m_volumes.push_back(kNaN);
+    m_openInterests.push_back(kNaN);
+    m_underlyingPrices.push_back(kNaN);
+    m_timestampsMs.push_back(0);
+    return row;
+}
+
+/**
+ * @brief Looks up the row of an instrument. The caller holds m_mutex.
+ *
+ * @param instrument The instrument name.
+ * @param row Receives the row.
+ * @return True if the instrument is in the store.
+ */
+bool tickerStore::lookup(const std::string& instrument, size_t& row) const {
+    uint64_t key;
+    if (instrumentKey::parse(instrument, key)) {
+        uint32_t id;
+        if (m_index.find(key, id)) {
+            row = m_indexRows[id];
+            return true;
+        }
+        auto it = m_rowsByKey.find(key);
+        if (it == m_rowsByKey.end()) {
+            return false;
+        }
+        row = it->second;
+        return true;
+    }
+    auto it = m_rowsByName.find(instrument);
+    if (it == m_rowsByName.end()) {
+        return false;
+    }
+    row = it->second;
+    return true;
+}
+
+/**
+ * @brief Rebuilds the perfect-hash index over all keyed rows. The caller holds m_mutex.
+ *
+ * Book summaries add instruments in bulk and are rare, so the index is rebuilt after
+ * them; lookups of the instruments they brought in then skip the hash map.
+ */
+void tickerStore::reindex() {
+    std::vector<uint64_t> keys;
+    keys.reserve(m_rowsByKey.size());
+    m_indexRows.clear();
+    m_indexRows.reserve(m_rowsByKey.size());
+    for (const auto& entry : m_rowsByKey) {
+        keys.push_back(entry.first);
+        m_indexRows.push_back(entry.second);
+    }
+    if (!m_index.build(keys)) {
+        m_indexRows.clear(); // Keys are unique and non-zero, so this does not happen; lookups fall back to the map
+    }
+}
+
+/**
+ * @brief Copies a row out. The caller holds m_mutex.
+ *
+ * @param row The row.
+ * @return tickerRow The snapshot.
+ */
+tickerRow tickerStore::copyRow(size_t row) const {
+    tickerRow copy;
+    copy.instrument = m_instruments[row];
+    copy.bidPrice = m_bidPrices[row];
+    copy.askPrice = m_askPrices[row];
+    copy.markPrice = m_markPrices[row];
+    copy.lastPrice = m_lastPrices[row];
+    copy.volume = m_volumes[row];
+    copy.openInterest = m_openInterests[row];
+    copy.underlyingPrice = m_underlyingPrices[row];
+    copy.timestampMs = m_timestampsMs[row];
+    return copy;
+}
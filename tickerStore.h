@@ -0,0 +1,157 @@
+/**
+ * @file tickerStore.h
+ * @brief Header file for the columnar ticker store.
+ *
+ * This file defines the `tickerStore` class, which keeps the latest market snapshot of
+ * every instrument seen in one column per field, fed by whole-currency book summaries
+ * and by ticker channel updates.
+ */
+
+#ifndef TICKERSTORE_H
+#define TICKERSTORE_H
+
+#include "instrumentKey.h"
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief One instrument's snapshot, copied out of the store.
+ */
+struct tickerRow {
+    std::string instrument;  ///< Instrument name.
+    double bidPrice;         ///< Best bid price, NaN if none.
+    double askPrice;         ///< Best ask price, NaN if none.
+    double markPrice;        ///< Mark price.
+    double lastPrice;        ///< Last traded price, NaN if none.
+    double volume;           ///< 24h volume in contracts or base currency.
+    double openInterest;     ///< Open interest.
+    double underlyingPrice;  ///< Underlying (or index) price.
+    int64_t timestampMs;     ///< Exchange time of the snapshot in milliseconds.
+};
+
+/**
+ * @brief Result of ingesting a book summary response.
+ */
+struct bookSummaryResult {
+    bool ok = false;       ///< Whether the response was a valid result array.
+    size_t rows = 0;       ///< Instruments written.
+    int64_t parseNs = 0;   ///< Time spent parsing and storing.
+    std::string error;     ///< Exchange or parse error if not ok.
+};
+
+/**
+ * @class tickerStore
+ * @brief Columnar store of the latest snapshot per instrument.
+ *
+ * Each field lives in its own vector indexed by row, so a scan over one field (e.g., the
+ * largest volumes of a currency) touches only that column. Rows are found by packed
+ * instrument key (instrumentKey.h), falling back to the name for names that do not
+ * parse, and are never removed. After each book summary the keyed rows are indexed by a
+ * perfect hash (instrumentIndex); rows added since then are found through a hash map.
+ *
+ * `ingestBookSummary` decodes a `public/get_book_summary_by_currency` response with a
+ * streaming (SAX) parse straight into the columns, without building a JSON document.
+ * Writers and readers are serialized by a mutex: the client's event loop writes, the
+ * console reads.
+ */
+class tickerStore {
+public:
+    /**
+     * @brief Constructs an empty store.
+     */
+    tickerStore();
+
+    /**
+     * @brief Decodes a get_book_summary_by_currency response into the store.
+     *
+     * @param payload The raw response text.
+     * @return bookSummaryResult What was written.
+     */
+    bookSummaryResult ingestBookSummary(const std::string& payload);
+
+    /**
+     * @brief Updates an instrument's row from a ticker channel notification.
+     *
+     * @param data The notification's "data" object.
+     */
+    void onTicker(const nlohmann::json& data);
+
+    /**
+     * @brief Gets the number of instruments in the store.
+     *
+     * @return size_t The count.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the instruments with the highest volume.
+     *
+     * @param count The maximum number of rows.
+     * @param prefix Only instruments whose name starts with this (e.g., "BTC-"); empty for all.
+     * @return std::vector<tickerRow> The rows, by descending volume.
+     */
+    std::vector<tickerRow> topByVolume(size_t count, const std::string& prefix = std::string()) const;
+
+    /**
+     * @brief Gets one instrument's snapshot.
+     *
+     * @param instrument The instrument name.
+     * @param row Receives the snapshot.
+     * @return True if the instrument is in the store.
+     */
+    bool find(const std::string& instrument, tickerRow& row) const;
+
+private:
+    class bookSummaryHandler;
+
+    /**
+     * @brief Finds or adds the row of an instrument. The caller holds m_mutex.
+     *
+     * @param instrument The instrument name.
+     * @return size_t The row.
+     */
+    size_t rowOf(const std::string& instrument);
+
+    /**
+     * @brief Looks up the row of an instrument. The caller holds m_mutex.
+     *
+     * @param instrument The instrument name.
+     * @param row Receives the row.
+     * @return True if the instrument is in the store.
+     */
+    bool lookup(const std::string& instrument, size_t& row) const;
+
+    /**
+     * @brief Rebuilds the perfect-hash index over all keyed rows. The caller holds m_mutex.
+     */
+    void reindex();
+
+    /**
+     * @brief Copies a row out. The caller holds m_mutex.
+     *
+     * @param row The row.
+     * @return tickerRow The snapshot.
+     */
+    tickerRow copyRow(size_t row) const;
+
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    std::unordered_map<uint64_t, uint32_t> m_rowsByKey; ///< Rows by packed instrument key.
+    instrumentIndex m_index; ///< Perfect hash over the keyed rows as of the last reindex.
+    std::vector<uint32_t> m_indexRows; ///< Row of each index ID.
+    std::unordered_map<std::string, uint32_t> m_rowsByName; ///< Rows of names without a packed key.
+    std::vector<std::string> m_instruments; ///< Column: instrument name.
+    std::vector<double> m_bidPrices; ///< Column: best bid price.
+    std::vector<double> m_askPrices; ///< Column: best ask price.
+    std::vector<double> m_markPrices; ///< Column: mark price.
+    std::vector<double> m_lastPrices; ///< Column: last traded price.
+    std::vector<double> m_volumes; ///< Column: 24h volume.
+    std::vector<double> m_openInterests; ///< Column: open interest.
+    std::vector<double> m_underlyingPrices; ///< Column: underlying price.
+    std::vector<int64_t> m_timestampsMs; ///< Column: exchange time in milliseconds.
+};
+
+#endif // TICKERSTORE_H
@@ -0,0 +1,233 @@
+/**
+ * @file timerWheel.cpp
+ * @brief Implementation of the hierarchical timer wheel.
+ */
+
+#include "timerWheel.h"
+
+/**
+ * @brief Constructs a timer wheel.
+ *
+ * @param capacity The maximum number of timers pending at once.
+ * @param tickMs The resolution of the wheel in milliseconds.
+ */
+timerWheel::timerWheel(size_t capacity, long tickMs)
+    : m_tickMs(tickMs > 0 ? tickMs : 1),
+      m_start(clock::now()),
+      m_nodes(capacity),
+      m_buckets(kLevels * kSlots, kNil),
+      m_freeHead(capacity > 0 ? 0 : kNil),
+      m_size(0),
+      m_now(0) {
+    for (size_t i = 0; i < capacity; ++i) {
+        m_nodes[i].next = i + 1 < capacity ? static_cast<uint32_t>(i + 1) : kNil;
+    }
+    m_expired.reserve(capacity);
+    m_firing.reserve(capacity);
+}
+
+/**
+ * @brief Sets the handler invoked for every expired timer.
+ *
+ * @param callback The handler.
+ */
+void timerWheel::setHandler(handler callback) {
+    m_handler = std::move(callback);
+}
+
+/**
+ * @brief Gets the tick the wall clock is in.
+ *
+ * @return uint64_t The current tick.
+ */
+uint64_t timerWheel::currentTick() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - m_start).count();
+    return static_cast<uint64_t>(elapsed / m_tickMs);
+}
+
+/**
+ * @brief Links a node into the slot matching its expiry.
+ *
+ * Timers due within 64 ticks go to level 0, within 64^2 ticks to level 1, and so on.
+ *
+ * @param index The node index.
+ */
+void timerWheel::insert(uint32_t index) {
+    node& n = m_nodes[index];
+    if (n.expiry <= m_now) {
+        n.expiry = m_now + 1;
+    }
+    uint64_t delta = n.expiry - m_now;
+    int level = 0;
+    while (level < kLevels - 1 && delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    uint64_t expiry = n.expiry;
+    if (delta >= (uint64_t(1) << (kSlotBits * kLevels))) {
+        // Beyond the wheel's range: park in the furthest slot and cascade again later
+        expiry = m_now + (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+    }
+    uint32_t bucket = level * kSlots + static_cast<uint32_t>((expiry >> (kSlotBits * level)) & (kSlots - 1));
+    n.bucket = bucket;
+    n.prev = kNil;
+    n.next = m_buckets[bucket];
+    if (n.next != kNil) {
+        m_nodes[n.next].prev = index;
+    }
+    m_buckets[bucket] = index;
+}
+
+/**
+ * @brief Unlinks a node from its slot.
+ *
+ * @param index The node index.
+ */
+void timerWheel::unlink(uint32_t index) {
+    node& n = m_nodes[index];
+    if (n.prev != kNil) {
+        m_nodes[n.prev].next = n.next;
+    } else {
+        m_buckets[n.bucket] = n.next;
+    }
+    if (n.next != kNil) {
+        m_nodes[n.next].prev = n.prev;
+    }
+    n.bucket = kNil;
+}
+
+/**
+ * @brief Returns an unlinked node to the free list.
+ *
+ * @param index The node index.
+ */
+void timerWheel::release(uint32_t index) {
+    node& n = m_nodes[index];
+    ++n.generation;
+    if (n.generation == 0) {
+        n.generation = 1;
+    }
+    n.prev = kNil;
+    n.next = m_freeHead;
+    m_freeHead = index;
+    --m_size;
+}
+
+/**
+ * @brief Moves every timer of the current slot of a level down to finer levels.
+ *
+ * @param level The level to cascade (1 or higher).
+ */
+void timerWheel::cascade(int level) {
+    uint32_t bucket = level * kSlots + static_cast<uint32_t>((m_now >> (kSlotBits * level)) & (kSlots - 1));
+    uint32_t index = m_buckets[bucket];
+    m_buckets[bucket] = kNil;
+    while (index != kNil) {
+        uint32_t next = m_nodes[index].next;
+        insert(index);
+        index = next;
+    }
+}
+
+/**
+ * @brief Schedules a timer.
+ *
+ * @param delayMs The delay in milliseconds; rounded up to the next tick.
+ * @param kind A caller-defined timer kind passed to the handler.
+ * @param arg A caller-defined argument passed to the handler.
+ * @return timerId The timer handle, or kNoTimer if every node is in use.
+ */
+timerWheel::timerId timerWheel::schedule(long delayMs, uint32_t kind, uint64_t arg) {
+    uint64_t ticks = delayMs > 0 ? static_cast<uint64_t>((delayMs + m_tickMs - 1) / m_tickMs) : 0;
+    uint64_t now = currentTick();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_freeHead == kNil) {
+        return kNoTimer;
+    }
+    uint32_t index = m_freeHead;
+    node& n = m_nodes[index];
+    m_freeHead = n.next;
+    ++m_size;
+    // Count from the wall clock, not from the last advance, so a late advance never fires early
+    n.expiry = (now > m_now ? now : m_now) + ticks;
+    n.kind = kind;
+    n.arg = arg;
+    insert(index);
+    return (static_cast<uint64_t>(n.generation) << 32) | index;
+}
+
+/**
+ * @brief Cancels a pending timer.
+ *
+ * @param id The timer handle.
+ * @return True if the timer was pending.
+ */
+bool timerWheel::cancel(timerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id == kNoTimer || index >= m_nodes.size()) {
+        return false;
+    }
+    node& n = m_nodes[index];
+    if (n.generation != generation || n.bucket == kNil) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+/**
+ * @brief Advances the wheel to the current time and fires every expired timer.
+ *
+ * @return size_t The number of timers fired.
+ */
+size_t timerWheel::advance() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t target = currentTick();
+        while (m_now < target) {
+            ++m_now;
+            // Refill finer levels before their slots come due
+            for (int level = 1; level < kLevels; ++level) {
+                if ((m_now & ((uint64_t(1) << (kSlotBits * level)) - 1)) != 0) {
+                    break;
+                }
+                cascade(level);
+            }
+            uint32_t bucket = static_cast<uint32_t>(m_now & (kSlots - 1));
+            uint32_t index = m_buckets[bucket];
+            m_buckets[bucket] = kNil;
+            while (index != kNil) {
+                node& n = m_nodes[index];
+                uint32_t next = n.next;
+                m_expired.push_back(expired{n.kind, n.arg});
+                n.bucket = kNil;
+                release(index);
+                index = next;
+            }
+        }
+        if (m_expired.empty()) {
+            return 0;
+        }
+        m_firing.swap(m_expired);
+    }
+    size_t fired = m_firing.size();
+    if (m_handler) {
+        for (const expired& e : m_firing) {
+            m_handler(e.kind, e.arg);
+        }
+    }
+    m_firing.clear();
+    return fired;
+}
+
+/**
+ * @brief Gets the number of pending timers.
+ *
+ * @return size_t The number of pending timers.
+ */
+size_t timerWheel::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file timerWheel.h
+ * @brief Header file for the hierarchical timer wheel.
+ *
+ * This file defines the `timerWheel` class, which keeps every client-side deadline
+ * (request timeouts, heartbeats, order expiries, periodic jobs) in one structure
+ * advanced from the I/O loop.
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class timerWheel
+ * @brief Hierarchical timer wheel with O(1) schedule and cancel.
+ *
+ * Four levels of 64 slots each cover 64^4 ticks; timers further out are parked in the
+ * last level and cascaded again. Timer nodes come from a pool preallocated at
+ * construction and are chained into slots by index, so scheduling never allocates.
+ * A timer carries a kind and a 64-bit argument instead of a closure; every expiry is
+ * delivered to the single handler set with `setHandler`.
+ *
+ * `schedule` and `cancel` are thread-safe. `advance` must be called from one thread
+ * (the I/O loop); the handler runs on that thread without the wheel's lock held, so it
+ * may schedule and cancel timers.
+ */
+class timerWheel {
+public:
+    using timerId = uint64_t; ///< Handle of a scheduled timer (generation and node index).
+    using handler = std::function<void(uint32_t kind, uint64_t arg)>; ///< Expiry handler.
+
+    static constexpr timerId kNoTimer = 0; ///< Never returned by a successful schedule.
+
+    /**
+     * @brief Constructs a timer wheel.
+     *
+     * @param capacity The maximum number of timers pending at once.
+     * @param tickMs The resolution of the wheel in milliseconds.
+     */
+    explicit timerWheel(size_t capacity = 4096, long tickMs = 10);
+
+    /**
+     * @brief Sets the handler invoked for every expired timer.
+     *
+     * Must be called before the first `advance`.
+     *
+     * @param callback The handler.
+     */
+    void setHandler(handler callback);
+
+    /**
+     * @brief Schedules a timer.
+     *
+     * @param delayMs The delay in milliseconds; rounded up to the next tick.
+     * @param kind A caller-defined timer kind passed to the handler.
+     * @param arg A caller-defined argument passed to the handler.
+     * @return timerId The timer handle, or kNoTimer if every node is in use.
+     */
+    timerId schedule(long delayMs, uint32_t kind, uint64_t arg);
+
+    /**
+     * @brief Cancels a pending timer.
+     *
+     * Cancelling a timer that already fired or was cancelled is a no-op.
+     *
+     * @param id The timer handle.
+     * @return True if the timer was pending.
+     */
+    bool cancel(timerId id);
+
+    /**
+     * @brief Advances the wheel to the current time and fires every expired timer.
+     *
+     * @return size_t The number of timers fired.
+     */
+    size_t advance();
+
+    /**
+     * @brief Gets the number of pending timers.
+     *
+     * @return size_t The number of pending timers.
+     */
+    size_t size() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    /**
+     * @brief A timer node, linked into one slot's list.
+     */
+    struct node {
+        uint64_t expiry = 0;        ///< Expiry tick.
+        uint64_t arg = 0;           ///< Handler argument.
+        uint32_t kind = 0;          ///< Handler kind.
+        uint32_t generation = 1;    ///< Bumped on release so stale handles do not match.
+        uint32_t prev = kNil;       ///< Previous node in the slot.
+        uint32_t next = kNil;       ///< Next node in the slot, or next free node.
+        uint32_t bucket = kNil;     ///< Slot the node is linked into, kNil when free.
+    };
+
+    /**
+     * @brief An expired timer waiting for its handler.
+     */
+    struct expired {
+        uint32_t kind;
+        uint64_t arg;
+    };
+
+    uint64_t currentTick() const;
+    void insert(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+
+    const long m_tickMs; ///< Milliseconds per tick.
+    const clock::time_point m_start; ///< Time of tick zero.
+    mutable std::mutex m_mutex; ///< Guards all members below except m_firing and m_handler.
+    std::vector<node> m_nodes; ///< Preallocated timer nodes.
+    std::vector<uint32_t> m_buckets; ///< First node of every slot, level-major.
+    uint32_t m_freeHead; ///< First free node.
+    size_t m_size; ///< Number of pending timers.
+    uint64_t m_now; ///< Last processed tick.
+    std::vector<expired> m_expired; ///< Timers collected by the current advance.
+    std::vector<expired> m_firing; ///< Timers being delivered; owned by the advancing thread.
+    handler m_handler; ///< Expiry handler.
+};
+
+#endif // TIMERWHEEL_H
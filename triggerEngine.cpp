@@ -0,0 +1,172 @@
+/**
+ * @file triggerEngine.cpp
+ * @brief Implementation of the local trigger engine.
+ */
+
+#include "triggerEngine.h"
+
+namespace {
+
+    /**
+     * @brief Removes one (level, id) entry from a ladder.
+     *
+     * @param ladder The ladder.
+     * @param level The trigger level.
+     * @param id The trigger ID.
+     */
+    template <typename Ladder>
+    void eraseEntry(Ladder& ladder, double level, uint32_t id) {
+        auto range = ladder.equal_range(level);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                ladder.erase(it);
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Constructs an empty trigger engine.
+ */
+triggerEngine::triggerEngine()
+    : m_nextId(1) {}
+
+/**
+ * @brief Reserves the next trigger ID.
+ *
+ * @return uint32_t The reserved ID.
+ */
+uint32_t triggerEngine::nextId() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextId++;
+}
+
+/**
+ * @brief Arms a trigger.
+ *
+ * @param t The trigger; its `id` must come from `nextId`.
+ */
+void triggerEngine::add(const trigger& t) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    insert(t);
+}
+
+/**
+ * @brief Arms two triggers as one-cancels-other.
+ *
+ * Both are armed and linked under one lock, so a price update never sees one leg alone.
+ *
+ * @param first The first trigger; its `id` must come from `nextId`.
+ * @param second The second trigger; its `id` must come from `nextId`.
+ */
+void triggerEngine::addOco(trigger first, trigger second) {
+    first.ocoPeer = second.id;
+    second.ocoPeer = first.id;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    insert(first);
+    insert(second);
+}
+
+/**
+ * @brief Adds a trigger to the trigger table and its ladder.
+ *
+ * @param t The trigger.
+ */
+void triggerEngine::insert(const trigger& t) {
+    m_triggers[t.id] = t;
+    ladder& l = m_ladders[t.instrument];
+    if (t.side == triggerSide::above) {
+        l.above.emplace(t.level, t.id);
+    } else {
+        l.below.emplace(t.level, t.id);
+    }
+}
+
+/**
+ * @brief Removes a trigger from its ladder and the trigger table.
+ *
+ * @param id The trigger ID.
+ */
+void triggerEngine::erase(uint32_t id) {
+    auto it = m_triggers.find(id);
+    if (it == m_triggers.end()) {
+        return;
+    }
+    ladder& l = m_ladders[it->second.instrument];
+    if (it->second.side == triggerSide::above) {
+        eraseEntry(l.above, it->second.level, id);
+    } else {
+        eraseEntry(l.below, it->second.level, id);
+    }
+    m_triggers.erase(it);
+}
+
+/**
+ * @brief Disarms a trigger without firing it.
+ *
+ * @param id The trigger ID.
+ * @return True if the trigger was armed.
+ */
+bool triggerEngine::remove(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_triggers.find(id);
+    if (it == m_triggers.end()) {
+        return false;
+    }
+    uint32_t peer = it->second.ocoPeer;
+    erase(id);
+    auto peerIt = m_triggers.find(peer);
+    if (peerIt != m_triggers.end()) {
+        peerIt->second.ocoPeer = kNone;
+    }
+    return true;
+}
+
+/**
+ * @brief Evaluates a new price and disarms every trigger it crosses.
+ *
+ * @param instrument The instrument name.
+ * @param price The new price.
+ * @param fired Receives the fired triggers, nearest level first.
+ */
+void triggerEngine::onPrice(const std::string& instrument, double price, std::vector<trigger>& fired) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_ladders.find(instrument);
+    if (found == m_ladders.end()) {
+        return;
+    }
+    ladder& l = found->second;
+    auto fire = [this, &fired](uint32_t id) {
+        auto it = m_triggers.find(id);
+        fired.push_back(it->second);
+        uint32_t peer = it->second.ocoPeer;
+        m_triggers.erase(it);
+        erase(peer);
+    };
+    while (!l.above.empty() && price >= l.above.begin()->first) {
+        uint32_t id = l.above.begin()->second;
+        l.above.erase(l.above.begin());
+        fire(id);
+    }
+    while (!l.below.empty() && price <= l.below.begin()->first) {
+        uint32_t id = l.below.begin()->second;
+        l.below.erase(l.below.begin());
+        fire(id);
+    }
+}
+
+/**
+ * @brief Lists the armed triggers.
+ *
+ * @return std::vector<trigger> Copies of the armed triggers.
+ */
+std::vector<trigger> triggerEngine::list() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<trigger> result;
+    result.reserve(m_triggers.size());
+    for (const auto& entry : m_triggers) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
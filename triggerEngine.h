@@ -0,0 +1,128 @@
+/**
+ * @file triggerEngine.h
+ * @brief Header file for the local trigger engine.
+ *
+ * This file defines the `triggerEngine` class, which evaluates client-side conditional
+ * orders (stop, take-profit and OCO pairs) against incoming prices.
+ */
+
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Side of the market a trigger level is crossed from.
+ */
+enum class triggerSide : uint8_t {
+    above, ///< Fires when the price rises to or above the level.
+    below  ///< Fires when the price falls to or below the level.
+};
+
+/**
+ * @brief A client-side conditional order.
+ */
+struct trigger {
+    uint32_t id = 0;                ///< Trigger ID.
+    std::string instrument;         ///< Instrument whose price is watched.
+    triggerSide side = triggerSide::above; ///< Crossing direction.
+    double level = 0.0;             ///< Trigger price.
+    std::string direction;          ///< Direction of the order sent on fire.
+    double amount = 0.0;            ///< Amount of the order sent on fire.
+    double price = 0.0;             ///< Limit price of the order sent on fire (0 for market).
+    std::string orderType;          ///< Type of the order sent on fire ("market" or "limit").
+    uint32_t ocoPeer = UINT32_MAX;  ///< Trigger cancelled when this one fires, if any.
+};
+
+/**
+ * @class triggerEngine
+ * @brief Evaluates conditional orders against per-instrument price ladders.
+ *
+ * Each instrument keeps two sorted ladders: levels that fire from below and levels that
+ * fire from above. A price update only compares against the nearest level of each
+ * ladder, so ticks that fire nothing cost two comparisons. All methods are thread-safe.
+ */
+class triggerEngine {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX; ///< No trigger.
+
+    /**
+     * @brief Constructs an empty trigger engine.
+     */
+    triggerEngine();
+
+    /**
+     * @brief Reserves the next trigger ID.
+     *
+     * @return uint32_t The reserved ID.
+     */
+    uint32_t nextId();
+
+    /**
+     * @brief Arms a trigger.
+     *
+     * @param t The trigger; its `id` must come from `nextId`.
+     */
+    void add(const trigger& t);
+
+    /**
+     * @brief Arms two triggers as one-cancels-other.
+     *
+     * Both are armed and linked under one lock, so a price update never sees one leg alone.
+     *
+     * @param first The first trigger; its `id` must come from `nextId`.
+     * @param second The second trigger; its `id` must come from `nextId`.
+     */
+    void addOco(trigger first, trigger second);
+
+    /**
+     * @brief Disarms a trigger without firing it.
+     *
+     * @param id The trigger ID.
+     * @return True if the trigger was armed.
+     */
+    bool remove(uint32_t id);
+
+    /**
+     * @brief Evaluates a new price and disarms every trigger it crosses.
+     *
+     * OCO peers of fired triggers are disarmed without firing.
+     *
+     * @param instrument The instrument name.
+     * @param price The new price.
+     * @param fired Receives the fired triggers, nearest level first.
+     */
+    void onPrice(const std::string& instrument, double price, std::vector<trigger>& fired);
+
+    /**
+     * @brief Lists the armed triggers.
+     *
+     * @return std::vector<trigger> Copies of the armed triggers.
+     */
+    std::vector<trigger> list() const;
+
+private:
+    /**
+     * @brief Trigger ladders of one instrument, keyed by level.
+     */
+    struct ladder {
+        std::multimap<double, uint32_t> above;                       ///< Lowest level first.
+        std::multimap<double, uint32_t, std::greater<double>> below; ///< Highest level first.
+    };
+
+    void insert(const trigger& t);
+    void erase(uint32_t id);
+
+    mutable std::mutex m_mutex; ///< Guards all members below.
+    uint32_t m_nextId; ///< Next trigger ID.
+    std::unordered_map<uint32_t, trigger> m_triggers; ///< Armed triggers by ID.
+    std::unordered_map<std::string, ladder> m_ladders; ///< Ladders by instrument name.
+};
+
+#endif // TRIGGERENGINE_H
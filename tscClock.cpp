@@ -0,0 +1,243 @@
+/**
+ * @file tscClock.cpp
+ * @brief Implementation of the calibrated TSC clock.
+ */
+
+#include "tscClock.h"
+#include <cmath>
+#include <ctime>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TSCCLOCK_HAS_TSC 1
+#endif
+
+namespace {
+
+    /// Length of the startup calibration.
+    constexpr int64_t kStartupCalibrationNs = 10000000;
+
+    /// Difference between TSC and kernel time that marks the TSC as unstable...
+    constexpr int64_t kMaxDriftNs = 1000000;
+
+    /// ...plus this many parts per million of the time since the last calibration.
+    constexpr int64_t kMaxDriftPpm = 100;
+
+    /**
+     * @brief Reads a kernel clock.
+     *
+     * @param id The clock ID.
+     * @return int64_t The time in nanoseconds.
+     */
+    int64_t kernelNs(clockid_t id) {
+        timespec ts;
+        clock_gettime(id, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    /**
+     * @brief Reads the time-stamp counter.
+     *
+     * @return uint64_t The counter value, or 0 without a TSC.
+     */
+    uint64_t readTsc() {
+#ifdef TSCCLOCK_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Checks whether the CPU advertises an invariant TSC (constant rate, never stops).
+     *
+     * @return True if the TSC can be used as a clock.
+     */
+    bool hasInvariantTsc() {
+#ifdef TSCCLOCK_HAS_TSC
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+            return false;
+        }
+        __cpuid(0x80000007, eax, ebx, ecx, edx);
+        return (edx & (1u << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Samples the TSC and the kernel clocks as close together as possible.
+     *
+     * The TSC is read on both sides of the kernel calls and the midpoint is used.
+     *
+     * @param tsc Receives the TSC value.
+     * @param monotonic Receives CLOCK_MONOTONIC.
+     * @param wall Receives CLOCK_REALTIME.
+     */
+    void sample(uint64_t& tsc, int64_t& monotonic, int64_t& wall) {
+        uint64_t before = readTsc();
+        monotonic = kernelNs(CLOCK_MONOTONIC);
+        wall = kernelNs(CLOCK_REALTIME);
+        uint64_t after = readTsc();
+        tsc = before + (after - before) / 2;
+    }
+}
+
+/**
+ * @brief Gets the process-wide clock, calibrating it on first use.
+ *
+ * @return tscClock& The clock.
+ */
+tscClock& tscClock::instance() {
+    static tscClock clock;
+    return clock;
+}
+
+/**
+ * @brief Measures the TSC rate over a short busy wait at startup.
+ */
+tscClock::tscClock()
+    : m_useTsc(hasInvariantTsc()),
+      m_sequence(0),
+      m_tscBase(0),
+      m_wallBase(0),
+      m_monotonicBase(0),
+      m_monotonicFloor(0),
+      m_nsPerTick(0.0),
+      m_firstTsc(0),
+      m_firstMonotonic(0),
+      m_calibrating(false) {
+    if (!m_useTsc) {
+        return;
+    }
+    int64_t wall = 0;
+    sample(m_firstTsc, m_firstMonotonic, wall);
+    uint64_t tsc = 0;
+    int64_t monotonic = 0;
+    do {
+        sample(tsc, monotonic, wall);
+    } while (monotonic - m_firstMonotonic < kStartupCalibrationNs);
+    if (tsc <= m_firstTsc) {
+        m_useTsc = false;
+        return;
+    }
+    m_nsPerTick = static_cast<double>(monotonic - m_firstMonotonic) / static_cast<double>(tsc - m_firstTsc);
+    m_tscBase = tsc;
+    m_wallBase = wall;
+    m_monotonicBase = monotonic;
+}
+
+/**
+ * @brief Re-measures the TSC rate and re-anchors the wall clock.
+ *
+ * The rate is taken over the whole time since startup, so it gets more precise with every
+ * call. Both timelines are re-anchored to the kernel's clocks, so corrections never
+ * accumulate; if the TSC ran ahead, monotonic readings hold at the last value it could
+ * have returned until the kernel catches up, so they never decrease. A TSC that drifted
+ * from the kernel by more than 1 ms plus 100 ppm of the time since the last calibration
+ * is abandoned.
+ */
+void tscClock::calibrate() {
+    if (!m_useTsc || m_calibrating.exchange(true)) {
+        return;
+    }
+    uint64_t tsc = 0;
+    int64_t monotonic = 0;
+    int64_t wall = 0;
+    sample(tsc, monotonic, wall);
+    int64_t predicted = read(false);
+    int64_t sinceLast = monotonic - m_monotonicBase.load(std::memory_order_relaxed);
+    if (tsc <= m_firstTsc || std::llabs(predicted - monotonic) > kMaxDriftNs + sinceLast / 1000000 * kMaxDriftPpm) {
+        m_useTsc = false;
+        m_calibrating = false;
+        return;
+    }
+    double nsPerTick = static_cast<double>(monotonic - m_firstMonotonic) / static_cast<double>(tsc - m_firstTsc);
+
+    m_sequence.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_release);
+    // Readers that got past the seqlock read the TSC before it went odd, so no value
+    // returned from the old anchor exceeds this one
+    int64_t latest = m_monotonicBase.load(std::memory_order_relaxed) +
+        static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(readTsc() - m_tscBase.load(std::memory_order_relaxed))) *
+                             m_nsPerTick.load(std::memory_order_relaxed));
+    if (latest > m_monotonicFloor.load(std::memory_order_relaxed)) {
+        m_monotonicFloor.store(latest, std::memory_order_relaxed);
+    }
+    m_tscBase.store(tsc, std::memory_order_relaxed);
+    m_wallBase.store(wall, std::memory_order_relaxed);
+    m_monotonicBase.store(monotonic, std::memory_order_relaxed);
+    m_nsPerTick.store(nsPerTick, std::memory_order_relaxed);
+    m_sequence.fetch_add(1, std::memory_order_release);
+    m_calibrating = false;
+}
+
+/**
+ * @brief Reads the calibration under the seqlock and converts a TSC value.
+ *
+ * Monotonic values are clamped to the floor left by earlier anchors.
+ *
+ * @param wall True for wall-clock time, false for monotonic time.
+ * @return int64_t The timestamp in nanoseconds.
+ */
+int64_t tscClock::read(bool wall) const {
+    for (;;) {
+        uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        uint64_t tscBase = m_tscBase.load(std::memory_order_relaxed);
+        int64_t base = wall ? m_wallBase.load(std::memory_order_relaxed) : m_monotonicBase.load(std::memory_order_relaxed);
+        int64_t minimum = wall ? INT64_MIN : m_monotonicFloor.load(std::memory_order_relaxed);
+        double nsPerTick = m_nsPerTick.load(std::memory_order_relaxed);
+        // Read the counter inside the critical section, so calibrate can bound the values returned
+        uint64_t tsc = readTsc();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        int64_t value = base + static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(tsc - tscBase)) * nsPerTick);
+        return value > minimum ? value : minimum;
+    }
+}
+
+/**
+ * @brief Gets the wall-clock time.
+ *
+ * @return int64_t Nanoseconds since the Unix epoch.
+ */
+int64_t tscClock::nowNs() const {
+    return m_useTsc.load(std::memory_order_relaxed) ? read(true) : kernelNs(CLOCK_REALTIME);
+}
+
+/**
+ * @brief Gets the monotonic time.
+ *
+ * After a fallback to the kernel clock the value may step once, by at most the drift
+ * that triggered the fallback.
+ *
+ * @return int64_t Nanoseconds since an unspecified point; never decreases.
+ */
+int64_t tscClock::monotonicNs() const {
+    return m_useTsc.load(std::memory_order_relaxed) ? read(false) : kernelNs(CLOCK_MONOTONIC);
+}
+
+/**
+ * @brief Checks whether timestamps come from the TSC.
+ *
+ * @return True if the TSC is used, false if clock_gettime is.
+ */
+bool tscClock::usingTsc() const {
+    return m_useTsc.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the measured TSC frequency.
+ *
+ * @return double Ticks per nanosecond (GHz), or 0 when the TSC is not used.
+ */
+double tscClock::ticksPerNs() const {
+    double nsPerTick = m_nsPerTick.load(std::memory_order_relaxed);
+    return usingTsc() && nsPerTick > 0.0 ? 1.0 / nsPerTick : 0.0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file tscClock.h
+ * @brief Header file for the calibrated TSC clock.
+ *
+ * This file defines the `tscClock` class, which turns the CPU's invariant time-stamp
+ * counter into wall-clock and monotonic timestamps without a system call.
+ */
+
+#ifndef TSCCLOCK_H
+#define TSCCLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class tscClock
+ * @brief Nanosecond timestamps from the invariant TSC, calibrated against the kernel.
+ *
+ * At startup the TSC rate is measured against CLOCK_MONOTONIC and anchored to
+ * CLOCK_REALTIME. `calibrate` should be called periodically (the client does so from its
+ * timer wheel) to track the rate over a longer baseline and follow NTP adjustments of the
+ * wall clock. Reading the clock is a `rdtsc`, a multiply and a seqlock check.
+ *
+ * The clock falls back to clock_gettime when the CPU does not report an invariant TSC,
+ * when the build is not for x86, or when a recalibration finds the TSC drifting from the
+ * kernel's clock. All methods are thread-safe.
+ */
+class tscClock {
+public:
+    /**
+     * @brief Gets the process-wide clock, calibrating it on first use.
+     *
+     * @return tscClock& The clock.
+     */
+    static tscClock& instance();
+
+    /**
+     * @brief Re-measures the TSC rate and re-anchors the wall clock.
+     */
+    void calibrate();
+
+    /**
+     * @brief Gets the wall-clock time.
+     *
+     * @return int64_t Nanoseconds since the Unix epoch.
+     */
+    int64_t nowNs() const;
+
+    /**
+     * @brief Gets the monotonic time.
+     *
+     * @return int64_t Nanoseconds since an unspecified point; never decreases.
+     */
+    int64_t monotonicNs() const;
+
+    /**
+     * @brief Checks whether timestamps come from the TSC.
+     *
+     * @return True if the TSC is used, false if clock_gettime is.
+     */
+    bool usingTsc() const;
+
+    /**
+     * @brief Gets the measured TSC frequency.
+     *
+     * @return double Ticks per nanosecond (GHz), or 0 when the TSC is not used.
+     */
+    double ticksPerNs() const;
+
+private:
+    tscClock();
+
+    /**
+     * @brief Reads the calibration under the seqlock and converts a TSC value.
+     *
+     * @param wall True for wall-clock time, false for monotonic time.
+     * @return int64_t The timestamp in nanoseconds.
+     */
+    int64_t read(bool wall) const;
+
+    std::atomic<bool> m_useTsc; ///< Whether timestamps come from the TSC.
+    std::atomic<uint32_t> m_sequence; ///< Seqlock sequence; odd while the calibration is written.
+    std::atomic<uint64_t> m_tscBase; ///< TSC value at the anchor.
+    std::atomic<int64_t> m_wallBase; ///< Wall-clock time at the anchor.
+    std::atomic<int64_t> m_monotonicBase; ///< Monotonic time at the anchor.
+    std::atomic<int64_t> m_monotonicFloor; ///< Latest monotonic time the previous anchors could have returned.
+    std::atomic<double> m_nsPerTick; ///< Nanoseconds per TSC tick.
+    uint64_t m_firstTsc; ///< TSC at the first calibration, for the long-baseline rate.
+    int64_t m_firstMonotonic; ///< CLOCK_MONOTONIC at the first calibration.
+    std::atomic<bool> m_calibrating; ///< Serializes writers.
+};
+
+#endif // TSCCLOCK_H
@@ -7,27 +7,133 @@
  */
 
 #include "utils.h"
+#include "tscClock.h"
 #include <fmt/core.h> // Use fmt for formatted output
 #include <openssl/hmac.h>
 #include <openssl/sha.h>
 #include <chrono>
 #include <random>
-#include <iomanip>
-#include <sstream>
+#include <sys/random.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+namespace {
+
+    /**
+     * @brief xoshiro256** pseudo-random generator.
+     *
+     * Small, fast and statistically strong; one instance lives in every thread.
+     */
+    class xoshiro256 {
+    public:
+        /**
+         * @brief Seeds the generator from the kernel, falling back to std::random_device.
+         */
+        xoshiro256() {
+            ssize_t filled = getrandom(m_state, sizeof(m_state), 0);
+            if (filled != static_cast<ssize_t>(sizeof(m_state))) {
+                std::random_device rd;
+                for (uint64_t& word : m_state) {
+                    word = (static_cast<uint64_t>(rd()) << 32) | rd();
+                }
+            }
+            if ((m_state[0] | m_state[1] | m_state[2] | m_state[3]) == 0) {
+                m_state[0] = 0x9e3779b97f4a7c15ULL; // The all-zero state is a fixed point
+            }
+        }
+
+        /**
+         * @brief Returns the next 64 random bits.
+         *
+         * @return uint64_t The random value.
+         */
+        uint64_t next() {
+            uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+            uint64_t t = m_state[1] << 17;
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+            return result;
+        }
+
+    private:
+        static uint64_t rotl(uint64_t x, int k) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        uint64_t m_state[4];
+    };
+
+    /**
+     * @brief Two lowercase hex digits for every byte value.
+     */
+    struct hexTable {
+        char digits[512];
+
+        constexpr hexTable() : digits() {
+            const char* alphabet = "0123456789abcdef";
+            for (int i = 0; i < 256; ++i) {
+                digits[2 * i] = alphabet[i >> 4];
+                digits[2 * i + 1] = alphabet[i & 0x0f];
+            }
+        }
+    };
+
+    constexpr hexTable kHexTable;
+
+    /// Size of an HMAC-SHA256 digest.
+    constexpr size_t kSha256Length = 32;
+}
 
 namespace utils {
 
     /**
      * @brief Generates a timestamp in milliseconds since the Unix epoch.
      *
-     * This function retrieves the current system time and converts it to milliseconds.
+     * This function reads the calibrated TSC clock (clock_gettime when the TSC is unusable)
+     * and converts it to milliseconds.
      *
      * @return std::string The timestamp as a string.
      */
     std::string getTimeStamp() {
-        using namespace std::chrono;
-        long long timeStamp = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-        return std::to_string(timeStamp);
+        return std::to_string(tscClock::instance().nowNs() / 1000000);
+    }
+
+    /**
+     * @brief Returns 64 random bits from the calling thread's generator.
+     *
+     * @return uint64_t The random value.
+     */
+    uint64_t random64() {
+        thread_local xoshiro256 generator;
+        return generator.next();
+    }
+
+    /**
+     * @brief Fills a buffer with a random lowercase alphanumeric nonce.
+     *
+     * Every character scales 16 random bits onto the alphabet by multiply-shift, so two
+     * draws cover the whole nonce. 65536 is not a multiple of 36: 16 characters get one
+     * value more than the other 20, a relative bias of 1/1820 (about 0.055%), which is
+     * harmless for a nonce that only has to be unique.
+     *
+     * @param out The buffer to fill; it is not null-terminated.
+     */
+    void fillNonce(char (&out)[kNonceLength]) {
+        static constexpr char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+        static constexpr uint64_t alphabet = sizeof(chars) - 1;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < kNonceLength; ++i) {
+            if (i % 4 == 0) {
+                bits = random64();
+            }
+            out[i] = chars[((bits & 0xffff) * alphabet) >> 16];
+            bits >>= 16;
+        }
     }
 
     /**
@@ -38,16 +144,36 @@ namespace utils {
      * @return std::string The generated nonce.
      */
     std::string getNonce() {
-        const std::string chars = "abcdefghijklmnopqrstuvwxyz0123456789";
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<char> dist(0, chars.size() - 1);
-
-        std::string nonce;
-        for (int i = 0; i < 8; ++i) {
-            nonce += chars[dist(gen)];
+        char nonce[kNonceLength];
+        fillNonce(nonce);
+        return std::string(nonce, kNonceLength);
+    }
+
+    /**
+     * @brief Writes the lowercase hexadecimal form of binary data into a caller buffer.
+     *
+     * @param data The binary data to convert.
+     * @param length The length of the binary data.
+     * @param out The output buffer; must hold 2 * length characters (no terminator is written).
+     */
+    void toHex(const unsigned char* data, size_t length, char* out) {
+        size_t i = 0;
+#ifdef __SSSE3__
+        const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        const __m128i lowNibble = _mm_set1_epi8(0x0f);
+        for (; i + 16 <= length; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), lowNibble));
+            __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, lowNibble));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+        }
+#endif
+        for (; i < length; ++i) {
+            const char* pair = &kHexTable.digits[2 * data[i]];
+            out[2 * i] = pair[0];
+            out[2 * i + 1] = pair[1];
         }
-        return nonce;
     }
 
     /**
@@ -60,12 +186,9 @@ namespace utils {
      * @return std::string The hexadecimal representation of the data.
      */
     std::string toHex(const unsigned char* data, size_t length) {
-        std::ostringstream hexStream;
-        hexStream << std::hex << std::setfill('0');
-        for (size_t i = 0; i < length; ++i) {
-            hexStream << std::setw(2) << (int)data[i];
-        }
-        return hexStream.str();
+        std::string hex(2 * length, '\0');
+        toHex(data, length, &hex[0]);
+        return hex;
     }
 
     /**
@@ -88,11 +211,30 @@ namespace utils {
         return toHex(result, resultLength);
     }
 
+    /**
+     * @brief Builds the string a Deribit client signature covers ("timestamp\nnonce\ndata").
+     *
+     * The buffer keeps its capacity between calls, so signing does not allocate for it.
+     *
+     * @param timeStamp The timestamp to include in the signature.
+     * @param nonce The nonce to include in the signature.
+     * @param data Additional data to include in the signature (optional).
+     * @return const std::string& A per-thread scratch buffer holding the string, valid until
+     *         the next call on the same thread.
+     */
+    const std::string& stringToSign(const std::string& timeStamp, const std::string& nonce, const std::string& data) {
+        thread_local std::string buffer;
+        buffer.clear();
+        buffer.append(timeStamp).append(1, '\n').append(nonce).append(1, '\n').append(data);
+        return buffer;
+    }
+
     /**
      * @brief Generates a client signature using the provided client secret, timestamp, nonce, and data.
      *
-     * This function creates a string to sign by concatenating the timestamp, nonce, and data,
-     * then computes the HMAC-SHA256 hash of the string using the client secret.
+     * This function creates a string to sign by concatenating the timestamp, nonce, and data
+     * (stringToSign), then computes the HMAC-SHA256 hash of the string using the client
+     * secret. The digest is hex-encoded on the stack.
      *
      * @param clientSecret The client secret for the HMAC computation.
      * @param timeStamp The timestamp to include in the signature.
@@ -101,7 +243,16 @@ namespace utils {
      * @return std::string The client signature as a hexadecimal string.
      */
     std::string getClientSignature(const std::string& clientSecret, const std::string& timeStamp, const std::string& nonce, const std::string& data) {
-        std::string stringToSign = timeStamp + "\n" + nonce + "\n" + data;
-        return hmacSha256(clientSecret, stringToSign);
+        const std::string& message = stringToSign(timeStamp, nonce, data);
+
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digestLength = 0;
+        HMAC(EVP_sha256(), clientSecret.data(), static_cast<int>(clientSecret.length()),
+             reinterpret_cast<const unsigned char*>(message.data()), message.length(),
+             digest, &digestLength);
+
+        char hex[2 * kSha256Length];
+        toHex(digest, digestLength, hex);
+        return std::string(hex, 2 * digestLength);
     }
-}
\ No newline at end of file
+}
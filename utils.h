@@ -9,19 +9,41 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace utils {
 
+    constexpr size_t kNonceLength = 8; ///< Length of generated nonces.
+
     /**
      * @brief Generates a timestamp in milliseconds since the Unix epoch.
      *
-     * This function retrieves the current system time and converts it to milliseconds.
+     * This function reads the calibrated TSC clock (clock_gettime when the TSC is unusable)
+     * and converts it to milliseconds.
      *
      * @return std::string The timestamp as a string.
      */
     std::string getTimeStamp();
 
+    /**
+     * @brief Returns 64 random bits from the calling thread's generator.
+     *
+     * Each thread owns a xoshiro256** generator seeded once from getrandom(), so no call
+     * after the first makes a syscall or takes a lock. Not suitable for key material.
+     *
+     * @return uint64_t The random value.
+     */
+    uint64_t random64();
+
+    /**
+     * @brief Fills a buffer with a random lowercase alphanumeric nonce.
+     *
+     * @param out The buffer to fill; it is not null-terminated.
+     */
+    void fillNonce(char (&out)[kNonceLength]);
+
     /**
      * @brief Generates a random nonce of 8 characters.
      *
@@ -31,6 +53,17 @@ namespace utils {
      */
     std::string getNonce();
 
+    /**
+     * @brief Builds the string a Deribit client signature covers ("timestamp\nnonce\ndata").
+     *
+     * @param timeStamp The timestamp to include in the signature.
+     * @param nonce The nonce to include in the signature.
+     * @param data [optional] Additional data to include in the signature.
+     * @return const std::string& A per-thread scratch buffer holding the string, valid until
+     *         the next call on the same thread.
+     */
+    const std::string& stringToSign(const std::string& timeStamp, const std::string& nonce, const std::string& data = "");
+
     /**
      * @brief Generates a client signature using the provided client secret, timestamp, nonce, and data.
      *
@@ -45,6 +78,18 @@ namespace utils {
      */
     std::string getClientSignature(const std::string& clientSecret, const std::string& timeStamp, const std::string& nonce, const std::string& data = "");
 
+    /**
+     * @brief Writes the lowercase hexadecimal form of binary data into a caller buffer.
+     *
+     * Uses a 256-entry lookup table, or SSSE3 shuffles 16 bytes at a time when the build
+     * targets SSSE3. Nothing is allocated.
+     *
+     * @param data The binary data to convert.
+     * @param length The length of the binary data.
+     * @param out The output buffer; must hold 2 * length characters (no terminator is written).
+     */
+    void toHex(const unsigned char* data, size_t length, char* out);
+
     /**
      * @brief Converts binary data to a hexadecimal string.
      *
@@ -5,11 +5,29 @@
 
 #include "webSocketClient.h"
 #include "deriapi.h"
+#include "tscClock.h"
 #include <fmt/core.h> // Use fmt for formatted output
 #include <iostream>
 #include <thread>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include <algorithm>
+#include <csignal>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+    /**
+     * @brief Gets the steady-clock time in milliseconds.
+     *
+     * @return long long Milliseconds since an unspecified epoch.
+     */
+    long long steadyMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
 
 /**
  * @brief Constructs a new WebSocket client.
@@ -20,7 +38,31 @@ webSocketClient::webSocketClient()
     : m_connected(false), 
       m_authRequestCallback(nullptr), 
       m_authenticated(false), 
-      m_waitingForResponse(false) {
+      m_waitingForResponse(false),
+      m_accessToken(std::make_shared<const std::string>()),
+      m_refreshTimer(timerWheel::kNoTimer),
+      m_drainScheduled(false),
+      m_reconcileScheduled(false),
+      m_killed(false),
+      m_killAllRequest(deriapi::cancelAll(kKillRequestId)),
+      m_quotes(m_orders),
+      m_timers(3 * m_orders.capacity() + 64, kTimerTickMs),
+      m_orderTimers(m_orders.capacity()),
+      m_expiryTimers(m_orders.capacity()),
+      m_editTimers(m_orders.capacity()),
+      m_authFailed(false),
+      m_reauthorizing(false),
+      m_lastMessageMs(0),
+      m_heartbeatScheduled(false),
+      m_quoteRefreshScheduled(false),
+      m_syncScheduled(false),
+      m_busyNs(0),
+      m_loadWindowStartNs(tscClock::instance().monotonicNs()),
+      m_bookSummariesPending(0),
+      m_bookSummarySentNs(0),
+      m_connecting(false),
+      m_seededPublisher(nullptr),
+      m_seededGateway(nullptr) {
     // Disable logging for cleaner output
     m_endpoint.clear_access_channels(websocketpp::log::alevel::all);
     m_endpoint.clear_error_channels(websocketpp::log::elevel::all);
@@ -28,6 +70,16 @@ webSocketClient::webSocketClient()
     // Initialize ASIO and start perpetual loop
     m_endpoint.init_asio();
     m_endpoint.start_perpetual();
+
+    // Every deadline lives in one timer wheel, advanced by a single event-loop timer
+    m_timers.setHandler([this](uint32_t kind, uint64_t arg) { onTimer(static_cast<timerKind>(kind), arg); });
+    tickTimers();
+    m_timers.schedule(kClockCalibrateMs, static_cast<uint32_t>(timerKind::clockCalibrate), 0);
+    m_timers.schedule(kLoadCheckMs, static_cast<uint32_t>(timerKind::loadCheck), 0);
+
+    // Kill switch signal, handled on the event loop rather than in signal context
+    m_killSignals.reset(new boost::asio::signal_set(m_endpoint.get_io_service(), SIGUSR1));
+    armKillSignal();
     
     // Set up TLS handler
     m_endpoint.set_tls_init_handler([this](websocketpp::connection_hdl) {
@@ -38,7 +90,28 @@ webSocketClient::webSocketClient()
     m_endpoint.set_open_handler([this](auto hdl) { this->on_open(&m_endpoint, hdl); });
     m_endpoint.set_fail_handler([this](auto hdl) { this->on_fail(&m_endpoint, hdl); });
     m_endpoint.set_close_handler([this](auto hdl) { this->on_close(&m_endpoint, hdl); });
-    m_endpoint.set_message_handler([this](auto hdl, auto msg) { this->on_message(&m_endpoint, hdl, msg); });
+    m_endpoint.set_message_handler([this](auto hdl, auto msg) {
+        int64_t start = tscClock::instance().monotonicNs();
+        this->on_message(&m_endpoint, hdl, msg);
+        m_busyNs += tscClock::instance().monotonicNs() - start;
+    });
+
+    // Keep the risk gate's open-order counts in step with the order manager
+    m_orders.setStateCallback([this](const order& o, orderState previous) {
+        bool wasLive = previous != orderState::free;
+        if (!wasLive && o.isLive()) {
+            m_risk.onOrderOpened(o.instrument);
+        } else if (wasLive && !o.isLive()) {
+            m_risk.onOrderClosed(o.instrument);
+            // Deadlines of finished orders must not fire for the next order in the slot
+            m_timers.cancel(m_orderTimers[o.clientId].exchange(timerWheel::kNoTimer));
+            m_timers.cancel(m_expiryTimers[o.clientId].exchange(timerWheel::kNoTimer));
+            m_timers.cancel(m_editTimers[o.clientId].exchange(timerWheel::kNoTimer));
+        }
+    });
+
+    // Printing is slow; it runs on its own thread so it never stalls the socket reader
+    m_outputThread = std::thread([this]() { runOutput(); });
 }
 
 /**
@@ -51,6 +124,10 @@ webSocketClient::~webSocketClient() {
     if (m_connected) {
         close();
     }
+    m_output.close();
+    if (m_outputThread.joinable()) {
+        m_outputThread.join();
+    }
 }
 
 /**
@@ -63,117 +140,1219 @@ void webSocketClient::setAuthRequestCallback(std::function<void()> callback) {
 }
 
 /**
- * @brief Sends a message through the WebSocket connection.
+ * @brief Sends a message through the WebSocket connection.
+ *
+ * The message is charged to the non-matching credit pool of the rate limiter.
+ *
+ * @param message The message to send.
+ */
+void webSocketClient::send(const std::string& message) {
+    send(message, creditPool::nonMatching);
+}
+
+/**
+ * @brief Sends a message through the rate limiter.
+ *
+ * @param message The message to send.
+ * @param pool The credit pool the request is charged to.
+ * @return True if the message was sent or queued, false if it was dropped.
+ */
+bool webSocketClient::send(std::string message, creditPool pool) {
+    return submit(std::move(message), pool) != admission::rejected;
+}
+
+/**
+ * @brief Submits a message to the rate limiter and sends it if it has credits.
+ *
+ * @param message The message to send.
+ * @param pool The credit pool the request is charged to.
+ * @return admission Whether the message was sent, queued or dropped.
+ */
+admission webSocketClient::submit(std::string message, creditPool pool) {
+    admission result = m_rateLimiter.admit(pool, message);
+    switch (result) {
+        case admission::send:
+            sendNow(message);
+            break;
+        case admission::queued:
+            // Callers run on any thread; the drain itself always runs on the event loop
+            if (!m_drainScheduled.exchange(true) &&
+                m_timers.schedule(0, static_cast<uint32_t>(timerKind::drain), 0) == timerWheel::kNoTimer) {
+                fmt::print(stderr, "Timer wheel full, queued messages delayed.\n");
+                m_drainScheduled = false;
+            }
+            break;
+        case admission::rejected:
+            fmt::print(stderr, "Request dropped by local rate limiter.\n");
+            break;
+    }
+    return result;
+}
+
+/**
+ * @brief Sends queued messages that have credits and re-arms the drain timer if needed.
+ *
+ * Runs on the event loop through the timer wheel; no separate thread is involved.
+ * Must only be called by the owner of m_drainScheduled. The acknowledgement timeout of a
+ * queued order starts here, when the order is actually written. New messages queue until
+ * the whole drained batch is written, and a global kill drops the orders of the batch
+ * that are not written yet.
+ */
+void webSocketClient::drainQueued() {
+    std::vector<std::string> ready;
+    for (;;) {
+        ready.clear();
+        long next = m_rateLimiter.drain(ready);
+        for (const std::string& message : ready) {
+            uint32_t clientId = orderIdOf(message);
+            std::lock_guard<std::mutex> lock(m_drainMutex);
+            if (clientId != orderManager::kInvalidId && m_killed) {
+                m_orders.onReject(clientId);
+                continue;
+            }
+            sendNow(message);
+            if (clientId != orderManager::kInvalidId) {
+                armOrderTimeout(clientId);
+            }
+        }
+        m_rateLimiter.endDrain();
+        if (next >= 0) {
+            if (m_timers.schedule(next, static_cast<uint32_t>(timerKind::drain), 0) == timerWheel::kNoTimer) {
+                // Queued messages go out with the next send that finds the timer free
+                fmt::print(stderr, "Timer wheel full, queued messages delayed.\n");
+                m_drainScheduled = false;
+            }
+            return;
+        }
+        m_drainScheduled = false;
+        // A message may have been queued between drain() and clearing the flag
+        if (m_rateLimiter.queueDepth() == 0 || m_drainScheduled.exchange(true)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Writes a message to the connection, bypassing the rate limiter.
+ *
+ * @param message The message to send.
+ */
+void webSocketClient::sendNow(const std::string& message) {
+    websocketpp::lib::error_code ec;
+    m_endpoint.send(m_hdl, message, websocketpp::frame::opcode::text, ec);
+    if (ec) {
+        fmt::print(stderr, "Send error: {}\n", ec.message());
+    }
+}
+
+/**
+ * @brief Gets the client-side ID of a new-order request.
+ *
+ * Parses the whole request; only used for requests that waited in the rate limiter.
+ *
+ * @param request The serialized request.
+ * @return uint32_t The client-side ID, or orderManager::kInvalidId for other requests.
+ */
+uint32_t webSocketClient::orderIdOf(const std::string& request) const {
+    nlohmann::json parsed = nlohmann::json::parse(request, nullptr, false);
+    int requestId = parsed.is_object() ? parsed.value("id", 0) : 0;
+    if (requestId >= kOrderRequestBase && requestId < kOrderRequestBase + static_cast<int>(m_orders.capacity())) {
+        return static_cast<uint32_t>(requestId - kOrderRequestBase);
+    }
+    return orderManager::kInvalidId;
+}
+
+/**
+ * @brief Connects to a WebSocket server.
+ *
+ * Returns at once; the TLS handshake runs on the event loop. When the connection
+ * opens, the authorization, the channels subscribed so far and the warm-up book
+ * summaries are all written before any response is awaited.
+ *
+ * @param uri The URI of the WebSocket server to connect to.
+ */
+void webSocketClient::connect(const std::string& uri) {
+    m_startup.mark(startupStage::connectStarted);
+    m_authFailed = false;
+    websocketpp::lib::error_code ec;
+    client::connection_ptr con = m_endpoint.get_connection(uri, ec);
+    if (ec) {
+        fmt::print(stderr, "Connection error: {}\n", ec.message());
+        m_authFailed = true;
+        return;
+    }
+
+    m_connecting = true;
+    m_endpoint.connect(con);
+    startEventLoop();
+}
+
+/**
+ * @brief Starts the event-loop thread if it is not running yet.
+ *
+ * The perpetual loop outlives failed connection attempts, so a retry reuses it; the
+ * gateway may also start it before any connection exists.
+ */
+void webSocketClient::startEventLoop() {
+    if (!m_eventLoopThread.joinable()) {
+        m_eventLoopThread = std::thread([this]() { m_endpoint.run(); });
+    }
+}
+
+/**
+ * @brief Sends the authorization request on the open connection.
+ *
+ * Used when the client connected before credentials were known. The request is sent
+ * from the event loop.
+ */
+void webSocketClient::authenticate() {
+    m_authFailed = false;
+    m_timers.schedule(0, static_cast<uint32_t>(timerKind::authRequest), 0);
+}
+
+/**
+ * @brief Checks whether the connection is open.
+ *
+ * @return True if connected.
+ */
+bool webSocketClient::isConnected() const {
+    return m_connected;
+}
+
+/**
+ * @brief Checks whether a connection attempt is still in progress.
+ *
+ * @return True between connect and the connection opening or failing.
+ */
+bool webSocketClient::isConnecting() const {
+    return m_connecting;
+}
+
+/**
+ * @brief Closes the WebSocket connection.
+ */
+void webSocketClient::close() {
+    if (m_connected) {
+        websocketpp::lib::error_code ec;
+        m_endpoint.close(m_hdl, websocketpp::close::status::normal, "Closing Connection", ec);
+        if (ec) {
+            fmt::print(stderr, "Close error: {}\n", ec.message());
+            return;
+        }
+        m_connected = false;
+    }
+    m_endpoint.stop_perpetual();
+    m_endpoint.stop();
+
+    if (m_eventLoopThread.joinable()) {
+        m_eventLoopThread.join();
+    }
+}
+
+/**
+ * @brief Handles the WebSocket connection open event.
+ *
+ * @param c Pointer to the WebSocket client.
+ * @param hdl The connection handle.
+ */
+void webSocketClient::on_open(client* c, websocketpp::connection_hdl hdl) {
+    fmt::print("Connection opened!\n");
+    m_startup.mark(startupStage::connected);
+    m_hdl = hdl;
+    m_connected = true;
+    m_connecting = false;
+    m_lastMessageMs = steadyMs();
+    // Pipeline everything that does not need a token behind the authorization
+    if (m_authRequestCallback) {
+        requestAuthorization();
+    }
+    syncSubscriptions();
+    for (const std::string& currency : m_warmupCurrencies) {
+        requestBookSummary(currency);
+    }
+}
+
+/**
+ * @brief Handles the WebSocket connection fail event.
+ *
+ * @param c Pointer to the WebSocket client.
+ * @param hdl The connection handle.
+ */
+void webSocketClient::on_fail(client* c, websocketpp::connection_hdl hdl) {
+    fmt::print(stderr, "Connection failed!\n");
+    m_connected = false;
+    m_connecting = false;
+    m_authFailed = true;
+}
+
+/**
+ * @brief Handles the WebSocket connection close event.
+ *
+ * @param c Pointer to the WebSocket client.
+ * @param hdl The connection handle.
+ */
+void webSocketClient::on_close(client* c, websocketpp::connection_hdl hdl) {
+    fmt::print("Connection closed!\n");
+    m_connected = false;
+    m_subscriptions.reset();
+    m_bookSummariesPending = 0; // Responses to the old connection never arrive
+    for (std::atomic<timerWheel::timerId>& timer : m_editTimers) {
+        m_timers.cancel(timer.exchange(timerWheel::kNoTimer));
+    }
+    size_t abandoned = m_orders.abandonEdits();
+    if (abandoned > 0) {
+        fmt::print(stderr, "{} in-flight edit(s) abandoned with the connection.\n", abandoned);
+    }
+    // Queued orders would otherwise go out after the reconnect behind the label queries
+    // that resolve them, and a retry could duplicate them; the queries now decide alone
+    size_t dropped = m_rateLimiter.clear(creditPool::matching).size();
+    if (dropped > 0) {
+        fmt::print(stderr, "{} queued matching request(s) dropped with the connection.\n", dropped);
+    }
+}
+
+/**
+ * @brief Places an order and tracks it in the local order manager.
+ *
+ * The order must pass the pre-trade risk checks before it is sent.
+ *
+ * @param direction "buy" or "sell".
+ * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+ * @param amount The order amount.
+ * @param orderType The type of order (e.g., "limit", "market", "stop_limit").
+ * @param price The price for limit or stop-limit orders.
+ * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
+ * @param label A custom label for the order.
+ * @return uint32_t The client-side order ID, or orderManager::kInvalidId if the order was rejected locally.
+ */
+uint32_t webSocketClient::placeOrder(const std::string& direction, const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label) {
+    if (m_killed) {
+        fmt::print(stderr, "Order rejected: trading halted by kill switch.\n");
+        return orderManager::kInvalidId;
+    }
+    riskResult risk = m_risk.check(instrument, direction, amount, price);
+    if (risk != riskResult::accepted) {
+        fmt::print(stderr, "Order rejected by risk check: {}\n", toString(risk));
+        return orderManager::kInvalidId;
+    }
+    std::string orderLabel;
+    uint32_t clientId = m_orders.createPending(instrument, direction, orderType, amount, price, label, &orderLabel);
+    if (clientId == orderManager::kInvalidId) {
+        fmt::print(stderr, "Order not sent: all {} order slots hold live orders.\n", m_orders.capacity());
+        return clientId;
+    }
+    {
+        // Pre-serialize the per-instrument kill request while we are off the critical path
+        std::lock_guard<std::mutex> lock(m_killMutex);
+        if (m_killByInstrument.count(instrument) == 0) {
+            m_killByInstrument.emplace(instrument, deriapi::cancelAllByInstrument(instrument, kKillRequestId));
+        }
+    }
+    int requestId = kOrderRequestBase + static_cast<int>(clientId);
+    // No access token: the request is kept for resubmission, and the token may be refreshed
+    // or reissued by then; the WebSocket session itself is authenticated
+    std::string orderRequest = direction == "sell"
+        ? deriapi::sellOrder(instrument, amount, orderType, price, timeInForce, orderLabel, "", requestId)
+        : deriapi::buyOrder(instrument, amount, orderType, price, timeInForce, orderLabel, "", requestId);
+    m_orders.setPendingRequest(clientId, orderRequest);
+    admission sent = submit(orderRequest, creditPool::matching);
+    if (sent == admission::rejected) {
+        m_orders.onReject(clientId);
+        return orderManager::kInvalidId;
+    }
+    // A queued order gets its timeout from drainQueued once it is written
+    if (sent == admission::send) {
+        armOrderTimeout(clientId);
+    }
+    return clientId;
+}
+
+/**
+ * @brief Arms the acknowledgement timeout of a pending order.
+ *
+ * @param clientId The client-side ID of the order.
+ */
+void webSocketClient::armOrderTimeout(uint32_t clientId) {
+    timerWheel::timerId id = m_timers.schedule(kOrderTimeoutMs, static_cast<uint32_t>(timerKind::orderTimeout), clientId);
+    m_timers.cancel(m_orderTimers[clientId].exchange(id));
+}
+
+/**
+ * @brief Cancels an order once it has been working for a given time (client-side GTD).
+ *
+ * @param clientId The client-side ID returned by placeOrder.
+ * @param lifetimeMs The lifetime of the order in milliseconds.
+ */
+void webSocketClient::setOrderExpiry(uint32_t clientId, long lifetimeMs) {
+    if (clientId >= m_expiryTimers.size()) {
+        return;
+    }
+    timerWheel::timerId id = m_timers.schedule(lifetimeMs, static_cast<uint32_t>(timerKind::orderExpiry), clientId);
+    m_timers.cancel(m_expiryTimers[clientId].exchange(id));
+}
+
+/**
+ * @brief Advances the timer wheel on every event-loop tick.
+ *
+ * This is the only endpoint timer left; everything else is scheduled in the wheel.
+ */
+void webSocketClient::tickTimers() {
+    m_endpoint.set_timer(kTimerTickMs, [this](const websocketpp::lib::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        m_timers.advance();
+        tickTimers();
+    });
+}
+
+/**
+ * @brief Dispatches an expired timer.
+ *
+ * @param kind The timer kind.
+ * @param arg The timer argument.
+ */
+void webSocketClient::onTimer(timerKind kind, uint64_t arg) {
+    uint32_t clientId = static_cast<uint32_t>(arg);
+    switch (kind) {
+        case timerKind::drain:
+            drainQueued();
+            break;
+        case timerKind::orderTimeout:
+            queryOrderByLabel(clientId);
+            break;
+        case timerKind::editTimeout: {
+            // The response was lost; without this every later edit of the order would stay coalesced
+            m_editTimers[clientId] = timerWheel::kNoTimer;
+            fmt::print(stderr, "Edit of order {} not answered within {} ms.\n", clientId, kEditTimeoutMs);
+            orderEdit next;
+            if (m_orders.completeEdit(clientId, next)) {
+                sendEdit(clientId, next);
+            }
+            break;
+        }
+        case timerKind::orderExpiry: {
+            order o;
+            if (!m_orders.get(clientId, o) || !o.isLive()) {
+                break;
+            }
+            if (o.orderId.empty()) {
+                // Not acknowledged yet; try again shortly
+                setOrderExpiry(clientId, kTimerTickMs);
+                break;
+            }
+            fmt::print("Order {} expired, cancelling.\n", o.orderId);
+            cancelOrder(o.orderId);
+            break;
+        }
+        case timerKind::authTimeout:
+            if (!m_authenticated) {
+                fmt::print(stderr, "Authentication timed out.\n");
+                m_authFailed = true;
+            }
+            break;
+        case timerKind::heartbeat:
+            checkHeartbeat();
+            break;
+        case timerKind::reconcile:
+            if (!m_connected) {
+                m_reconcileScheduled = false;
+                break;
+            }
+            reconcilePositions();
+            scheduleReconcile();
+            break;
+        case timerKind::tokenRefresh:
+            m_refreshTimer = timerWheel::kNoTimer;
+            if (m_connected && !m_refreshToken.empty()) {
+                send(deriapi::refreshToken(m_refreshToken, kRefreshRequestId));
+            }
+            break;
+        case timerKind::clockCalibrate:
+            tscClock::instance().calibrate();
+            m_timers.schedule(kClockCalibrateMs, static_cast<uint32_t>(timerKind::clockCalibrate), 0);
+            break;
+        case timerKind::loadCheck: {
+            int64_t now = tscClock::instance().monotonicNs();
+            double utilization = static_cast<double>(m_busyNs) / static_cast<double>(std::max<int64_t>(now - m_loadWindowStartNs, 1));
+            m_busyNs = 0;
+            m_loadWindowStartNs = now;
+            // A consumer that overwrites or drops most of what it is offered is saturated too
+            conflationStats output = m_output.stats();
+            uint64_t offered = output.pushed - m_lastOutputStats.pushed;
+            uint64_t lost = (output.conflated - m_lastOutputStats.conflated) + (output.dropped - m_lastOutputStats.dropped);
+            m_lastOutputStats = output;
+            if (offered > 0) {
+                utilization = std::max(utilization, static_cast<double>(lost) / static_cast<double>(offered));
+            }
+            std::vector<intervalChange> changes;
+            m_subscriptions.adapt(utilization, changes);
+            for (const intervalChange& change : changes) {
+                fmt::print("Load at {:.0f}%: {} -> {}\n", utilization * 100, change.from, change.to);
+            }
+            if (!changes.empty() && m_connected) {
+                syncSubscriptions();
+            }
+            m_timers.schedule(kLoadCheckMs, static_cast<uint32_t>(timerKind::loadCheck), 0);
+            break;
+        }
+        case timerKind::authRequest:
+            if (m_connected && m_authRequestCallback) {
+                requestAuthorization();
+            }
+            break;
+        case timerKind::subscriptionSync:
+            m_syncScheduled = false;
+            syncSubscriptions();
+            break;
+        case timerKind::quoteRefresh: {
+            std::vector<quoteAction> actions;
+            m_quotes.refresh(actions);
+            executeQuoteActions(actions);
+            m_timers.schedule(kQuoteRefreshMs, static_cast<uint32_t>(timerKind::quoteRefresh), 0);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Closes the connection if nothing was received within the heartbeat deadline.
+ *
+ * The server sends at least one message per heartbeat interval, so two silent intervals
+ * mean the connection is dead even if TCP has not noticed yet.
+ */
+void webSocketClient::checkHeartbeat() {
+    if (!m_connected) {
+        m_heartbeatScheduled = false;
+        return;
+    }
+    long long deadline = 2LL * kHeartbeatIntervalS * 1000;
+    long long silence = steadyMs() - m_lastMessageMs;
+    if (silence < deadline) {
+        m_timers.schedule(static_cast<long>(deadline - silence), static_cast<uint32_t>(timerKind::heartbeat), 0);
+        return;
+    }
+    fmt::print(stderr, "No message for {} s, closing connection.\n", silence / 1000);
+    m_heartbeatScheduled = false;
+    websocketpp::lib::error_code ec;
+    m_endpoint.close(m_hdl, websocketpp::close::status::going_away, "Heartbeat timeout", ec);
+}
+
+/**
+ * @brief Stores new tokens from an authentication result and schedules their refresh.
+ *
+ * The refresh is due at 80% of the token's lifetime, leaving time for a retry with a
+ * full signature-based authorization before the token expires.
+ *
+ * @param result The result of a "public/auth" request.
+ */
+void webSocketClient::onTokens(const nlohmann::json& result) {
+    std::atomic_store(&m_accessToken, std::make_shared<const std::string>(result.value("access_token", "")));
+    m_refreshToken = result.value("refresh_token", "");
+    long expiresInMs = result.value("expires_in", 0L) * 1000;
+    m_timers.cancel(m_refreshTimer);
+    m_refreshTimer = timerWheel::kNoTimer;
+    if (expiresInMs > 0 && !m_refreshToken.empty()) {
+        m_refreshTimer = m_timers.schedule(expiresInMs / 5 * 4, static_cast<uint32_t>(timerKind::tokenRefresh), 0);
+    }
+}
+
+/**
+ * @brief Sends the authorization request and arms its timeout.
+ */
+void webSocketClient::requestAuthorization() {
+    m_authFailed = false;
+    m_reauthorizing = false; // A new connection needs the whole session set up again
+    m_authRequestCallback();
+    m_startup.mark(startupStage::authSent);
+    m_timers.schedule(kAuthTimeoutMs, static_cast<uint32_t>(timerKind::authTimeout), 0);
+}
+
+/**
+ * @brief Records the stages that depend on several events and, once, the tradeable state.
+ *
+ * Tradeable means authenticated, cancel-on-disconnect enabled, the private order feed
+ * acknowledged and the warm-up snapshots loaded. The timeline is printed when it is
+ * first reached.
+ */
+void webSocketClient::checkStartup() {
+    if (m_startup.reached(startupStage::tradeable) || !m_startup.reached(startupStage::authenticated) ||
+        !m_startup.reached(startupStage::cancelOnDisconnect)) {
+        return;
+    }
+    if (!m_warmupCurrencies.empty() && !m_startup.reached(startupStage::snapshotsLoaded)) {
+        return;
+    }
+    std::vector<channelStatus> channels = m_subscriptions.list();
+    bool orderFeed = std::any_of(channels.begin(), channels.end(), [](const channelStatus& status) {
+        return status.channel == "user.orders.any.any.raw" && status.state == channelState::subscribed;
+    });
+    if (orderFeed && m_startup.mark(startupStage::tradeable)) {
+        fmt::print("Startup timeline:\n{}", m_startup.report());
+    }
+}
+
+/**
+ * @brief Handles the response of a token refresh.
+ *
+ * Only the token changes: subscriptions, cancel-on-disconnect and the order flow are
+ * untouched. If the refresh is refused, the client signs a new authorization instead,
+ * whose response again only replaces the token.
+ *
+ * @param response The full JSON response.
+ */
+void webSocketClient::on_message_refresh(const nlohmann::json& response) {
+    if (response.contains("result") && response["result"].contains("access_token")) {
+        onTokens(response["result"]);
+        return;
+    }
+    fmt::print(stderr, "Token refresh failed: {}\n",
+               response.contains("error") ? response["error"].value("message", "Unknown error") : "no token in response");
+    if (m_authRequestCallback) {
+        m_reauthorizing = true;
+        m_authRequestCallback();
+    }
+}
+
+/**
+ * @brief Asks the exchange whether an unacknowledged order exists, by its label.
+ *
+ * Orders are never resubmitted blindly: only an empty answer to this query leads to a
+ * retry, so a timed-out order that did land cannot be filled twice.
+ *
+ * @param clientId The client-side ID of the order.
+ */
+void webSocketClient::queryOrderByLabel(uint32_t clientId) {
+    order o;
+    if (!m_orders.get(clientId, o) || o.state != orderState::pendingNew) {
+        return;
+    }
+    // Instruments are named <currency>-..., linear ones <base>_<settlement currency>-...
+    std::string currency = o.instrument.substr(0, o.instrument.find('-'));
+    size_t underscore = currency.find('_');
+    if (underscore != std::string::npos) {
+        currency = currency.substr(underscore + 1);
+    }
+    fmt::print(stderr, "Order {} not acknowledged, checking the exchange.\n", o.label);
+    send(deriapi::getOrderStateByLabel(currency, o.label, kLabelRequestBase + static_cast<int>(clientId)));
+}
+
+/**
+ * @brief Resolves a pending order from a label query, resubmitting it if it never landed.
+ *
+ * @param clientId The client-side ID of the order.
+ * @param response The full JSON response.
+ */
+void webSocketClient::on_message_label(uint32_t clientId, const nlohmann::json& response) {
+    order pending;
+    if (!m_orders.get(clientId, pending) || pending.state != orderState::pendingNew) {
+        return; // Acknowledged while the query was in flight
+    }
+    if (!response.contains("result") || !response["result"].is_array()) {
+        // The answer is unknown, so ask again later rather than risk a duplicate
+        armOrderTimeout(clientId);
+        return;
+    }
+    const nlohmann::json& found = response["result"];
+    if (!found.empty()) {
+        m_orders.onOrderUpdate(found[0], clientId);
+        for (size_t i = 1; i < found.size(); ++i) {
+            m_orders.onOrderUpdate(found[i]);
+        }
+        fmt::print("Order {} found on the exchange.\n", found[0].value("label", ""));
+        return;
+    }
+    std::string request;
+    if (m_orders.takeRetry(clientId, kMaxOrderAttempts, request)) {
+        fmt::print(stderr, "Order not found on the exchange, resubmitting.\n");
+        admission sent = submit(request, creditPool::matching);
+        if (sent == admission::send) {
+            armOrderTimeout(clientId);
+        } else if (sent == admission::rejected) {
+            m_orders.onReject(clientId);
+        }
+    } else {
+        fmt::print(stderr, "Order not found on the exchange after {} attempts, giving up.\n", kMaxOrderAttempts);
+        m_orders.onReject(clientId);
+    }
+}
+
+/**
+ * @brief Cancels an order by exchange order ID.
+ *
+ * @param orderId The exchange order ID.
+ */
+void webSocketClient::cancelOrder(const std::string& orderId) {
+    uint32_t clientId = m_orders.findByOrderId(orderId);
+    int requestId = clientId == orderManager::kInvalidId ? 4 : kCancelRequestBase + static_cast<int>(clientId);
+    send(deriapi::cancelOrder(orderId, requestId), creditPool::matching);
+}
+
+/**
+ * @brief Edits an order, coalescing rapid re-prices.
+ *
+ * @param orderId The exchange order ID.
+ * @param amount The new amount.
+ * @param price The new price.
+ * @param timeInForce The new time-in-force.
+ * @param postOnly Whether the order should be post-only.
+ * @param reduceOnly Whether the order should be reduce-only.
+ */
+void webSocketClient::modifyOrder(const std::string& orderId, int amount, double price, const std::string& timeInForce, bool postOnly, bool reduceOnly) {
+    uint32_t clientId = m_orders.findByOrderId(orderId);
+    if (clientId == orderManager::kInvalidId) {
+        send(deriapi::modifyOrder(orderId, amount, price, timeInForce, postOnly, reduceOnly), creditPool::matching);
+        return;
+    }
+    orderEdit edit;
+    edit.amount = amount;
+    edit.price = price;
+    edit.timeInForce = timeInForce;
+    edit.postOnly = postOnly;
+    edit.reduceOnly = reduceOnly;
+    if (m_orders.requestEdit(clientId, edit)) {
+        sendEdit(clientId, edit);
+    }
+}
+
+/**
+ * @brief Sends the in-flight edit of a tracked order.
+ *
+ * If the rate limiter drops the edit, the next pending edit (if any) is tried instead.
+ * A sent edit gets a timeout, so a lost response cannot hold back later edits forever;
+ * a response that arrives after its timeout resolves whichever edit is then in flight.
+ *
+ * @param clientId The client-side ID of the order.
+ * @param edit The target parameters.
+ */
+void webSocketClient::sendEdit(uint32_t clientId, const orderEdit& edit) {
+    order o;
+    orderEdit current = edit;
+    while (m_orders.get(clientId, o)) {
+        int requestId = kEditRequestBase + static_cast<int>(clientId);
+        std::string editRequest = deriapi::modifyOrder(o.orderId, static_cast<int>(current.amount), current.price,
+                                                       current.timeInForce, current.postOnly, current.reduceOnly, requestId);
+        if (send(editRequest, creditPool::matching)) {
+            timerWheel::timerId id = m_timers.schedule(kEditTimeoutMs, static_cast<uint32_t>(timerKind::editTimeout), clientId);
+            m_timers.cancel(m_editTimers[clientId].exchange(id));
+            return;
+        }
+        if (!m_orders.completeEdit(clientId, current)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Cancels every locally known open order on an instrument.
+ *
+ * Orders that are still pending acknowledgement have no exchange ID yet and are skipped.
+ *
+ * @param instrument The instrument name.
+ * @return size_t The number of cancel requests sent.
+ */
+size_t webSocketClient::cancelAll(const std::string& instrument) {
+    size_t sent = 0;
+    for (const order& o : m_orders.openOrders(instrument)) {
+        if (o.orderId.empty()) {
+            fmt::print(stderr, "Skipping order {} ({}): not acknowledged yet.\n", o.clientId, o.label);
+            continue;
+        }
+        cancelOrder(o.orderId);
+        ++sent;
+    }
+    return sent;
+}
+
+/**
+ * @brief Arms a client-side stop or take-profit order.
+ *
+ * Subscribes to the instrument's ticker if needed. When the ticker's last price crosses
+ * the level, the order is built and sent through placeOrder at that moment. Stops fire
+ * in the direction of the order (a buy stop fires from below); take-profits fire against it.
+ *
+ * @param isStop True for a stop, false for a take-profit.
+ * @param instrument The instrument name.
+ * @param direction "buy" or "sell".
+ * @param amount The order amount.
+ * @param level The trigger price.
+ * @param orderType "market" or "limit".
+ * @param price The limit price (ignored for market orders).
+ * @return uint32_t The trigger ID.
+ */
+uint32_t webSocketClient::addTrigger(bool isStop, const std::string& instrument, const std::string& direction, int amount, double level, const std::string& orderType, double price) {
+    trigger t = makeTrigger(isStop, instrument, direction, amount, level, orderType, price);
+    m_triggers.add(t);
+    watchTicker(instrument);
+    return t.id;
+}
+
+/**
+ * @brief Arms a stop and a take-profit order as a one-cancels-other pair.
+ *
+ * Subscribes to the instrument's ticker if needed.
+ *
+ * @param instrument The instrument name.
+ * @param direction "buy" or "sell".
+ * @param amount The order amount.
+ * @param stopLevel The trigger price of the stop.
+ * @param takeProfitLevel The trigger price of the take-profit.
+ * @param orderType "market" or "limit".
+ * @param price The limit price (ignored for market orders).
+ * @param stopId Receives the trigger ID of the stop.
+ * @param takeProfitId Receives the trigger ID of the take-profit.
+ */
+void webSocketClient::addOcoTriggers(const std::string& instrument, const std::string& direction, int amount, double stopLevel, double takeProfitLevel, const std::string& orderType, double price, uint32_t& stopId, uint32_t& takeProfitId) {
+    trigger stop = makeTrigger(true, instrument, direction, amount, stopLevel, orderType, price);
+    trigger takeProfit = makeTrigger(false, instrument, direction, amount, takeProfitLevel, orderType, price);
+    stopId = stop.id;
+    takeProfitId = takeProfit.id;
+    m_triggers.addOco(std::move(stop), std::move(takeProfit));
+    watchTicker(instrument);
+}
+
+/**
+ * @brief Builds an unarmed stop or take-profit trigger with a fresh ID.
+ *
+ * @param isStop True for a stop, false for a take-profit.
+ * @param instrument The instrument name.
+ * @param direction "buy" or "sell".
+ * @param amount The order amount.
+ * @param level The trigger price.
+ * @param orderType "market" or "limit".
+ * @param price The limit price (ignored for market orders).
+ * @return trigger The trigger.
+ */
+trigger webSocketClient::makeTrigger(bool isStop, const std::string& instrument, const std::string& direction, int amount, double level, const std::string& orderType, double price) {
+    bool isBuy = direction != "sell";
+    trigger t;
+    t.id = m_triggers.nextId();
+    t.instrument = instrument;
+    t.side = isStop == isBuy ? triggerSide::above : triggerSide::below;
+    t.level = level;
+    t.direction = direction;
+    t.amount = amount;
+    t.orderType = orderType;
+    t.price = orderType == "market" ? 0.0 : price;
+    return t;
+}
+
+/**
+ * @brief Subscribes to the instrument's 100 ms ticker unless it is already wanted.
+ *
+ * @param instrument The instrument name.
+ */
+void webSocketClient::watchTicker(const std::string& instrument) {
+    std::string channel = "ticker." + instrument + ".100ms";
+    if (!m_subscriptions.isDesired(channel)) {
+        subscribe(channel);
+    }
+}
+
+/**
+ * @brief Fires the triggers crossed by a new price.
+ *
+ * Fired orders go through placeOrder like any other order: kill switch, risk gate,
+ * order manager slot, acknowledgement timeout and label-based retry.
+ *
+ * @param instrument The instrument name.
+ * @param price The new price.
+ */
+void webSocketClient::evaluateTriggers(const std::string& instrument, double price) {
+    std::vector<trigger> fired;
+    m_triggers.onPrice(instrument, price, fired);
+    for (const trigger& t : fired) {
+        uint32_t clientId = placeOrder(t.direction, t.instrument, static_cast<int>(t.amount), t.orderType, t.price, "good_til_cancelled", "");
+        if (clientId == orderManager::kInvalidId) {
+            fmt::print(stderr, "Trigger {} on {} fired, but its order was not sent.\n", t.id, t.instrument);
+            continue;
+        }
+        fmt::print("Trigger {} fired: {} {} {} at {} (level {}), order {}\n", t.id, t.direction, t.amount, t.instrument, price, t.level, clientId);
+    }
+}
+
+/**
+ * @brief Starts two-sided quoting on an instrument.
+ *
+ * @param instrument The instrument name.
+ * @param config The quoting parameters.
+ */
+void webSocketClient::startQuoting(const std::string& instrument, const quoteConfig& config) {
+    m_quotes.start(instrument, config);
+    if (!m_quoteRefreshScheduled.exchange(true)) {
+        m_timers.schedule(kQuoteRefreshMs, static_cast<uint32_t>(timerKind::quoteRefresh), 0);
+    }
+    watchTicker(instrument);
+}
+
+/**
+ * @brief Stops quoting an instrument and cancels its live quotes.
+ *
+ * @param instrument The instrument name.
+ */
+void webSocketClient::stopQuoting(const std::string& instrument) {
+    std::vector<quoteAction> actions;
+    m_quotes.stop(instrument, actions);
+    executeQuoteActions(actions);
+}
+
+/**
+ * @brief Gets the quoting engine.
+ *
+ * @return quoteEngine& The quoting engine.
+ */
+quoteEngine& webSocketClient::getQuoteEngine() {
+    return m_quotes;
+}
+
+/**
+ * @brief Sends the requests produced by the quoting engine.
+ *
+ * New quotes go through placeOrder (risk gate, order manager) and are bound to their
+ * ladder slot; edits go through the coalescing edit path.
+ *
+ * @param actions The requests to send.
+ */
+void webSocketClient::executeQuoteActions(const std::vector<quoteAction>& actions) {
+    for (const quoteAction& action : actions) {
+        switch (action.type) {
+            case quoteAction::kind::place: {
+                // Quotes get generated labels, unique per order, so label lookups never match an older quote
+                uint32_t clientId = placeOrder(action.direction, action.instrument, static_cast<int>(action.amount),
+                                               "limit", action.price, "good_til_cancelled", "");
+                m_quotes.bind(action.instrument, action.direction, action.level, clientId);
+                break;
+            }
+            case quoteAction::kind::edit:
+                modifyOrder(action.orderId, static_cast<int>(action.amount), action.price, "good_til_cancelled");
+                break;
+            case quoteAction::kind::cancel:
+                cancelOrder(action.orderId);
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Fires the kill switch.
+ *
+ * @param instrument The instrument to cancel; empty for all orders.
+ */
+void webSocketClient::killSwitch(const std::string& instrument) {
+    if (instrument.empty()) {
+        {
+            // A drain writing orders finishes the current one first; the rest see m_killed
+            std::lock_guard<std::mutex> lock(m_drainMutex);
+            m_killed = true;
+        }
+        sendNow(m_killAllRequest);
+        m_quotes.stopAll();
+
+        // Orders still waiting for credits must not go out after the kill
+        for (const std::string& dropped : m_rateLimiter.clear(creditPool::matching)) {
+            uint32_t clientId = orderIdOf(dropped);
+            if (clientId != orderManager::kInvalidId) {
+                m_orders.onReject(clientId);
+            }
+        }
+        fmt::print(stderr, "Kill switch fired: cancelling all orders, new orders blocked.\n");
+        return;
+    }
+
+    std::string request;
+    {
+        std::lock_guard<std::mutex> lock(m_killMutex);
+        auto it = m_killByInstrument.find(instrument);
+        request = it != m_killByInstrument.end() ? it->second : deriapi::cancelAllByInstrument(instrument, kKillRequestId);
+    }
+    sendNow(request);
+    fmt::print(stderr, "Kill switch fired: cancelling all orders on {}.\n", instrument);
+}
+
+/**
+ * @brief Allows new orders again after a global kill.
+ */
+void webSocketClient::rearm() {
+    m_killed = false;
+}
+
+/**
+ * @brief Checks whether a global kill is in effect.
+ *
+ * @return True if new orders are blocked.
+ */
+bool webSocketClient::isKilled() const {
+    return m_killed;
+}
+
+/**
+ * @brief Waits for the next kill signal on the event loop.
+ */
+void webSocketClient::armKillSignal() {
+    m_killSignals->async_wait([this](const boost::system::error_code& ec, int signal) {
+        if (ec) {
+            return;
+        }
+        fmt::print(stderr, "Received signal {}.\n", signal);
+        killSwitch();
+        armKillSignal();
+    });
+}
+
+/**
+ * @brief Gets the local order manager.
+ *
+ * @return orderManager& The order manager.
+ */
+orderManager& webSocketClient::getOrderManager() {
+    return m_orders;
+}
+
+/**
+ * @brief Gets the pre-trade risk manager.
+ *
+ * @return riskManager& The risk manager.
+ */
+riskManager& webSocketClient::getRiskManager() {
+    return m_risk;
+}
+
+/**
+ * @brief Gets the client-side rate limiter.
+ *
+ * @return rateLimiter& The rate limiter.
+ */
+rateLimiter& webSocketClient::getRateLimiter() {
+    return m_rateLimiter;
+}
+
+/**
+ * @brief Gets the position tracker.
+ *
+ * @return positionTracker& The position tracker, updated from fills without a round-trip.
+ */
+positionTracker& webSocketClient::getPositionTracker() {
+    return m_positions;
+}
+
+/**
+ * @brief Gets the trigger engine.
+ *
+ * @return triggerEngine& The trigger engine.
+ */
+triggerEngine& webSocketClient::getTriggerEngine() {
+    return m_triggers;
+}
+
+/**
+ * @brief Applies fills to the position tracker and the risk gate.
+ *
+ * @param trades A trade object or an array of trade objects.
+ * @param print Whether to print one line per applied fill.
+ */
+void webSocketClient::applyTrades(const nlohmann::json& trades, bool print) {
+    auto applyOne = [this, print](const nlohmann::json& trade) {
+        position p;
+        if (m_positions.onTrade(trade, &p)) {
+            m_risk.onPosition(p.instrument, p.size);
+            if (print) {
+                fmt::print("Fill: {} {} {} @ {} -> position {} @ {} (realized {})\n",
+                           p.instrument, trade.value("direction", "N/A"), trade.value("amount", 0.0),
+                           trade.value("price", 0.0), p.size, p.averagePrice, p.realizedPnl);
+            }
+        }
+    };
+    if (trades.is_array()) {
+        for (const auto& trade : trades) {
+            applyOne(trade);
+        }
+    } else {
+        applyOne(trades);
+    }
+}
+
+/**
+ * @brief Requests all positions for reconciliation against the local tracker.
+ */
+void webSocketClient::reconcilePositions() {
+    send(deriapi::getPositions("any", "", kReconcileRequestId));
+}
+
+/**
+ * @brief Arms the periodic position reconciliation timer.
+ *
+ * The timer runs in the timer wheel and re-arms itself after every reconciliation.
+ */
+void webSocketClient::scheduleReconcile() {
+    m_timers.schedule(kReconcileIntervalMs, static_cast<uint32_t>(timerKind::reconcile), 0);
+}
+
+/**
+ * @brief Handles the response of a reconciliation request.
+ *
+ * Every exchange position is adopted by the tracker; local positions missing from the
+ * response are flat on the exchange. Drifts are reported on stderr.
+ *
+ * @param result The JSON array of exchange positions.
+ */
+void webSocketClient::on_message_reconcile(const nlohmann::json& result) {
+    if (!result.is_array()) {
+        return;
+    }
+    std::set<std::string> reported;
+    auto adopt = [this](const std::string& instrument, double size, double averagePrice) {
+        positionDrift drift = m_positions.reconcile(instrument, size, averagePrice);
+        if (drift.size != 0.0) {
+            fmt::print(stderr, "Position drift on {}: local {}, exchange {}\n", instrument, size - drift.size, size);
+        } else if (drift.averagePriceMismatch) {
+            fmt::print(stderr, "Average price drift on {}: local {}, exchange {}\n", instrument, drift.localAveragePrice, averagePrice);
+        }
+        m_risk.onPosition(instrument, size);
+    };
+    for (const auto& entry : result) {
+        if (!entry.contains("instrument_name") || !entry.contains("size") || !entry["size"].is_number()) {
+            continue;
+        }
+        std::string instrument = entry["instrument_name"].get<std::string>();
+        reported.insert(instrument);
+        adopt(instrument, entry["size"].get<double>(), entry.value("average_price", 0.0));
+    }
+    for (const position& p : m_positions.all()) {
+        if (p.size != 0.0 && reported.count(p.instrument) == 0) {
+            adopt(p.instrument, 0.0, 0.0);
+        }
+    }
+}
+
+/**
+ * @brief Subscribes to a WebSocket channel.
+ *
+ * @param channel The name of the channel to subscribe to.
+ */
+void webSocketClient::subscribe(const std::string& channel) {
+    subscribe(std::vector<std::string>{channel});
+}
+
+/**
+ * @brief Unsubscribes from a WebSocket channel.
  *
- * @param message The message to send.
+ * @param channel The name of the channel to unsubscribe from.
  */
-void webSocketClient::send(const std::string& message) {
-    websocketpp::lib::error_code ec;
-    m_endpoint.send(m_hdl, message, websocketpp::frame::opcode::text, ec);
-    if (ec) {
-        fmt::print(stderr, "Send error: {}\n", ec.message());
-    }
+void webSocketClient::unsubscribe(const std::string& channel) {
+    unsubscribe(std::vector<std::string>{channel});
 }
 
 /**
- * @brief Connects to a WebSocket server.
+ * @brief Subscribes to several WebSocket channels in as few requests as possible.
  *
- * @param uri The URI of the WebSocket server to connect to.
+ * @param channels The names of the channels to subscribe to.
+ * @param owner The party that wants them.
  */
-void webSocketClient::connect(const std::string& uri) {
-    websocketpp::lib::error_code ec;
-    client::connection_ptr con = m_endpoint.get_connection(uri, ec);
-    if (ec) {
-        fmt::print(stderr, "Connection error: {}\n", ec.message());
-        return;
-    }
-
-    m_endpoint.connect(con);
-    m_eventLoopThread = std::thread([this]() { m_endpoint.run(); });
+void webSocketClient::subscribe(const std::vector<std::string>& channels, subscriptionOwner owner) {
+    m_subscriptions.add(channels, owner);
+    scheduleSync();
 }
 
 /**
- * @brief Closes the WebSocket connection.
+ * @brief Unsubscribes from several WebSocket channels in as few requests as possible.
+ *
+ * Channels another owner still wants stay subscribed.
+ *
+ * @param channels The names of the channels to unsubscribe from.
+ * @param owner The party releasing them.
  */
-void webSocketClient::close() {
-    if (m_connected) {
-        websocketpp::lib::error_code ec;
-        m_endpoint.close(m_hdl, websocketpp::close::status::normal, "Closing Connection", ec);
-        if (ec) {
-            fmt::print(stderr, "Close error: {}\n", ec.message());
-            return;
-        }
-        m_connected = false;
-    }
-    m_endpoint.stop_perpetual();
-    m_endpoint.stop();
-
-    if (m_eventLoopThread.joinable()) {
-        m_eventLoopThread.join();
-    }
+void webSocketClient::unsubscribe(const std::vector<std::string>& channels, subscriptionOwner owner) {
+    m_subscriptions.remove(channels, owner);
+    scheduleSync();
 }
 
 /**
- * @brief Handles the WebSocket connection open event.
+ * @brief Gets the subscription manager.
  *
- * @param c Pointer to the WebSocket client.
- * @param hdl The connection handle.
+ * @return subscriptionManager& The desired and acknowledged subscriptions.
  */
-void webSocketClient::on_open(client* c, websocketpp::connection_hdl hdl) {
-    fmt::print("Connection opened!\n");
-    m_hdl = hdl;
-    m_connected = true;
-    if (m_authRequestCallback) {
-        m_authRequestCallback();
-    }
+subscriptionManager& webSocketClient::getSubscriptions() {
+    return m_subscriptions;
 }
 
 /**
- * @brief Handles the WebSocket connection fail event.
+ * @brief Pins an instrument's channels to raw, or releases the pin.
  *
- * @param c Pointer to the WebSocket client.
- * @param hdl The connection handle.
+ * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+ * @param pinned True to pin, false to release.
  */
-void webSocketClient::on_fail(client* c, websocketpp::connection_hdl hdl) {
-    fmt::print(stderr, "Connection failed!\n");
-    m_connected = false;
+void webSocketClient::pinInstrument(const std::string& instrument, bool pinned) {
+    m_subscriptions.setPinned(instrument, pinned);
+    scheduleSync();
 }
 
 /**
- * @brief Handles the WebSocket connection close event.
+ * @brief Queues a syncSubscriptions call on the event loop.
  *
- * @param c Pointer to the WebSocket client.
- * @param hdl The connection handle.
+ * Subscriptions change from the console thread as well as from the event loop; the
+ * sync itself always runs on the loop. Requests made before it runs are coalesced.
  */
-void webSocketClient::on_close(client* c, websocketpp::connection_hdl hdl) {
-    fmt::print("Connection closed!\n");
-    m_connected = false;
+void webSocketClient::scheduleSync() {
+    if (!m_syncScheduled.exchange(true)) {
+        m_timers.schedule(0, static_cast<uint32_t>(timerKind::subscriptionSync), 0);
+    }
 }
 
 /**
- * @brief Subscribes to a WebSocket channel.
+ * @brief Sends the batches that bring the exchange's subscriptions to the desired set.
  *
- * @param channel The name of the channel to subscribe to.
+ * Channels already in flight are left alone, so calling this repeatedly is cheap. Event
+ * loop only: it updates m_lastData, which on_message reads.
  */
-void webSocketClient::subscribe(const std::string& channel) {
-    std::string subscribeRequest = deriapi::subscribeToChannel(channel);
-    send(subscribeRequest);
-    m_subscribedChannels.insert(channel);
-    m_lastData[channel] = ""; 
+void webSocketClient::syncSubscriptions() {
+    if (!m_connected) {
+        return; // Channels added before connecting are sent when the connection opens
+    }
+    std::vector<subscriptionBatch> batches;
+    m_subscriptions.plan(batches);
+    for (const subscriptionBatch& batch : batches) {
+        if (batch.subscribe) {
+            for (const std::string& channel : batch.channels) {
+                m_lastData[channel] = "";
+            }
+            send(deriapi::subscribeToChannels(batch.channels, batch.isPrivate, batch.requestId));
+        } else {
+            for (const std::string& channel : batch.channels) {
+                m_lastData.erase(channel);
+            }
+            send(deriapi::unsubscribeFromChannels(batch.channels, batch.isPrivate, batch.requestId));
+        }
+    }
 }
 
 /**
- * @brief Unsubscribes from a WebSocket channel.
+ * @brief Handles the response to a subscription batch.
  *
- * @param channel The name of the channel to unsubscribe from.
+ * @param requestId The JSON-RPC request ID of the response.
+ * @param response The full JSON response.
  */
-void webSocketClient::unsubscribe(const std::string& channel) {
-    fmt::print("Unsubscribed from channel: {}\n", channel);
-    std::string unsubscribeRequest = deriapi::unsubscribeFromChannel(channel);
-    send(unsubscribeRequest);
-    m_subscribedChannels.erase(channel);
-    m_lastData.erase(channel);    
-    fmt::print("Unsubscribed from channel: {}\n", channel);
+void webSocketClient::on_message_subscription(int requestId, const nlohmann::json& response) {
+    std::vector<std::string> rejected;
+    size_t acknowledged = m_subscriptions.onResponse(requestId, response, rejected);
+    if (response.contains("error")) {
+        fmt::print(stderr, "Subscription request failed: {}\n", response["error"].value("message", "Unknown error"));
+    }
+    if (acknowledged > 0) {
+        fmt::print("Subscription update acknowledged for {} channel(s).\n", acknowledged);
+    }
+    for (const std::string& channel : rejected) {
+        fmt::print(stderr, "Channel not acknowledged: {}\n", channel);
+    }
+    if (!m_startup.reached(startupStage::subscribed)) {
+        std::vector<channelStatus> channels = m_subscriptions.list();
+        bool settled = std::all_of(channels.begin(), channels.end(), [](const channelStatus& status) {
+            return !status.desired || status.state == channelState::subscribed;
+        });
+        if (settled && !channels.empty()) {
+            m_startup.mark(startupStage::subscribed);
+        }
+    }
+    checkStartup();
 }
 
 /**
@@ -184,32 +1363,82 @@ void webSocketClient::unsubscribe(const std::string& channel) {
  */
 void webSocketClient::handleSubscriptionMessage(const std::string& channel, const nlohmann::json& data) {
     try {
-        if (channel.find("ticker") != std::string::npos) {
+        int64_t receivedNs = tscClock::instance().nowNs();
+        // Channels only the gateway asked for still feed local state, but are not printed or written out
+        bool gatewayOnly = m_subscriptions.isWantedBy(channel, subscriptionOwner::gateway) &&
+                           !m_subscriptions.isWantedBy(channel, subscriptionOwner::console);
+        auto output = [&](streamKind kind) {
+            if (gatewayOnly) {
+                return;
+            }
+            channelEvent event;
+            event.channel = channel;
+            event.data = data;
+            event.receiveTimestampNs = receivedNs;
+            if (m_ndjson && !m_events.empty()) {
+                // NDJSON formats the events publishMarketData just decoded; their definitions travel
+                // along, since conflation may drop the event that first defined an instrument
+                m_normalizer.definitionsFor(m_events, event.events);
+                event.events += m_events;
+            }
+            m_output.push(kind, std::move(event));
+        };
+        if (channel.rfind("user.orders", 0) == 0) {
+            // Handle order updates; "raw" channels send one order, aggregated ones an array
+            if (data.is_array()) {
+                for (const auto& update : data) {
+                    m_orders.onOrderUpdate(update);
+                }
+            } else {
+                m_orders.onOrderUpdate(data);
+            }
+            output(streamKind::sequence);
+        } else if (channel.rfind("user.trades", 0) == 0) {
+            // Handle own fills
+            applyTrades(data, true);
+        } else if (channel.find("ticker") != std::string::npos) {
             // Handle ticker data
             if (data.is_object()) {
-                fmt::print("Ticker Update ({}): {}\n", channel, data.dump(2));
+                m_tickers.onTicker(data);
+                if (data.contains("instrument_name") && data.contains("mark_price") && data["mark_price"].is_number()) {
+                    m_risk.onMarkPrice(data["instrument_name"].get<std::string>(), data["mark_price"].get<double>());
+                }
+                if (data.contains("instrument_name") && data.contains("last_price") && data["last_price"].is_number()) {
+                    evaluateTriggers(data["instrument_name"].get<std::string>(), data["last_price"].get<double>());
+                }
+                if (data.contains("instrument_name") && data.contains("best_bid_price") && data["best_bid_price"].is_number() &&
+                    data.contains("best_ask_price") && data["best_ask_price"].is_number()) {
+                    std::vector<quoteAction> actions;
+                    m_quotes.onTopOfBook(data["instrument_name"].get<std::string>(), data["best_bid_price"].get<double>(),
+                                         data["best_ask_price"].get<double>(), actions);
+                    executeQuoteActions(actions);
+                }
+                output(streamKind::state);
             } else if (data.is_number() || data.is_string() || data.is_boolean()) {
-                fmt::print("Ticker Update ({}): {}\n", channel, data.dump(2));
+                output(streamKind::state);
             } else {
                 fmt::print(stderr, "Unexpected data type for ticker channel '{}'.\n", channel);
             }
         } else if (channel.find("trades") != std::string::npos) {
             // Handle trades data
             if (data.is_array()) {
-                fmt::print("Trade Update ({}): {}\n", channel, data.dump(2));
+                output(streamKind::sequence);
             } else {
                 fmt::print(stderr, "Unexpected data type for trades channel '{}'.\n", channel);
             }
         } else if (channel.find("book") != std::string::npos) {
             // Handle order book data
             if (data.is_object()) {
-                fmt::print("Order Book Update ({}): {}\n", channel, data.dump(2));
+                // Grouped books ("book.X.none.10.100ms") are snapshots; plain ones send deltas
+                bool snapshot = std::count(channel.begin(), channel.end(), '.') >= 4;
+                output(snapshot ? streamKind::state : streamKind::sequence);
             } else {
                 fmt::print(stderr, "Unexpected data type for book channel '{}'.\n", channel);
             }
         } else {
             // Handle other channels
-            fmt::print("Update ({}): {}\n", channel, data.dump(2));
+            bool topOfBook = channel.rfind("quote.", 0) == 0;
+            output(topOfBook ? streamKind::state : streamKind::sequence);
         }
     } catch (const nlohmann::json::exception& e) {
         fmt::print(stderr, "JSON Parsing Error in channel '{}': {}\n", channel, e.what());
@@ -217,12 +1446,306 @@ void webSocketClient::handleSubscriptionMessage(const std::string& channel, cons
 }
 
 /**
- * @brief Handles authentication success messages.
+ * @brief Normalizes a channel notification once and hands it to the shared-memory
+ *        publisher and the local gateway, if they are running.
+ *
+ * JSON is decoded into binary events (eventNormalizer) only while a consumer exists,
+ * the NDJSON writer included. A consumer started after instrument IDs were assigned
+ * first receives the directory. The events stay in m_events until the next notification,
+ * so handleSubscriptionMessage can pass them on to the output thread.
+ *
+ * @param channel The name of the channel.
+ * @param params The notification's "params" object.
+ * @param payload The notification exactly as received.
+ */
+void webSocketClient::publishMarketData(const std::string& channel, const nlohmann::json& params, const std::string& payload) {
+    std::shared_ptr<shmPublisher> publisher = std::atomic_load(&m_publisher);
+    std::shared_ptr<localGateway> gateway = std::atomic_load(&m_gateway);
+    m_events.clear();
+    if (!publisher && !gateway && !m_ndjson) {
+        return;
+    }
+    if (publisher && publisher.get() != m_seededPublisher) {
+        m_normalizer.definitions(m_events);
+        publisher->publish(m_events.data(), m_events.size());
+        m_seededPublisher = publisher.get();
+        m_events.clear();
+    }
+    if (gateway && gateway.get() != m_seededGateway) {
+        m_normalizer.definitions(m_events);
+        gateway->addDefinitions(m_events.data(), m_events.size());
+        m_seededGateway = gateway.get();
+        m_events.clear();
+    }
+
+    auto data = params.find("data");
+    if (data != params.end() && channel.rfind("user.", 0) != 0) {
+        m_normalizer.normalize(channel, *data, tscClock::instance().nowNs(), m_events);
+    }
+    if (publisher && !m_events.empty()) {
+        publisher->publish(m_events.data(), m_events.size());
+    }
+    if (gateway) {
+        gateway->publish(channel, payload, m_events.data(), m_events.size());
+    }
+}
+
+/**
+ * @brief Starts publishing normalized binary events into shared memory.
+ *
+ * @param name The shm_open name of the region.
+ * @return True if the region was created, false if it failed or a publisher is already running.
+ */
+bool webSocketClient::startPublisher(const std::string& name) {
+    // A second region under the same name would be unlinked by the first one's destructor
+    if (std::atomic_load(&m_publisher)) {
+        fmt::print(stderr, "Shared-memory publisher is already running.\n");
+        return false;
+    }
+    try {
+        std::atomic_store(&m_publisher, std::make_shared<shmPublisher>(name));
+    } catch (const std::runtime_error& e) {
+        fmt::print(stderr, "Failed to start shared-memory publisher: {}\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Starts the local WebSocket fan-out gateway.
+ *
+ * Channels requested downstream are subscribed upstream with the gateway as their owner,
+ * so they stay subscribed while the console wants them too. The event loop is started
+ * if the client has not connected yet, so the gateway accepts connections at once.
+ *
+ * @param port The TCP port to listen on (loopback only).
+ * @return True if the gateway is listening.
+ */
+bool webSocketClient::startGateway(uint16_t port) {
+    if (std::atomic_load(&m_gateway)) {
+        fmt::print(stderr, "Gateway is already running.\n");
+        return false;
+    }
+    // The gateway counts its own downstream subscribers; upstream it is one owner beside the console
+    auto acquire = [this](const std::vector<std::string>& channels) { subscribe(channels, subscriptionOwner::gateway); };
+    auto release = [this](const std::vector<std::string>& channels) { unsubscribe(channels, subscriptionOwner::gateway); };
+    auto gateway = std::make_shared<localGateway>(m_endpoint.get_io_service(), acquire, release);
+    if (!gateway->start(port)) {
+        return false;
+    }
+    std::atomic_store(&m_gateway, gateway);
+    startEventLoop();
+    return true;
+}
+
+/**
+ * @brief Gets the counters of the local gateway.
+ *
+ * @return gatewayStats The counters; all zero if the gateway is not running.
+ */
+gatewayStats webSocketClient::getGatewayStats() const {
+    std::shared_ptr<localGateway> gateway = std::atomic_load(&m_gateway);
+    return gateway ? gateway->stats() : gatewayStats();
+}
+
+/**
+ * @brief Checks whether the local gateway is running.
+ *
+ * @return True if the gateway is listening.
+ */
+bool webSocketClient::isGatewayRunning() const {
+    return std::atomic_load(&m_gateway) != nullptr;
+}
+
+/**
+ * @brief Gets the number of events published into shared memory.
+ *
+ * @return uint64_t The count, or 0 if the publisher is not running.
+ */
+uint64_t webSocketClient::publishedEvents() const {
+    std::shared_ptr<shmPublisher> publisher = std::atomic_load(&m_publisher);
+    return publisher ? publisher->published() : 0;
+}
+
+/**
+ * @brief Runs the output thread: prints channel events taken from the output queue.
+ */
+void webSocketClient::runOutput() {
+    channelEvent event;
+    while (m_output.pop(event)) {
+        if (m_ndjson) {
+            // Batch lines while events are queued; write out as soon as the queue drains
+            m_ndjson->write(event);
+            if (m_output.stats().depth == 0) {
+                m_ndjson->flush();
+            }
+        } else {
+            printEvent(event);
+        }
+    }
+}
+
+/**
+ * @brief Switches channel output from human-readable prints to NDJSON.
+ *
+ * @param fd The file descriptor to write to.
+ * @param fields Comma-separated keys to write, or empty for all keys.
+ * @throws std::runtime_error If a field name is unknown.
+ */
+void webSocketClient::enableNdjson(int fd, const std::string& fields) {
+    m_ndjson = std::make_unique<ndjsonWriter>(fd, fields);
+}
+
+/**
+ * @brief Prints one channel event.
+ *
+ * @param event The event.
+ */
+void webSocketClient::printEvent(const channelEvent& event) {
+    const std::string& channel = event.channel;
+    if (channel.rfind("user.orders", 0) == 0) {
+        fmt::print("Order Update ({}): {}\n", channel, event.data.dump(2));
+    } else if (channel.find("ticker") != std::string::npos) {
+        fmt::print("Ticker Update ({}): {}\n", channel, event.data.dump(2));
+    } else if (channel.find("trades") != std::string::npos) {
+        fmt::print("Trade Update ({}): {}\n", channel, event.data.dump(2));
+    } else if (channel.find("book") != std::string::npos) {
+        fmt::print("Order Book Update ({}): {}\n", channel, event.data.dump(2));
+    } else {
+        fmt::print("Update ({}): {}\n", channel, event.data.dump(2));
+    }
+}
+
+/**
+ * @brief Gets the counters of the queue feeding the output thread.
+ *
+ * @return conflationStats The counters.
+ */
+conflationStats webSocketClient::getOutputStats() const {
+    return m_output.stats();
+}
+
+/**
+ * @brief Requests the book summaries of every instrument of a currency.
+ *
+ * @param currency The currency (e.g., "BTC").
+ * @param kind The instrument kind (e.g., "option"); empty for all kinds.
+ */
+void webSocketClient::requestBookSummary(const std::string& currency, const std::string& kind) {
+    m_bookSummarySentNs = tscClock::instance().monotonicNs();
+    ++m_bookSummariesPending;
+    send(deriapi::getBookSummaryByCurrency(currency, kind, kBookSummaryRequestId));
+}
+
+/**
+ * @brief Checks whether book summary requests are still unanswered.
+ *
+ * @return True if a response is outstanding.
+ */
+bool webSocketClient::isBookSummaryPending() const {
+    return m_bookSummariesPending > 0;
+}
+
+/**
+ * @brief Gets the columnar store of the latest snapshot per instrument.
+ *
+ * @return const tickerStore& The store; safe to read from any thread.
+ */
+const tickerStore& webSocketClient::getTickers() const {
+    return m_tickers;
+}
+
+/**
+ * @brief Sets the currencies whose book summaries are fetched as soon as the connection opens.
+ *
+ * Must be called before connecting.
+ *
+ * @param currencies The currencies (e.g., "BTC", "ETH").
+ */
+void webSocketClient::setWarmupCurrencies(const std::vector<std::string>& currencies) {
+    m_warmupCurrencies = currencies;
+}
+
+/**
+ * @brief Gets the timeline of the startup stages.
+ *
+ * @return const startupTimeline& The timeline; safe to read from any thread.
+ */
+const startupTimeline& webSocketClient::getStartupTimeline() const {
+    return m_startup;
+}
+
+/**
+ * @brief Handles a get_book_summary_by_currency response.
+ *
+ * @param payload The raw response text; parsed as a stream, not into a document.
+ */
+void webSocketClient::on_message_book_summary(const std::string& payload) {
+    bookSummaryResult result = m_tickers.ingestBookSummary(payload);
+    if (m_bookSummariesPending > 0 && --m_bookSummariesPending == 0) {
+        m_startup.mark(startupStage::snapshotsLoaded);
+        checkStartup();
+    }
+    if (!result.ok) {
+        fmt::print(stderr, "Book summary request failed: {}\n", result.error);
+        return;
+    }
+    int64_t roundTripNs = tscClock::instance().monotonicNs() - m_bookSummarySentNs.load();
+    fmt::print("Book summary: {} instruments ({} KiB) decoded in {:.2f} ms, {:.1f} ms after the request.\n", result.rows,
+               payload.size() / 1024, result.parseNs / 1e6, roundTripNs / 1e6);
+}
+
+/**
+ * @brief Checks whether a raw message is the response to a request ID.
+ *
+ * Only the start of the message is searched, where Deribit puts "id".
+ *
+ * @param payload The raw message.
+ * @param requestId The request ID.
+ * @return True if the message answers the request.
+ */
+bool webSocketClient::isResponseTo(const std::string& payload, int requestId) {
+    std::string needle = "\"id\":" + std::to_string(requestId);
+    std::string_view head(payload.data(), std::min<size_t>(payload.size(), 64 + needle.size() + 1));
+    size_t position = head.find(needle);
+    if (position == std::string_view::npos || position + needle.size() >= head.size()) {
+        return false;
+    }
+    char next = head[position + needle.size()];
+    return next == ',' || next == '}';
+}
+
+/**
+ * @brief Sets up a newly authenticated session.
  *
- * @param result The JSON result containing authentication details.
+ * Enables cancel-on-disconnect and heartbeats, subscribes the private feeds, resolves
+ * orders left pending and reconciles positions.
  */
-void webSocketClient::on_message_auth(nlohmann::json result) {
+void webSocketClient::on_message_auth() {
     fmt::print("Authentication successful!\n");
+    m_startup.mark(startupStage::authenticated);
+
+    // Have the exchange cancel our orders if this connection drops
+    send(deriapi::enableCancelOnDisconnect("connection", kCancelOnDisconnectRequestId));
+
+    // Server heartbeats let a silent, dead connection be detected within two intervals
+    send(deriapi::setHeartbeat(kHeartbeatIntervalS, kHeartbeatRequestId));
+    if (!m_heartbeatScheduled.exchange(true)) {
+        m_timers.schedule(2L * kHeartbeatIntervalS * 1000, static_cast<uint32_t>(timerKind::heartbeat), 0);
+    }
+
+    // Private feeds keep the order manager and position tracker current
+    // Channels rejected before authentication (private ones) are retried here
+    m_subscriptions.add({"user.orders.any.any.raw", "user.trades.any.any.raw"});
+    syncSubscriptions();
+    // Orders left unacknowledged by a previous connection are resolved by label
+    for (const order& o : m_orders.pendingOrders()) {
+        queryOrderByLabel(o.clientId);
+    }
+    reconcilePositions();
+    if (!m_reconcileScheduled.exchange(true)) {
+        scheduleReconcile();
+    }
 }
 
 /**
@@ -294,6 +1817,9 @@ void webSocketClient::on_message_orderBook(nlohmann::json result) {
         fmt::print("Mark Price: {}\n", orderBook.value("mark_price", 0.0));       // Number
         fmt::print("Open Interest: {}\n", orderBook.value("open_interest", 0.0)); // Number
         fmt::print("Funding Rate (8h): {}\n", orderBook.value("funding_8h", 0.0)); // Number
+        if (orderBook.contains("instrument_name") && orderBook.contains("mark_price") && orderBook["mark_price"].is_number()) {
+            m_risk.onMarkPrice(orderBook["instrument_name"].get<std::string>(), orderBook["mark_price"].get<double>());
+        }
 
         // Handle bids
         fmt::print("\nBids:\n");
@@ -348,6 +1874,9 @@ void webSocketClient::on_message_positions(nlohmann::json result) {
     }
     fmt::print("\nCurrent Positions:\n");
     for (const auto& position : result) {
+        if (position.contains("instrument_name") && position.contains("size") && position["size"].is_number()) {
+            m_risk.onPosition(position["instrument_name"].get<std::string>(), position["size"].get<double>());
+        }
         fmt::print("Instrument: {}\n", position.value("instrument_name", "N/A"));
         fmt::print("Size: {}\n", position.value("size", 0.0));
         fmt::print("Direction: {}\n", position.value("direction", "N/A"));
@@ -367,6 +1896,63 @@ void webSocketClient::on_message_positions(nlohmann::json result) {
 
 
 
+/**
+ * @brief Handles responses to requests sent for a tracked order.
+ *
+ * @param requestId The JSON-RPC request ID of the response.
+ * @param response The full JSON response.
+ * @return True if the response belonged to a tracked order request.
+ */
+bool webSocketClient::on_message_order(int requestId, const nlohmann::json& response) {
+    int capacity = static_cast<int>(m_orders.capacity());
+    if (requestId >= kLabelRequestBase && requestId < kLabelRequestBase + capacity) {
+        on_message_label(static_cast<uint32_t>(requestId - kLabelRequestBase), response);
+        return true;
+    }
+    bool isNew = requestId >= kOrderRequestBase && requestId < kOrderRequestBase + capacity;
+    bool isCancel = requestId >= kCancelRequestBase && requestId < kCancelRequestBase + capacity;
+    bool isEdit = requestId >= kEditRequestBase && requestId < kEditRequestBase + capacity;
+    if (!isNew && !isCancel && !isEdit) {
+        return false;
+    }
+    uint32_t clientId = static_cast<uint32_t>(requestId % kOrderRequestBase);
+
+    if (response.contains("error")) {
+        fmt::print(stderr, "Error: {}\n", response["error"].value("message", "Unknown error"));
+        if (response["error"].value("code", 0) == 10028) {
+            m_rateLimiter.onRateLimited(creditPool::matching);
+        }
+        if (isNew) {
+            m_orders.onReject(clientId);
+        }
+    } else if (isNew && response.contains("result") && response["result"].contains("order")) {
+        m_orders.onOrderUpdate(response["result"]["order"], clientId);
+        if (response["result"].contains("trades")) {
+            applyTrades(response["result"]["trades"], false);
+        }
+        on_message_buy(response["result"]["order"]);
+    } else if (isCancel && response.contains("result")) {
+        m_orders.onOrderUpdate(response["result"], clientId);
+        on_message_cancel(response["result"]);
+    } else if (isEdit && response.contains("result") && response["result"].contains("order")) {
+        m_orders.onOrderUpdate(response["result"]["order"], clientId);
+        if (response["result"].contains("trades")) {
+            applyTrades(response["result"]["trades"], false);
+        }
+        on_message_modify(response["result"]["order"]);
+    }
+
+    // Once an edit resolves, send the latest edit that was coalesced behind it
+    orderEdit next;
+    if (isEdit) {
+        m_timers.cancel(m_editTimers[clientId].exchange(timerWheel::kNoTimer));
+    }
+    if (isEdit && m_orders.completeEdit(clientId, next)) {
+        sendEdit(clientId, next);
+    }
+    return true;
+}
+
 /**
  * @brief Handles incoming WebSocket messages.
  *
@@ -376,7 +1962,50 @@ void webSocketClient::on_message_positions(nlohmann::json result) {
  */
 void webSocketClient::on_message(client* c, websocketpp::connection_hdl hdl, client::message_ptr msg) {
     try {
+        int64_t startNs = tscClock::instance().monotonicNs();
+        m_lastMessageMs = steadyMs();
+        if (m_bookSummariesPending.load(std::memory_order_relaxed) > 0 && isResponseTo(msg->get_payload(), kBookSummaryRequestId)) {
+            // Thousands of entries: stream them into the ticker store instead of building a document
+            on_message_book_summary(msg->get_payload());
+            return;
+        }
         nlohmann::json response = nlohmann::json::parse(msg->get_payload());
+        if (response.contains("method") && response["method"] == "heartbeat") {
+            if (response.contains("params") && response["params"].value("type", "") == "test_request") {
+                send(deriapi::test(kTestRequestId));
+            }
+            return;
+        }
+        if (response.contains("id") && (response["id"] == kHeartbeatRequestId || response["id"] == kTestRequestId)) {
+            return;
+        }
+        if (response.contains("id") && response["id"] == kRefreshRequestId) {
+            on_message_refresh(response);
+            return;
+        }
+        if (response.contains("id") && response["id"].is_number_integer() &&
+            subscriptionManager::isBatchRequest(response["id"].get<int>())) {
+            on_message_subscription(response["id"].get<int>(), response);
+            return;
+        }
+        if (response.contains("id") && response["id"].is_number_integer() &&
+            on_message_order(response["id"].get<int>(), response)) {
+            return;
+        }
+        if (response.contains("id") && response["id"] == kReconcileRequestId && response.contains("result")) {
+            on_message_reconcile(response["result"]);
+            return;
+        }
+        if (response.contains("id") && response["id"] == kCancelOnDisconnectRequestId && response.contains("result")) {
+            fmt::print("Cancel-on-disconnect enabled.\n");
+            m_startup.mark(startupStage::cancelOnDisconnect);
+            checkStartup();
+            return;
+        }
+        if (response.contains("id") && response["id"] == kKillRequestId && response.contains("result")) {
+            fmt::print(stderr, "Kill switch: {} order(s) cancelled.\n", response["result"].dump());
+            return;
+        }
         if (response.contains("method") && response["method"] == "subscription") {
             if (response.contains("params") && response["params"].is_object()) {
                 std::string channel;
@@ -391,6 +2020,11 @@ void webSocketClient::on_message(client* c, websocketpp::connection_hdl hdl, cli
                     }
                 }
 
+                m_startup.mark(startupStage::firstMarketData);
+
+                // Local consumers get every frame, decoded once into binary events
+                publishMarketData(channel, response["params"], msg->get_payload());
+
                 if (m_lastData.find(channel) == m_lastData.end()) {
                     fmt::print("Unsubscribed successfully from channel.\n");
                     return; // Channel is unsubscribed, ignore this message
@@ -425,12 +2059,20 @@ void webSocketClient::on_message(client* c, websocketpp::connection_hdl hdl, cli
                 } else {
                     fmt::print(stderr, "No data field found in channel '{}'.\n", channel);
                 }
+                // Decode cost per channel drives the interval downgrades under load
+                m_subscriptions.recordCost(channel, tscClock::instance().monotonicNs() - startNs);
             }
         } else if (response.contains("result")) {
             if (response["result"].contains("access_token")) {
-                m_accessToken = response["result"]["access_token"];
-                on_message_auth(response["result"]);
-                m_authenticated = true;
+                onTokens(response["result"]);
+                if (m_reauthorizing) {
+                    // The session is already set up; only the refused token had to be replaced
+                    m_reauthorizing = false;
+                    fmt::print("Access token replaced by a new authorization.\n");
+                } else {
+                    on_message_auth();
+                    m_authenticated = true;
+                }
             } else if (response["result"].contains("balance")) {
                 on_message_summary(response["result"]);
             } else if (response["result"].contains("order")) {
@@ -445,6 +2087,13 @@ void webSocketClient::on_message(client* c, websocketpp::connection_hdl hdl, cli
                 on_message_positions(response["result"]);
             } 
         } else if (response.contains("error")) {
+            if (response["error"].value("code", 0) == 10028) {
+                // too_many_requests: drain the local pool so we back off until it refills
+                m_rateLimiter.onRateLimited(creditPool::nonMatching);
+            }
+            if (response.contains("id") && response["id"] == 1) {
+                m_authFailed = true;
+            }
             fmt::print(stderr, "Error: {}\n", response["error"].value("message", "Unknown error"));
         }
     } catch (const nlohmann::json::exception& e) {
@@ -461,6 +2110,15 @@ bool webSocketClient::isAuthenticated() const {
     return m_authenticated;
 }
 
+/**
+ * @brief Checks if authentication failed, timed out or the connection could not be opened.
+ *
+ * @return True if waiting for authentication is pointless.
+ */
+bool webSocketClient::hasAuthFailed() const {
+    return m_authFailed;
+}
+
 /**
  * @brief Checks if the client is waiting for a response.
  *
@@ -473,8 +2131,10 @@ bool webSocketClient::isWaitingForResponse() const {
 /**
  * @brief Gets the access token.
  *
+ * Thread-safe; the token is swapped atomically when it is refreshed.
+ *
  * @return The access token as a string.
  */
 std::string webSocketClient::getAccessToken() const {
-    return m_accessToken;
+    return *std::atomic_load(&m_accessToken);
 }
\ No newline at end of file
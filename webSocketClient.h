@@ -22,6 +22,24 @@
 #include <set>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include "orderManager.h"
+#include "riskManager.h"
+#include "rateLimiter.h"
+#include "positionTracker.h"
+#include "triggerEngine.h"
+#include "quoteEngine.h"
+#include "timerWheel.h"
+#include "subscriptionManager.h"
+#include "conflatingQueue.h"
+#include "shmPublisher.h"
+#include "localGateway.h"
+#include "eventNormalizer.h"
+#include "ndjsonWriter.h"
+#include "tickerStore.h"
+#include "startupTimeline.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 using websocketpp::lib::placeholders::_1;
 using websocketpp::lib::placeholders::_2;
@@ -62,22 +80,238 @@ public:
     /**
      * @brief Sends a message through the WebSocket connection.
      *
+     * The message is charged to the non-matching credit pool of the rate limiter.
+     *
      * @param message The message to send.
      */
     void send(const std::string& message);
 
+    /**
+     * @brief Sends a message through the rate limiter.
+     *
+     * If the pool is out of credits the message is queued and sent from the event loop
+     * once credits refill, or dropped if the limiter is set to reject.
+     *
+     * @param message The message to send.
+     * @param pool The credit pool the request is charged to.
+     * @return True if the message was sent or queued, false if it was dropped.
+     */
+    bool send(std::string message, creditPool pool);
+
     /**
      * @brief Connects to a WebSocket server.
      *
+     * Returns at once; the TLS handshake runs on the event loop. When the connection
+     * opens, the authorization, the channels subscribed so far and the warm-up book
+     * summaries are all written before any response is awaited.
+     *
      * @param uri The URI of the WebSocket server to connect to.
      */
     void connect(const std::string& uri);
 
+    /**
+     * @brief Sends the authorization request on the open connection.
+     *
+     * Used when the client connected before credentials were known. The request is sent
+     * from the event loop.
+     */
+    void authenticate();
+
+    /**
+     * @brief Checks whether the connection is open.
+     *
+     * @return True if connected.
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Checks whether a connection attempt is still in progress.
+     *
+     * @return True between connect and the connection opening or failing.
+     */
+    bool isConnecting() const;
+
     /**
      * @brief Closes the WebSocket connection.
      */
     void close();
 
+    /**
+     * @brief Places an order and tracks it in the local order manager.
+     *
+     * The order must pass the pre-trade risk checks before it is sent. The JSON-RPC
+     * request ID encodes the client-side order ID, so the acknowledgement or rejection
+     * is matched to the order without searching.
+     *
+     * @param direction "buy" or "sell".
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param amount The order amount.
+     * @param orderType The type of order (e.g., "limit", "market", "stop_limit").
+     * @param price The price for limit or stop-limit orders.
+     * @param timeInForce The time-in-force for the order (e.g., "good_til_cancelled").
+     * @param label A custom label for the order; empty to have a unique label generated.
+     * @return uint32_t The client-side order ID, or orderManager::kInvalidId if the order was rejected locally.
+     */
+    uint32_t placeOrder(const std::string& direction, const std::string& instrument, int amount, const std::string& orderType, double price, const std::string& timeInForce, const std::string& label);
+
+    /**
+     * @brief Cancels an order by exchange order ID.
+     *
+     * @param orderId The exchange order ID.
+     */
+    void cancelOrder(const std::string& orderId);
+
+    /**
+     * @brief Edits an order, coalescing rapid re-prices.
+     *
+     * Only one edit per tracked order is in flight. Edits issued while one is pending
+     * overwrite the order's pending-edit slot, and only the latest is sent once the
+     * in-flight edit resolves. Orders unknown to the order manager are edited directly.
+     *
+     * @param orderId The exchange order ID.
+     * @param amount The new amount.
+     * @param price The new price.
+     * @param timeInForce The new time-in-force.
+     * @param postOnly [optional] Whether the order should be post-only (default: false).
+     * @param reduceOnly [optional] Whether the order should be reduce-only (default: false).
+     */
+    void modifyOrder(const std::string& orderId, int amount, double price, const std::string& timeInForce, bool postOnly = false, bool reduceOnly = false);
+
+    /**
+     * @brief Cancels every locally known open order on an instrument.
+     *
+     * @param instrument The instrument name.
+     * @return size_t The number of cancel requests sent.
+     */
+    size_t cancelAll(const std::string& instrument);
+
+    /**
+     * @brief Arms a client-side stop or take-profit order.
+     *
+     * Subscribes to the instrument's ticker if needed. When the ticker's last price crosses
+     * the level, the order is built and sent through placeOrder at that moment. Stops fire
+     * in the direction of the order (a buy stop fires from below); take-profits fire against it.
+     *
+     * @param isStop True for a stop, false for a take-profit.
+     * @param instrument The instrument name.
+     * @param direction "buy" or "sell".
+     * @param amount The order amount.
+     * @param level The trigger price.
+     * @param orderType "market" or "limit".
+     * @param price The limit price (ignored for market orders).
+     * @return uint32_t The trigger ID.
+     */
+    uint32_t addTrigger(bool isStop, const std::string& instrument, const std::string& direction, int amount, double level, const std::string& orderType, double price);
+
+    /**
+     * @brief Arms a stop and a take-profit order as a one-cancels-other pair.
+     *
+     * Subscribes to the instrument's ticker if needed.
+     *
+     * @param instrument The instrument name.
+     * @param direction "buy" or "sell".
+     * @param amount The order amount.
+     * @param stopLevel The trigger price of the stop.
+     * @param takeProfitLevel The trigger price of the take-profit.
+     * @param orderType "market" or "limit".
+     * @param price The limit price (ignored for market orders).
+     * @param stopId Receives the trigger ID of the stop.
+     * @param takeProfitId Receives the trigger ID of the take-profit.
+     */
+    void addOcoTriggers(const std::string& instrument, const std::string& direction, int amount, double stopLevel, double takeProfitLevel, const std::string& orderType, double price, uint32_t& stopId, uint32_t& takeProfitId);
+
+    /**
+     * @brief Starts two-sided quoting on an instrument.
+     *
+     * Subscribes to the instrument's ticker if needed; every top-of-book change is diffed
+     * against the live quotes and turned into new, edit or cancel requests.
+     *
+     * @param instrument The instrument name.
+     * @param config The quoting parameters.
+     */
+    void startQuoting(const std::string& instrument, const quoteConfig& config);
+
+    /**
+     * @brief Stops quoting an instrument and cancels its live quotes.
+     *
+     * @param instrument The instrument name.
+     */
+    void stopQuoting(const std::string& instrument);
+
+    /**
+     * @brief Gets the quoting engine.
+     *
+     * @return quoteEngine& The quoting engine.
+     */
+    quoteEngine& getQuoteEngine();
+
+    /**
+     * @brief Cancels an order once it has been working for a given time (client-side GTD).
+     *
+     * @param clientId The client-side ID returned by placeOrder.
+     * @param lifetimeMs The lifetime of the order in milliseconds.
+     */
+    void setOrderExpiry(uint32_t clientId, long lifetimeMs);
+
+    /**
+     * @brief Fires the kill switch.
+     *
+     * Sends a pre-serialized "private/cancel_all" (or "private/cancel_all_by_instrument")
+     * directly on the connection, bypassing the rate limiter queue. A global kill also
+     * drops queued matching-engine requests and blocks new orders until `rearm` is called.
+     * SIGUSR1 fires a global kill from the event loop.
+     *
+     * @param instrument [optional] The instrument to cancel; empty for all orders.
+     */
+    void killSwitch(const std::string& instrument = "");
+
+    /**
+     * @brief Allows new orders again after a global kill.
+     */
+    void rearm();
+
+    /**
+     * @brief Checks whether a global kill is in effect.
+     *
+     * @return True if new orders are blocked.
+     */
+    bool isKilled() const;
+
+    /**
+     * @brief Gets the local order manager.
+     *
+     * @return orderManager& The order manager.
+     */
+    orderManager& getOrderManager();
+
+    /**
+     * @brief Gets the pre-trade risk manager.
+     *
+     * @return riskManager& The risk manager.
+     */
+    riskManager& getRiskManager();
+
+    /**
+     * @brief Gets the client-side rate limiter.
+     *
+     * @return rateLimiter& The rate limiter.
+     */
+    rateLimiter& getRateLimiter();
+
+    /**
+     * @brief Gets the position tracker.
+     *
+     * @return positionTracker& The position tracker, updated from fills without a round-trip.
+     */
+    positionTracker& getPositionTracker();
+
+    /**
+     * @brief Gets the trigger engine.
+     *
+     * @return triggerEngine& The trigger engine.
+     */
+    triggerEngine& getTriggerEngine();
+
     /**
      * @brief Subscribes to a WebSocket channel.
      *
@@ -92,6 +326,138 @@ public:
      */
     void unsubscribe(const std::string& channel);
 
+    /**
+     * @brief Subscribes to several WebSocket channels in as few requests as possible.
+     *
+     * @param channels The names of the channels to subscribe to.
+     * @param owner [optional] The party that wants them.
+     */
+    void subscribe(const std::vector<std::string>& channels, subscriptionOwner owner = subscriptionOwner::console);
+
+    /**
+     * @brief Unsubscribes from several WebSocket channels in as few requests as possible.
+     *
+     * Channels another owner still wants stay subscribed.
+     *
+     * @param channels The names of the channels to unsubscribe from.
+     * @param owner [optional] The party releasing them.
+     */
+    void unsubscribe(const std::vector<std::string>& channels, subscriptionOwner owner = subscriptionOwner::console);
+
+    /**
+     * @brief Gets the subscription manager.
+     *
+     * @return subscriptionManager& The desired and acknowledged subscriptions.
+     */
+    subscriptionManager& getSubscriptions();
+
+    /**
+     * @brief Pins an instrument's channels to raw, or releases the pin.
+     *
+     * Unpinned raw book and ticker channels may be moved to 100ms while the event loop is
+     * saturated.
+     *
+     * @param instrument The instrument name (e.g., "BTC-PERPETUAL").
+     * @param pinned True to pin, false to release.
+     */
+    void pinInstrument(const std::string& instrument, bool pinned);
+
+    /**
+     * @brief Gets the counters of the queue feeding the output thread.
+     *
+     * @return conflationStats The counters.
+     */
+    conflationStats getOutputStats() const;
+
+    /**
+     * @brief Requests the book summaries of every instrument of a currency.
+     *
+     * The response is decoded straight into the ticker store (see getTickers).
+     *
+     * @param currency The currency (e.g., "BTC").
+     * @param kind The instrument kind (e.g., "option"); empty for all kinds.
+     */
+    void requestBookSummary(const std::string& currency, const std::string& kind = std::string());
+
+    /**
+     * @brief Checks whether book summary requests are still unanswered.
+     *
+     * @return True if a response is outstanding.
+     */
+    bool isBookSummaryPending() const;
+
+    /**
+     * @brief Gets the columnar store of the latest snapshot per instrument.
+     *
+     * @return const tickerStore& The store; safe to read from any thread.
+     */
+    const tickerStore& getTickers() const;
+
+    /**
+     * @brief Sets the currencies whose book summaries are fetched as soon as the connection opens.
+     *
+     * Must be called before connecting.
+     *
+     * @param currencies The currencies (e.g., "BTC", "ETH").
+     */
+    void setWarmupCurrencies(const std::vector<std::string>& currencies);
+
+    /**
+     * @brief Gets the timeline of the startup stages.
+     *
+     * @return const startupTimeline& The timeline; safe to read from any thread.
+     */
+    const startupTimeline& getStartupTimeline() const;
+
+    /**
+     * @brief Switches channel output from human-readable prints to NDJSON.
+     *
+     * Must be called before connecting; the output thread then writes one compact JSON
+     * object per normalized event per line.
+     *
+     * @param fd The file descriptor to write to.
+     * @param fields Comma-separated keys to write, or empty for all keys.
+     * @throws std::runtime_error If a field name is unknown.
+     */
+    void enableNdjson(int fd, const std::string& fields = std::string());
+
+    /**
+     * @brief Starts publishing normalized binary events into shared memory.
+     *
+     * @param name The shm_open name of the region.
+     * @return True if the region was created, false if it failed or a publisher is already running.
+     */
+    bool startPublisher(const std::string& name = shmPublisher::kDefaultName);
+
+    /**
+     * @brief Gets the number of events published into shared memory.
+     *
+     * @return uint64_t The count, or 0 if the publisher is not running.
+     */
+    uint64_t publishedEvents() const;
+
+    /**
+     * @brief Starts the local WebSocket fan-out gateway.
+     *
+     * @param port The TCP port to listen on (loopback only).
+     * @return True if the gateway is listening.
+     */
+    bool startGateway(uint16_t port);
+
+    /**
+     * @brief Gets the counters of the local gateway.
+     *
+     * @return gatewayStats The counters; all zero if the gateway is not running.
+     */
+    gatewayStats getGatewayStats() const;
+
+    /**
+     * @brief Checks whether the local gateway is running.
+     *
+     * @return True if the gateway is listening.
+     */
+    bool isGatewayRunning() const;
+
     /**
      * @brief Checks if the client is authenticated.
      *
@@ -99,6 +465,13 @@ public:
      */
     bool isAuthenticated() const;
 
+    /**
+     * @brief Checks if authentication failed, timed out or the connection could not be opened.
+     *
+     * @return True if waiting for authentication is pointless.
+     */
+    bool hasAuthFailed() const;
+
     /**
      * @brief Checks if the client is waiting for a response.
      *
@@ -109,6 +482,8 @@ public:
     /**
      * @brief Gets the access token.
      *
+     * Thread-safe; the token is swapped atomically when it is refreshed.
+     *
      * @return The access token as a string.
      */
     std::string getAccessToken() const;
@@ -156,11 +531,31 @@ private:
     void handleSubscriptionMessage(const std::string& channel, const nlohmann::json& data);
 
     /**
-     * @brief Handles authentication success messages.
+     * @brief Normalizes a channel notification once and hands it to the shared-memory
+     *        publisher and the local gateway, if they are running.
      *
-     * @param result The JSON result containing authentication details.
+     * @param channel The name of the channel.
+     * @param params The notification's "params" object.
+     * @param payload The notification exactly as received.
+     */
+    void publishMarketData(const std::string& channel, const nlohmann::json& params, const std::string& payload);
+
+    /**
+     * @brief Runs the output thread: prints channel events taken from the output queue.
+     */
+    void runOutput();
+
+    /**
+     * @brief Prints one channel event.
+     *
+     * @param event The event.
      */
-    void on_message_auth(nlohmann::json result);
+    void printEvent(const channelEvent& event);
+
+    /**
+     * @brief Sets up a newly authenticated session.
+     */
+    void on_message_auth();
 
     /**
      * @brief Handles account summary messages.
@@ -204,7 +599,269 @@ private:
      */
     void on_message_positions(nlohmann::json result);
 
-   
+    /**
+     * @brief Handles responses to requests sent for a tracked order.
+     *
+     * @param requestId The JSON-RPC request ID of the response.
+     * @param response The full JSON response.
+     * @return True if the response belonged to a tracked order request.
+     */
+    bool on_message_order(int requestId, const nlohmann::json& response);
+
+    /**
+     * @brief Submits a message to the rate limiter and sends it if it has credits.
+     *
+     * @param message The message to send.
+     * @param pool The credit pool the request is charged to.
+     * @return admission Whether the message was sent, queued or dropped.
+     */
+    admission submit(std::string message, creditPool pool);
+
+    /**
+     * @brief Writes a message to the connection, bypassing the rate limiter.
+     *
+     * @param message The message to send.
+     */
+    void sendNow(const std::string& message);
+
+    /**
+     * @brief Gets the client-side ID of a new-order request.
+     *
+     * @param request The serialized request.
+     * @return uint32_t The client-side ID, or orderManager::kInvalidId for other requests.
+     */
+    uint32_t orderIdOf(const std::string& request) const;
+
+    /**
+     * @brief Sends queued messages that have credits and re-arms the drain timer if needed.
+     */
+    void drainQueued();
+
+    /**
+     * @brief Sends the in-flight edit of a tracked order.
+     *
+     * @param clientId The client-side ID of the order.
+     * @param edit The target parameters.
+     */
+    void sendEdit(uint32_t clientId, const orderEdit& edit);
+
+    /**
+     * @brief Applies fills to the position tracker and the risk gate.
+     *
+     * @param trades A trade object or an array of trade objects.
+     * @param print Whether to print one line per applied fill.
+     */
+    void applyTrades(const nlohmann::json& trades, bool print);
+
+    /**
+     * @brief Requests all positions for reconciliation against the local tracker.
+     */
+    void reconcilePositions();
+
+    /**
+     * @brief Arms the periodic position reconciliation timer.
+     */
+    void scheduleReconcile();
+
+    /**
+     * @brief Sends the batches that bring the exchange's subscriptions to the desired set.
+     *
+     * Event loop only: it updates m_lastData, which on_message reads.
+     */
+    void syncSubscriptions();
+
+    /**
+     * @brief Queues a syncSubscriptions call on the event loop.
+     */
+    void scheduleSync();
+
+    /**
+     * @brief Handles the response to a subscription batch.
+     *
+     * @param requestId The JSON-RPC request ID of the response.
+     * @param response The full JSON response.
+     */
+    void on_message_subscription(int requestId, const nlohmann::json& response);
+
+    /**
+     * @brief Handles the response of a reconciliation request.
+     *
+     * @param result The JSON array of exchange positions.
+     */
+    void on_message_reconcile(const nlohmann::json& result);
+
+    /**
+     * @brief Handles a get_book_summary_by_currency response.
+     *
+     * @param payload The raw response text; parsed as a stream, not into a document.
+     */
+    void on_message_book_summary(const std::string& payload);
+
+    /**
+     * @brief Checks whether a raw message is the response to a request ID.
+     *
+     * Only the start of the message is searched, where Deribit puts "id".
+     *
+     * @param payload The raw message.
+     * @param requestId The request ID.
+     * @return True if the message answers the request.
+     */
+    static bool isResponseTo(const std::string& payload, int requestId);
+
+    /**
+     * @brief Builds an unarmed stop or take-profit trigger with a fresh ID.
+     *
+     * @param isStop True for a stop, false for a take-profit.
+     * @param instrument The instrument name.
+     * @param direction "buy" or "sell".
+     * @param amount The order amount.
+     * @param level The trigger price.
+     * @param orderType "market" or "limit".
+     * @param price The limit price (ignored for market orders).
+     * @return trigger The trigger.
+     */
+    trigger makeTrigger(bool isStop, const std::string& instrument, const std::string& direction, int amount, double level, const std::string& orderType, double price);
+
+    /**
+     * @brief Subscribes to the instrument's 100 ms ticker unless it is already wanted.
+     *
+     * @param instrument The instrument name.
+     */
+    void watchTicker(const std::string& instrument);
+
+    /**
+     * @brief Fires the triggers crossed by a new price.
+     *
+     * @param instrument The instrument name.
+     * @param price The new price.
+     */
+    void evaluateTriggers(const std::string& instrument, double price);
+
+    /**
+     * @brief Sends the requests produced by the quoting engine.
+     *
+     * @param actions The requests to send.
+     */
+    void executeQuoteActions(const std::vector<quoteAction>& actions);
+
+    /**
+     * @brief Arms the acknowledgement timeout of a pending order.
+     *
+     * @param clientId The client-side ID of the order.
+     */
+    void armOrderTimeout(uint32_t clientId);
+
+    /**
+     * @brief Asks the exchange whether an unacknowledged order exists, by its label.
+     *
+     * @param clientId The client-side ID of the order.
+     */
+    void queryOrderByLabel(uint32_t clientId);
+
+    /**
+     * @brief Resolves a pending order from a label query, resubmitting it if it never landed.
+     *
+     * @param clientId The client-side ID of the order.
+     * @param response The full JSON response.
+     */
+    void on_message_label(uint32_t clientId, const nlohmann::json& response);
+
+    /**
+     * @brief Kinds of timers kept in the timer wheel.
+     */
+    enum class timerKind : uint32_t {
+        drain,          ///< Send queued messages once credits are back.
+        orderTimeout,   ///< Order not acknowledged in time (arg: client-side ID).
+        orderExpiry,    ///< Client-side GTD expiry (arg: client-side ID).
+        editTimeout,    ///< Edit not answered in time (arg: client-side ID).
+        authTimeout,    ///< Authentication not answered in time.
+        heartbeat,      ///< Heartbeat deadline check.
+        reconcile,      ///< Periodic position reconciliation.
+        quoteRefresh,   ///< Periodic re-quote from the last top of book.
+        tokenRefresh,   ///< Access token refresh ahead of expiry.
+        clockCalibrate, ///< Periodic TSC clock recalibration.
+        loadCheck,      ///< End of an event-loop load window.
+        authRequest,    ///< Authorization requested from another thread.
+        subscriptionSync ///< Subscription changes to send, made on another thread.
+    };
+
+    /**
+     * @brief Advances the timer wheel on every event-loop tick.
+     */
+    void tickTimers();
+
+    /**
+     * @brief Dispatches an expired timer.
+     *
+     * @param kind The timer kind.
+     * @param arg The timer argument.
+     */
+    void onTimer(timerKind kind, uint64_t arg);
+
+    /**
+     * @brief Closes the connection if nothing was received within the heartbeat deadline.
+     */
+    void checkHeartbeat();
+
+    /**
+     * @brief Stores new tokens from an authentication result and schedules their refresh.
+     *
+     * @param result The result of a "public/auth" request.
+     */
+    void onTokens(const nlohmann::json& result);
+
+    /**
+     * @brief Handles the response of a token refresh.
+     *
+     * @param response The full JSON response.
+     */
+    void on_message_refresh(const nlohmann::json& response);
+
+    /**
+     * @brief Waits for the next kill signal on the event loop.
+     */
+    void armKillSignal();
+
+    /**
+     * @brief Starts the event-loop thread if it is not running yet.
+     */
+    void startEventLoop();
+
+    /**
+     * @brief Sends the authorization request and arms its timeout.
+     */
+    void requestAuthorization();
+
+    /**
+     * @brief Records the stages that depend on several events and, once, the tradeable state.
+     *
+     * Tradeable means authenticated, cancel-on-disconnect enabled, the private order feed
+     * acknowledged and the warm-up snapshots loaded. The timeline is printed when it is
+     * first reached.
+     */
+    void checkStartup();
+
+    static constexpr int kCancelOnDisconnectRequestId = 11; ///< Request ID of enable_cancel_on_disconnect.
+    static constexpr int kKillRequestId = 12; ///< Request ID of kill switch cancels.
+    static constexpr int kReconcileRequestId = 70; ///< Request ID of reconciliation get_positions requests.
+    static constexpr long kReconcileIntervalMs = 30000; ///< Interval between position reconciliations.
+    static constexpr int kOrderRequestBase = 1000000; ///< Request IDs of new orders: base + client-side ID.
+    static constexpr int kCancelRequestBase = 2000000; ///< Request IDs of cancels: base + client-side ID.
+    static constexpr int kEditRequestBase = 3000000; ///< Request IDs of edits: base + client-side ID.
+    static constexpr int kLabelRequestBase = 5000000; ///< Request IDs of label queries: base + client-side ID.
+    static constexpr int kHeartbeatRequestId = 14; ///< Request ID of set_heartbeat.
+    static constexpr int kTestRequestId = 15; ///< Request ID of heartbeat test replies.
+    static constexpr int kRefreshRequestId = 16; ///< Request ID of token refreshes.
+    static constexpr int kBookSummaryRequestId = 17; ///< Request ID of get_book_summary_by_currency.
+    static constexpr long kClockCalibrateMs = 60000; ///< Interval between TSC clock recalibrations.
+    static constexpr long kLoadCheckMs = 1000; ///< Length of an event-loop load window.
+    static constexpr long kTimerTickMs = 10; ///< Resolution of the timer wheel.
+    static constexpr long kAuthTimeoutMs = 10000; ///< Time authentication may take before it is reported as failed.
+    static constexpr int kHeartbeatIntervalS = 30; ///< Heartbeat interval requested from the server.
+    static constexpr long kQuoteRefreshMs = 250; ///< Interval between periodic re-quotes.
+    static constexpr long kOrderTimeoutMs = 5000; ///< Time an order may stay unacknowledged before its label is queried.
+    static constexpr long kEditTimeoutMs = 5000; ///< Time an edit may stay unanswered before the next one is let through.
+    static constexpr int kMaxOrderAttempts = 3; ///< Submissions of an order, including the first one.
 
     client m_endpoint; ///< The WebSocket endpoint.
     websocketpp::connection_hdl m_hdl; ///< The connection handle.
@@ -213,9 +870,53 @@ private:
     std::function<void()> m_authRequestCallback; ///< Callback function for authentication requests.
     bool m_authenticated; ///< Indicates whether the client is authenticated.
     bool m_waitingForResponse; ///< Indicates whether the client is waiting for a response.
-    std::string m_accessToken; ///< The access token for authenticated sessions.
+    std::shared_ptr<const std::string> m_accessToken; ///< The access token, swapped atomically on refresh.
+    std::string m_refreshToken; ///< The refresh token; only touched on the event loop.
+    timerWheel::timerId m_refreshTimer; ///< Pending token refresh; only touched on the event loop.
     std::map<std::string, std::string> m_lastData; ///< Stores the last received data for each channel.
-    std::set<std::string> m_subscribedChannels; ///< Stores the names of subscribed channels.
+    subscriptionManager m_subscriptions; ///< Desired channels and their acknowledgement state.
+    orderManager m_orders; ///< Tracks the lifecycle of every order.
+    riskManager m_risk; ///< Pre-trade risk gate for outgoing orders.
+    rateLimiter m_rateLimiter; ///< Client-side model of Deribit's credit pools.
+    std::atomic<bool> m_drainScheduled; ///< Whether a drain timer is pending for queued messages.
+    positionTracker m_positions; ///< Positions maintained incrementally from fills.
+    std::atomic<bool> m_reconcileScheduled; ///< Whether the reconciliation timer is armed.
+    std::atomic<bool> m_killed; ///< Whether a global kill blocks new orders.
+    std::string m_killAllRequest; ///< Pre-serialized cancel_all request.
+    std::map<std::string, std::string> m_killByInstrument; ///< Pre-serialized cancel_all_by_instrument requests.
+    std::mutex m_killMutex; ///< Guards m_killByInstrument.
+    std::mutex m_drainMutex; ///< Orders each drained write against setting m_killed.
+    std::unique_ptr<boost::asio::signal_set> m_killSignals; ///< Kill switch signals (SIGUSR1).
+    triggerEngine m_triggers; ///< Client-side conditional orders.
+    quoteEngine m_quotes; ///< Two-sided quoting engine.
+    timerWheel m_timers; ///< Request timeouts, deadlines, expiries and periodic jobs.
+    std::vector<std::atomic<timerWheel::timerId>> m_orderTimers; ///< Acknowledgement timeout per client-side ID.
+    std::vector<std::atomic<timerWheel::timerId>> m_expiryTimers; ///< GTD expiry per client-side ID.
+    std::vector<std::atomic<timerWheel::timerId>> m_editTimers; ///< In-flight edit timeout per client-side ID.
+    std::atomic<bool> m_authFailed; ///< Whether authentication failed or timed out.
+    bool m_reauthorizing; ///< Whether the pending authorization only replaces a token whose refresh was refused; event loop only.
+    std::atomic<long long> m_lastMessageMs; ///< Steady-clock time of the last received message.
+    std::atomic<bool> m_heartbeatScheduled; ///< Whether the heartbeat deadline timer is armed.
+    std::atomic<bool> m_quoteRefreshScheduled; ///< Whether the quote refresh timer is armed.
+    std::atomic<bool> m_syncScheduled; ///< Whether a subscription sync is queued on the event loop.
+    int64_t m_busyNs; ///< Time spent handling messages in the current load window; event loop only.
+    int64_t m_loadWindowStartNs; ///< Start of the current load window; event loop only.
+    conflatingQueue m_output; ///< Channel events waiting to be printed.
+    conflationStats m_lastOutputStats; ///< Output counters at the start of the load window; event loop only.
+    std::thread m_outputThread; ///< Prints channel events off the event loop.
+    tickerStore m_tickers; ///< Latest snapshot per instrument, from book summaries and tickers.
+    std::atomic<int> m_bookSummariesPending; ///< Unanswered book summary requests.
+    std::atomic<int64_t> m_bookSummarySentNs; ///< Monotonic time the last book summary request was sent.
+    std::vector<std::string> m_warmupCurrencies; ///< Currencies scanned when the connection opens; set before connecting.
+    startupTimeline m_startup; ///< When each startup stage was first reached.
+    std::atomic<bool> m_connecting; ///< Whether a connection attempt is in progress.
+    std::unique_ptr<ndjsonWriter> m_ndjson; ///< NDJSON writer used by the output thread; null for human-readable output.
+    std::shared_ptr<shmPublisher> m_publisher; ///< Shared-memory publisher, swapped atomically; null when off.
+    std::shared_ptr<localGateway> m_gateway; ///< Local fan-out gateway, swapped atomically; null when off.
+    eventNormalizer m_normalizer; ///< Binary event encoder shared by publisher, gateway and NDJSON output; event loop only.
+    std::string m_events; ///< Events of the current notification; event loop only.
+    const void* m_seededPublisher; ///< Publisher that has received the instrument directory; event loop only.
+    const void* m_seededGateway; ///< Gateway that has received the instrument directory; event loop only.
 };
 
 #endif // WEBSOCKETCLIENT_H
\ No newline at end of file